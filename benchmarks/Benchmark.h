@@ -0,0 +1,59 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#ifndef THREEPP_BENCHMARK_H
+#define THREEPP_BENCHMARK_H
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+namespace three {
+namespace benchmark {
+
+/**
+ * @return the average time of one run in milliseconds. fn is run once before timing starts
+ */
+inline double time(unsigned runs, const std::function<void()> &fn)
+{
+  fn();
+
+  auto start = std::chrono::steady_clock::now();
+  for(unsigned i=0; i<runs; i++) fn();
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+  return elapsed.count() / runs;
+}
+
+inline void report(const char *name, double reference, double optimized)
+{
+  std::printf("%-32s reference %10.3f ms  optimized %10.3f ms  speedup %6.2fx\n",
+              name, reference, optimized, optimized > 0 ? reference / optimized : 0.0);
+}
+
+/**
+ * count a failed check, printing a message
+ */
+class Checker
+{
+  unsigned _failures = 0;
+
+public:
+  void operator()(bool ok, const char *what)
+  {
+    if(!ok && _failures++ < 10) std::printf("MISMATCH: %s\n", what);
+  }
+
+  /** the process exit code */
+  int result() const
+  {
+    if(_failures) std::printf("%u mismatches\n", _failures);
+    return _failures ? 1 : 0;
+  }
+};
+
+}
+}
+
+#endif //THREEPP_BENCHMARK_H
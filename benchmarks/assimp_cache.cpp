@@ -0,0 +1,158 @@
+//
+// Created by byter on 23.10.26.
+//
+
+// compares loading a model through the Assimp importer with loading it from the scene cache
+// written by a previous import. The model is a generated OBJ file made up of many height grids
+
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <fstream>
+#include <QTemporaryDir>
+#include <threepp/core/BufferGeometry.h>
+#include <threepp/loader/Assimp.h>
+#include "Benchmark.h"
+
+using namespace three;
+
+namespace {
+
+const unsigned objects = 32, grid = 96;
+
+struct FileResource : public Resource
+{
+  std::ifstream stream;
+  size_t _size;
+
+  FileResource(const std::string &path, std::ios_base::openmode mode)
+     : stream(path, mode | std::ios::binary | std::ios::ate)
+  {
+    _size = (size_t)stream.tellg();
+    stream.seekg(0);
+  }
+
+  size_t size() override {return _size;}
+  std::istream &in() override {return stream;}
+};
+
+//resolves resources within a directory, caching scenes next to the model
+struct DirectoryLoader : public ResourceLoader
+{
+  const std::string dir;
+
+  explicit DirectoryLoader(const std::string &dir) : dir(dir) {}
+
+  bool exists(const char *path) override {
+    return std::ifstream(dir + "/" + path).good();
+  }
+
+  void load(QImage &image, const std::string &file) override {}
+
+  Resource::Ptr get(const char *path, std::ios_base::openmode mode) override {
+    return std::make_shared<FileResource>(dir + "/" + path, mode);
+  }
+
+  std::string cachePath(const char *path) override {
+    return dir + "/" + path + ".scenecache";
+  }
+};
+
+void writeModel(const std::string &path)
+{
+  std::ofstream out(path);
+
+  for(unsigned o=0; o<objects; o++) {
+    out << "o grid" << o << "\n";
+
+    for(unsigned y=0; y<=grid; y++) {
+      for(unsigned x=0; x<=grid; x++) {
+        float h = std::sin(x * 0.2f + o) * std::cos(y * 0.3f) * 0.5f;
+        out << "v " << (o % 8) * (grid + 2) + x << " " << h << " " << (o / 8) * (grid + 2) + y << "\n";
+      }
+    }
+
+    unsigned first = o * (grid + 1) * (grid + 1) + 1;
+    for(unsigned y=0; y<grid; y++) {
+      for(unsigned x=0; x<grid; x++) {
+        unsigned a = first + y * (grid + 1) + x, b = a + grid + 1;
+        out << "f " << a << " " << b << " " << b + 1 << " " << a + 1 << "\n";
+      }
+    }
+  }
+}
+
+Scene::Ptr load(const std::string &name, DirectoryLoader &resources, bool useSceneCache)
+{
+  loader::AssimpOptions options;
+  options.useSceneCache = useSceneCache;
+
+  loader::Assimp assimp(options);
+  assimp.load(name, resources);
+  return assimp.scene();
+}
+
+//the geometries of all meshes, in traversal order
+std::vector<BufferGeometry *> geometries(const Scene::Ptr &scene)
+{
+  std::vector<BufferGeometry *> result;
+  scene->traverse([&](Object3D &object) {
+    BufferGeometry *geometry = nullptr;
+    if(object.geometry()) geometry = object.geometry()->typer;
+    if(geometry) result.push_back(geometry);
+  });
+  return result;
+}
+
+template <typename T>
+bool equal(const typename BufferAttributeT<T>::Ptr &a, const typename BufferAttributeT<T>::Ptr &b)
+{
+  if(!a || !b) return !a && !b;
+
+  return a->size() == b->size() && std::equal(a->template data<T>(), a->template data<T>() + a->size(),
+                                              b->template data<T>());
+}
+
+}
+
+int main()
+{
+  QTemporaryDir dir;
+  if(!dir.isValid()) {
+    std::printf("cannot create a temporary directory\n");
+    return 1;
+  }
+
+  DirectoryLoader resources(dir.path().toStdString());
+  writeModel(resources.dir + "/model.obj");
+
+  Scene::Ptr imported, cached;
+
+  double cold = benchmark::time(3, [&]() {imported = load("model.obj", resources, false);});
+
+  //the first (untimed) run writes the cache
+  double warm = benchmark::time(3, [&]() {cached = load("model.obj", resources, true);});
+
+  benchmark::report("load model", cold, warm);
+
+  benchmark::Checker check;
+
+  //if the cache could not be written, every cached load was an import, and the timing is meaningless
+  std::ifstream cacheFile(resources.cachePath("model.obj"), std::ios::binary | std::ios::ate);
+  check(cacheFile.good() && cacheFile.tellg() > 0, "scene cache written");
+  if(cacheFile.good()) std::printf("scene cache: %lld bytes\n", (long long)cacheFile.tellg());
+
+  std::vector<BufferGeometry *> a = geometries(imported), b = geometries(cached);
+  check(a.size() == objects && a.size() == b.size(), "mesh count");
+
+  size_t vertices = 0;
+  for(size_t i=0; i<a.size() && i<b.size(); i++) {
+    check(equal<float>(a[i]->position(), b[i]->position()), "positions");
+    check(equal<float>(a[i]->normal(), b[i]->normal()), "normals");
+    check(equal<uint32_t>(a[i]->index(), b[i]->index()), "indices");
+    if(a[i]->position()) vertices += a[i]->position()->size() / 3;
+  }
+  std::printf("compared %zu meshes, %zu vertices\n", std::min(a.size(), b.size()), vertices);
+
+  return check.result();
+}
@@ -0,0 +1,129 @@
+//
+// Created by byter on 23.10.26.
+//
+
+// compares BufferGeometry raycasting through the BVH (single rays and ray packets) with
+// brute-force raycasting of all triangles, one ray at a time
+
+#include <algorithm>
+#include <random>
+#include <threepp/core/Raycaster.h>
+#include <threepp/geometry/Sphere.h>
+#include <threepp/objects/Mesh.h>
+#include <threepp/material/MeshBasicMaterial.h>
+#include "Benchmark.h"
+
+using namespace three;
+using namespace three::math;
+
+namespace {
+
+std::vector<std::vector<Intersection>> cast(Mesh &mesh, const std::vector<Raycaster> &raycasters)
+{
+  std::vector<std::vector<Intersection>> result;
+
+  for(const Raycaster &raycaster : raycasters) {
+    IntersectList intersects;
+    raycaster.intersectObject(mesh, intersects);
+
+    //rays without hits are dropped by the list, so single rays cast one by one line up with bundles
+    for(unsigned r=0; r<intersects.rayCount(); r++) {
+      result.emplace_back();
+      for(size_t i=0; i<intersects.count(r); i++) result.back().push_back(intersects.get(r, i));
+
+      //the BVH visits triangles in a different order
+      std::sort(result.back().begin(), result.back().end(), [](const Intersection &a, const Intersection &b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.faceIndex < b.faceIndex;
+      });
+    }
+  }
+  return result;
+}
+
+//a single-ray caster for each ray of the bundles. The bundle origin is kept, since distances are
+//measured from there
+std::vector<Raycaster> individually(const std::vector<Raycaster> &bundles)
+{
+  std::vector<Raycaster> result;
+  for(const Raycaster &bundle : bundles) {
+    for(const Ray &ray : bundle.rays()) result.emplace_back(bundle.origin(), std::vector<Ray>({ray}));
+  }
+  return result;
+}
+
+void compare(benchmark::Checker &check,
+             const std::vector<std::vector<Intersection>> &reference,
+             const std::vector<std::vector<Intersection>> &bvh)
+{
+  check(reference.size() == bvh.size(), "number of rays with hits");
+
+  for(size_t r=0, l=std::min(reference.size(), bvh.size()); r<l; r++) {
+    check(reference[r].size() == bvh[r].size(), "number of hits");
+
+    for(size_t i=0, n=std::min(reference[r].size(), bvh[r].size()); i<n; i++) {
+      const Intersection &a = reference[r][i], &b = bvh[r][i];
+
+      //the packet kernel performs the same operations as the scalar one, so results are identical
+      check(a.distance == b.distance, "distance");
+      //the sphere is indexed, so only faceIndex is set
+      check(a.faceIndex == b.faceIndex, "faceIndex");
+      check(a.face.a == b.face.a && a.face.b == b.face.b && a.face.c == b.face.c, "face");
+      check(a.point == b.point, "point");
+      check(a.uv == b.uv, "uv");
+    }
+  }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  benchmark::Checker check;
+
+  geometry::buffer::Sphere::Ptr sphere = geometry::buffer::Sphere::make(50, 256, 128);
+  DynamicMesh::Ptr mesh = DynamicMesh::make(sphere, MeshBasicMaterial::make());
+  mesh->updateMatrixWorld(true);
+
+  //rays from outside the sphere, aimed at points around its surface
+  std::mt19937 random(42);
+  std::uniform_real_distribution<float> unit(-1, 1);
+
+  auto randomRay = [&]() {
+    Vector3 origin = Vector3(unit(random), unit(random), unit(random)).normalize() * 200;
+    Vector3 target = Vector3(unit(random), unit(random), unit(random)) * 60;
+    return Ray(origin, (target - origin).normalize());
+  };
+
+  std::vector<Raycaster> singles, bundles;
+  for(unsigned i=0; i<1000; i++) singles.emplace_back(randomRay());
+  for(unsigned i=0; i<100; i++) bundles.push_back(Raycaster::circular(randomRay(), 5, 16));
+
+  sphere->raycastBVH = false;
+  auto reference = cast(*mesh, singles);
+  double referenceTime = benchmark::time(1, [&]() {cast(*mesh, singles);});
+
+  sphere->raycastBVH = true;
+  auto bvh = cast(*mesh, singles);
+  double bvhTime = benchmark::time(10, [&]() {cast(*mesh, singles);});
+
+  compare(check, reference, bvh);
+  benchmark::report("single rays", referenceTime, bvhTime);
+
+  //bundles: every ray on its own through the triangle loop, against ray packets with and without the BVH
+  std::vector<Raycaster> bundleRays = individually(bundles);
+
+  sphere->raycastBVH = false;
+  reference = cast(*mesh, bundleRays);
+  referenceTime = benchmark::time(1, [&]() {cast(*mesh, bundleRays);});
+
+  compare(check, reference, cast(*mesh, bundles));
+
+  sphere->raycastBVH = true;
+  bvh = cast(*mesh, bundles);
+  bvhTime = benchmark::time(10, [&]() {cast(*mesh, bundles);});
+
+  compare(check, reference, bvh);
+  benchmark::report("ray bundles", referenceTime, bvhTime);
+
+  return check.result();
+}
@@ -0,0 +1,132 @@
+//
+// Created by byter on 23.10.26.
+//
+
+// renders a scene made up of many small meshes with program validation before every draw, before
+// the first draw of each program only, and not at all, and compares the rendered images. Needs an
+// OpenGL context, and is skipped if none can be created
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <threepp/scene/Scene.h>
+#include <threepp/camera/PerspectiveCamera.h>
+#include <threepp/light/AmbientLight.h>
+#include <threepp/light/DirectionalLight.h>
+#include <threepp/geometry/Box.h>
+#include <threepp/objects/Mesh.h>
+#include <threepp/objects/Node.h>
+#include <threepp/material/MeshBasicMaterial.h>
+#include <threepp/material/MeshLambertMaterial.h>
+#include <threepp/renderers/gl/Renderer_impl.h>
+#include "Benchmark.h"
+
+using namespace three;
+using namespace three::math;
+
+namespace {
+
+const unsigned size = 256, rows = 64, columns = 64;
+
+std::vector<unsigned char> readPixels(gl::Renderer_impl &renderer, const Renderer::Target::Ptr &target)
+{
+  std::vector<unsigned char> rgba(size * size * 4);
+
+  renderer.setRenderTarget(target);
+  renderer.glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+
+  return rgba;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+  QGuiApplication app(argc, argv);
+
+  QSurfaceFormat format;
+  format.setVersion(3, 3);
+  format.setProfile(QSurfaceFormat::CoreProfile);
+
+  QOffscreenSurface surface;
+  surface.setFormat(format);
+  surface.create();
+
+  QOpenGLContext context;
+  context.setFormat(format);
+  if(!surface.isValid() || !context.create() || !context.makeCurrent(&surface)) {
+    std::printf("no OpenGL context, skipped\n");
+    return 0;
+  }
+
+  // a grid of boxes with a few materials, all in view, so every mesh is one draw call
+  Scene::Ptr scene = Scene::make();
+
+  std::vector<Material::Ptr> materials;
+  for(unsigned i=0; i<4; i++) {
+    MeshBasicMaterial::Ptr basic = MeshBasicMaterial::make();
+    basic->color = Color(0.2f + i * 0.2f, 0.5f, 1.0f - i * 0.2f);
+    materials.push_back(basic);
+
+    MeshLambertMaterial::Ptr lambert = MeshLambertMaterial::make();
+    lambert->color = Color(1.0f - i * 0.2f, 0.3f + i * 0.1f, 0.4f);
+    materials.push_back(lambert);
+  }
+
+  geometry::buffer::Box::Ptr box = geometry::buffer::Box::make(0.8f, 0.8f, 0.8f);
+  for(unsigned z=0; z<rows; z++) {
+    for(unsigned x=0; x<columns; x++) {
+      DynamicMesh::Ptr mesh = DynamicMesh::make(box, materials[(x * 7 + z) % materials.size()]);
+      mesh->position().set(x - columns / 2.0f, 0, -(float)z);
+      mesh->rotation().set(0, (x + z) * 0.1f, 0);
+      scene->add(mesh);
+    }
+  }
+
+  scene->add(AmbientLight::make(Color(0x404040)));
+  Node::Ptr target = Node::make();
+  scene->add(target);
+
+  DirectionalLight::Ptr light = DirectionalLight::make(target, Color(0xffffff), 1);
+  light->position().set(10, 20, 5);
+  scene->add(light);
+
+  PerspectiveCamera::Ptr camera = PerspectiveCamera::make(70, 1, 0.5f, 200);
+  camera->position().set(0, 30, 10);
+  camera->lookAt(Vector3(0, 0, -(float)rows / 2));
+
+  OpenGLRenderer::Ptr renderer = OpenGLRenderer::make(size, size, 1);
+  renderer->initContext();
+  gl::Renderer_impl &impl = dynamic_cast<gl::Renderer_impl &>(*renderer);
+
+  Renderer::Target::Ptr target2D = OpenGLRenderer::makeInternalTarget(size, size);
+
+  // the untimed first render compiles the programs
+  const unsigned frames = 10;
+
+  renderer->programValidation = ProgramValidation::EveryDraw;
+  double everyDraw = benchmark::time(frames, [&]() {renderer->render(scene, camera, target2D);});
+  std::vector<unsigned char> reference = readPixels(impl, target2D);
+
+  renderer->programValidation = ProgramValidation::Once;
+  double once = benchmark::time(frames, [&]() {renderer->render(scene, camera, target2D);});
+  std::vector<unsigned char> validatedOnce = readPixels(impl, target2D);
+
+  renderer->programValidation = ProgramValidation::Off;
+  double off = benchmark::time(frames, [&]() {renderer->render(scene, camera, target2D);});
+  std::vector<unsigned char> unvalidated = readPixels(impl, target2D);
+
+  benchmark::report("validate once", everyDraw, once);
+  benchmark::report("validation off", everyDraw, off);
+
+  benchmark::Checker check;
+  check(std::count(reference.begin(), reference.end(), 0) < (long)reference.size() / 2, "scene rendered");
+  check(validatedOnce == reference, "image with validation once");
+  check(unvalidated == reference, "image without validation");
+
+  context.doneCurrent();
+  return check.result();
+}
@@ -0,0 +1,164 @@
+//
+// Created by byter on 23.10.26.
+//
+
+// renders the shadow map of a directional light with 4 cascades, then renders each cascade on its
+// own with a single-cascade light using that cascade's bounds, and compares the tiles. Needs an
+// OpenGL context, and is skipped if none can be created
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <threepp/scene/Scene.h>
+#include <threepp/camera/PerspectiveCamera.h>
+#include <threepp/light/DirectionalLight.h>
+#include <threepp/geometry/Box.h>
+#include <threepp/objects/Mesh.h>
+#include <threepp/objects/Node.h>
+#include <threepp/material/MeshBasicMaterial.h>
+#include <threepp/renderers/gl/Renderer_impl.h>
+#include "Benchmark.h"
+
+using namespace three;
+using namespace three::math;
+
+namespace {
+
+const unsigned tileSize = 512;
+
+//reads the unpacked depth of a rectangle of the shadow map
+std::vector<float> readDepth(gl::Renderer_impl &renderer, const Renderer::Target::Ptr &map,
+                             unsigned x, unsigned y, unsigned width, unsigned height)
+{
+  std::vector<unsigned char> rgba(width * height * 4);
+
+  renderer.setRenderTarget(map);
+  renderer.glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+
+  //see unpackRGBAToDepth in packing.glsl
+  std::vector<float> depth(width * height);
+  for(size_t i=0; i<depth.size(); i++) {
+    const unsigned char *p = &rgba[i * 4];
+    double v = p[0] / (256.0 * 256.0 * 256.0) + p[1] / (256.0 * 256.0) + p[2] / 256.0 + p[3];
+    depth[i] = (float)(v / 256.0);
+  }
+  return depth;
+}
+
+DirectionalLight::Ptr makeLight(const Object3D::Ptr &target)
+{
+  DirectionalLight::Ptr light = DirectionalLight::make(target, Color(0xffffff), 1);
+  light->position().set(20, 40, 10);
+  light->castShadow = true;
+  light->shadow_t()->mapSize().set(tileSize, tileSize);
+  light->shadow_t()->camera_t()->set(-5, 5, 5, -5, 0.5, 200);
+  return light;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+  QGuiApplication app(argc, argv);
+
+  QSurfaceFormat format;
+  format.setVersion(3, 3);
+  format.setProfile(QSurfaceFormat::CoreProfile);
+
+  QOffscreenSurface surface;
+  surface.setFormat(format);
+  surface.create();
+
+  QOpenGLContext context;
+  context.setFormat(format);
+  if(!surface.isValid() || !context.create() || !context.makeCurrent(&surface)) {
+    std::printf("no OpenGL context, skipped\n");
+    return 0;
+  }
+
+  // boxes along the view direction, so every cascade draws some of them
+  Scene::Ptr scene = Scene::make();
+  MeshBasicMaterial::Ptr material = MeshBasicMaterial::make();
+  for(int z=0; z<40; z++) {
+    for(int x=-4; x<=4; x++) {
+      DynamicMesh::Ptr box = DynamicMesh::make(geometry::Box::make(0.8f, 0.5f + (z * 7 + x) % 5 * 0.5f, 0.8f), material);
+      box->position().set(x * 2.0f + (z % 3) * 0.5f, 0, -z * 2.0f);
+      box->castShadow = true;
+      scene->add(box);
+    }
+  }
+
+  PerspectiveCamera::Ptr camera = PerspectiveCamera::make(60, 1, 0.5f, 100);
+  camera->position().set(0, 5, 10);
+  camera->lookAt(Vector3(0, 0, -20));
+
+  Node::Ptr target = Node::make();
+  scene->add(target);
+
+  DirectionalLight::Ptr cascaded = makeLight(target);
+  DirectionalLightShadow::Ptr shadow = cascaded->shadow_t();
+  shadow->setCascades(4);
+  scene->add(cascaded);
+
+  DirectionalLight::Ptr single = makeLight(target);
+  single->castShadow = false;
+  scene->add(single);
+
+  OpenGLRenderer::Ptr renderer = OpenGLRenderer::make(256, 256, 1);
+  renderer->initContext();
+  renderer->setShadowMapType(ShadowMapType::PCF);
+  gl::Renderer_impl &impl = dynamic_cast<gl::Renderer_impl &>(*renderer);
+
+  Renderer::Target::Ptr target2D = OpenGLRenderer::makeInternalTarget(256, 256);
+  renderer->render(scene, camera, target2D);
+
+  // the renderer leaves the shadow camera at the union of all cascades. The cascade matrix
+  // holds each cascade's offset and scale within the union
+  unsigned cascades = shadow->cascades();
+  OrthographicCamera::Ptr unionCamera = shadow->camera_t();
+  float left = unionCamera->left(), bottom = unionCamera->bottom();
+  float width = unionCamera->right() - left, height = unionCamera->top() - bottom;
+  Matrix4 cascadeMatrix = shadow->cascadeMatrix();
+  const float *e = cascadeMatrix.elements();
+
+  std::vector<std::vector<float>> tiles;
+  for(unsigned c=0; c<cascades; c++) {
+    unsigned x = tileSize * (c % shadow->columns()), y = tileSize * (c / shadow->columns());
+    tiles.push_back(readDepth(impl, shadow->map(), x, y, tileSize, tileSize));
+  }
+
+  cascaded->castShadow = false;
+  single->castShadow = true;
+
+  benchmark::Checker check;
+  for(unsigned c=0; c<cascades; c++) {
+    float l = left + e[c * 4] * width, b = bottom + e[c * 4 + 1] * height;
+    float r = l + width / e[c * 4 + 2], t = b + height / e[c * 4 + 3];
+    single->shadow_t()->camera_t()->set(l, r, t, b);
+
+    renderer->render(scene, camera, target2D);
+    std::vector<float> reference = readDepth(impl, single->shadow()->map(), 0, 0, tileSize, tileSize);
+
+    //allow for rasterization differences along the edges of the casters
+    size_t different = 0, covered = 0;
+    for(size_t i=0; i<reference.size(); i++) {
+      if(std::fabs(reference[i] - tiles[c][i]) > 1e-3f) different++;
+      if(reference[i] < 1.0f) covered++;
+    }
+    std::printf("cascade %u: %zu of %zu texels differ, %zu covered by casters\n",
+                c, different, reference.size(), covered);
+
+    char what[64];
+    std::snprintf(what, sizeof(what), "cascade %u tile", c);
+    check(different < reference.size() / 200, what);
+
+    std::snprintf(what, sizeof(what), "cascade %u casters", c);
+    check(covered > 0, what);
+  }
+
+  context.doneCurrent();
+  return check.result();
+}
@@ -0,0 +1,194 @@
+//
+// Created by byter on 23.10.26.
+//
+
+// compares the SVG path data and point list lexer with the std::regex based parsing it replaced.
+// Both produce the commands of a path with their numbers, which must be identical
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <threepp/extras/PathLexer.h>
+#include "Benchmark.h"
+
+using namespace three;
+
+namespace {
+
+struct Command
+{
+  char letter;
+  std::vector<float> numbers;
+
+  bool operator == (const Command &other) const {
+    return letter == other.letter && numbers == other.numbers;
+  }
+};
+
+//the previous implementation, splitting path data into commands and numbers with regular expressions
+
+float _stof(const std::string &s)
+{
+  std::stringstream ss(s);
+  float ret;
+  ss >> ret;
+  return ret;
+}
+
+std::vector<float> parseFloats(const std::string &data)
+{
+  static const std::regex rex(R"([+-]?\d*\.\d+|[+-]?\d+)");
+
+  std::vector<float> floats;
+  std::sregex_iterator rex_it(data.begin(), data.end(), rex), rex_end;
+  for(; rex_it != rex_end; rex_it++) floats.push_back(_stof(rex_it->str()));
+
+  return floats;
+}
+
+std::vector<Command> regexPath(const char *d)
+{
+  static const std::regex rex("([a-df-z])([^a-df-z]*)", std::regex::icase);
+
+  std::vector<Command> commands;
+  std::cregex_iterator rex_it(d, d + std::strlen(d), rex), rex_end;
+  for(; rex_it != rex_end; rex_it++) {
+    const std::cmatch &match = *rex_it;
+    commands.push_back({match[1].str().at(0), parseFloats(match[2])});
+  }
+  return commands;
+}
+
+std::vector<float> regexPoints(const char *points)
+{
+  static const std::regex rex(R"((-?[\d\.?]+)[,|\s](-?[\d\.?]+))");
+
+  std::vector<float> result;
+  std::cregex_iterator rex_it(points, points + std::strlen(points), rex), rex_end;
+  for(; rex_it != rex_end; rex_it++) {
+    result.push_back(_stof((*rex_it)[1]));
+    result.push_back(_stof((*rex_it)[2]));
+  }
+  return result;
+}
+
+//the lexer, reading the numbers of each command the way parsePathNode does
+
+unsigned parameters(char command)
+{
+  switch(std::toupper(command)) {
+    case 'H': case 'V': return 1;
+    case 'M': case 'L': case 'T': return 2;
+    case 'S': case 'Q': return 4;
+    case 'C': return 6;
+    case 'A': return 7;
+    default: return 0;
+  }
+}
+
+std::vector<Command> lexPath(const char *d)
+{
+  extras::PathLexer lexer(d);
+  float n[7];
+
+  std::vector<Command> commands;
+  while(char letter = lexer.command()) {
+    commands.push_back({letter, {}});
+
+    unsigned count = parameters(letter);
+    if(!count) continue;
+
+    while(count == 7 ? lexer.arc(n) : lexer.numbers(n, count))
+      commands.back().numbers.insert(commands.back().numbers.end(), n, n + count);
+  }
+  return commands;
+}
+
+std::vector<float> lexPoints(const char *points)
+{
+  extras::PathLexer lexer(points);
+  float xy[2];
+
+  std::vector<float> result;
+  while(lexer.numbers(xy, 2)) result.insert(result.end(), xy, xy + 2);
+  return result;
+}
+
+//paths as written by common editors and icon sets: implicit separators, relative commands, arcs
+const char *paths[] = {
+   "M12 2C6.48 2 2 6.48 2 12s4.48 10 10 10 10-4.48 10-10S17.52 2 12 2zm-2 15l-5-5 1.41-1.41L10 14.17l7.59-7.59L19 8l-9 9z",
+   "M19 13h-6v6h-2v-6H5v-2h6V5h2v6h6v2z",
+   "M3 17.25V21h3.75L17.81 9.94l-3.75-3.75L3 17.25zM20.71 7.04c.39-.39.39-1.02 0-1.41l-2.34-2.34c-.39-.39-1.02-.39-1.41 0l-1.83 1.83 3.75 3.75 1.83-1.83z",
+   "M 100,100 L 300,100 L 200,300 Z",
+   "M10 80 Q 95 10 180 80 T 340 80",
+   "M 10,30 A 20,20 0,0,1 50,30 A 20,20 0,0,1 90,30 Q 90,60 50,90 Q 10,60 10,30 z",
+   "m-122.3,84.285c0,0 1.145,-0.636 2.226,0.509 1.08,1.145 -0.064,2.735 -0.064,2.735z",
+   "M.5.5l1-1 .25.25-.75.75h-1.5v-.5",
+   "M 600,350 l 50,-25 a25,25 -30 0,1 50,-25 l 50,-25 a25,50 -30 0,1 50,-25 l 50,-25",
+   "M\t10\n10\r\nH 90 V 90 H 10 L 10 10"
+};
+
+const char *pointLists[] = {
+   "350,75  379,161 469,161 397,215 423,301 350,250 277,301 303,215 231,161 321,161",
+   "0,40 40,40 40,80 80,80 80,120 120,120 120,160",
+   "60.5,20.25 100.125,40 100,80.75 60,100 20,80 20,40"
+};
+
+//a long path using all commands with parameters, for timing
+std::string generatePath()
+{
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> value(-1000, 1000);
+
+  const char *letters = "MLHVCSQTAmlhvcsqta";
+  std::string d;
+  char buf[32];
+
+  for(unsigned i=0; i<50000; i++) {
+    char letter = letters[i % 18];
+    d += letter;
+
+    for(unsigned p=0, count=parameters(letter); p<count; p++) {
+      //arc flags are single digits
+      if(count == 7 && (p == 3 || p == 4))
+        std::snprintf(buf, sizeof(buf), " %u", (unsigned)(rng() & 1));
+      else
+        std::snprintf(buf, sizeof(buf), "%s%.3f", p ? "," : "", value(rng));
+      d += buf;
+    }
+    d += ' ';
+  }
+  d += 'z';
+
+  return d;
+}
+
+}
+
+int main()
+{
+  benchmark::Checker check;
+
+  for(const char *d : paths) check(regexPath(d) == lexPath(d), d);
+  for(const char *points : pointLists) check(regexPoints(points) == lexPoints(points), points);
+
+  std::string generated = generatePath();
+  std::vector<Command> reference, lexed;
+
+  double regexTime = benchmark::time(3, [&]() {reference = regexPath(generated.c_str());});
+  double lexerTime = benchmark::time(3, [&]() {lexed = lexPath(generated.c_str());});
+
+  benchmark::report("svg path data", regexTime, lexerTime);
+  check(reference == lexed, "generated path");
+
+  //syntax only the lexer reads correctly
+  check(lexPath("M1e2-2.5E-1")[0].numbers == std::vector<float>({100.0f, -0.25f}), "exponents");
+  check(lexPath("a5 5 0 0110 10")[0].numbers == std::vector<float>({5, 5, 0, 0, 1, 10, 10}), "compact arc flags");
+
+  return check.result();
+}
@@ -0,0 +1,124 @@
+//
+// Created by byter on 23.10.26.
+//
+
+// compares the world matrix update through the TransformSystem with the recursive
+// Object3D::updateMatrixWorld(), and checks exception propagation through ThreadPool::parallelFor
+
+#include <stdexcept>
+#include <threepp/scene/Scene.h>
+#include <threepp/scene/TransformSystem.h>
+#include <threepp/objects/Node.h>
+#include <threepp/util/ThreadPool.h>
+#include "Benchmark.h"
+
+using namespace three;
+using namespace three::math;
+
+namespace {
+
+//a scene with 64 * 32 * 64 leaves below two levels of groups
+Scene::Ptr makeScene(std::vector<Object3D::Ptr> &nodes)
+{
+  Scene::Ptr scene = Scene::make();
+
+  for(unsigned i=0; i<64; i++) {
+    Node::Ptr group = Node::make();
+    group->position().set(i * 10.0f, 0, 0);
+    scene->add(group);
+    nodes.push_back(group);
+
+    for(unsigned j=0; j<32; j++) {
+      Node::Ptr child = Node::make();
+      child->position().set(0, j * 2.0f, 0);
+      child->rotation().set(0, j * 0.1f, 0);
+      group->add(child);
+      nodes.push_back(child);
+
+      for(unsigned k=0; k<64; k++) {
+        Node::Ptr leaf = Node::make();
+        leaf->position().set(0, 0, k * 0.5f);
+        leaf->scale().set(1, 1 + k * 0.01f, 1);
+        child->add(leaf);
+        nodes.push_back(leaf);
+      }
+    }
+  }
+  return scene;
+}
+
+//rotate every step-th node
+void animate(std::vector<Object3D::Ptr> &nodes, unsigned step, float angle)
+{
+  for(size_t i=0; i<nodes.size(); i += step) nodes[i]->rotation().set(angle, angle * 0.5f, 0);
+}
+
+void compare(benchmark::Checker &check, const std::vector<Object3D::Ptr> &reference,
+             const std::vector<Object3D::Ptr> &system)
+{
+  for(size_t i=0; i<reference.size(); i++) {
+    const float *a = reference[i]->matrixWorld().elements();
+    const float *b = system[i]->matrixWorld().elements();
+
+    bool equal = true;
+    for(unsigned e=0; e<16; e++) equal &= std::abs(a[e] - b[e]) <= 1e-4f * (1 + std::abs(a[e]));
+    check(equal, "world matrix");
+  }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  benchmark::Checker check;
+
+  //exceptions thrown by parallelFor work items reach the caller, and the pool stays usable
+  bool caught = false;
+  try {
+    ThreadPool::instance().parallelFor(0, 1000, 10, [](size_t begin, size_t end) {
+      if(begin <= 500 && 500 < end) throw std::runtime_error("failed");
+    });
+  }
+  catch(std::runtime_error &) {
+    caught = true;
+  }
+  check(caught, "exception rethrown by parallelFor");
+
+  size_t processed = 0;
+  std::mutex mutex;
+  ThreadPool::instance().parallelFor(0, 1000, 10, [&](size_t begin, size_t end) {
+    std::lock_guard<std::mutex> lock(mutex);
+    processed += end - begin;
+  });
+  check(processed == 1000, "parallelFor after an exception");
+
+  std::vector<Object3D::Ptr> referenceNodes, systemNodes;
+  Scene::Ptr reference = makeScene(referenceNodes);
+  Scene::Ptr system = makeScene(systemNodes);
+  system->setTransformSystem(true);
+
+  reference->updateMatrixWorld(false);
+  system->updateMatrixWorld(false);
+  compare(check, referenceNodes, systemNodes);
+
+  struct Case {const char *name; unsigned step;};
+  for(const Case &c : {Case{"all nodes changed", 1}, Case{"1% of the nodes changed", 100}}) {
+    float angle = 0;
+
+    double referenceTime = benchmark::time(20, [&]() {
+      animate(referenceNodes, c.step, angle += 0.01f);
+      reference->updateMatrixWorld(false);
+    });
+    angle = 0;
+    double systemTime = benchmark::time(20, [&]() {
+      animate(systemNodes, c.step, angle += 0.01f);
+      system->updateMatrixWorld(false);
+    });
+
+    compare(check, referenceNodes, systemNodes);
+    benchmark::report(c.name, referenceTime, systemTime);
+  }
+
+  std::printf("%zu nodes, %u worker threads\n", referenceNodes.size(), ThreadPool::instance().size());
+  return check.result();
+}
@@ -123,10 +123,7 @@ public:
     return math::Vector3(0, 0, - 1).apply(quaternion);
   }
 
-  void updateMatrixWorld(bool force) override {
-
-    Object3D::updateMatrixWorld(force);
-
+  void matrixWorldChanged() override {
     _matrixWorldInverse = _matrixWorld.inverted();
   }
 
@@ -135,6 +132,7 @@ public:
     math::Matrix4 m1( _position, vector, _up );
 
     _quaternion.set(m1);
+    transformChanged();
   }
 
   float near() const {return _near;}
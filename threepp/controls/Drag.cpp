@@ -91,13 +91,13 @@ void Drag::startSurface(const Intersection &intersect)
 
 void Drag::makePlane(const Object3D *object)
 {
-  _plane = math::Plane::fromNormalAndCoplanarPoint(_camera->getWorldDirection(), _selected->position());
+  _plane = math::Plane::fromNormalAndCoplanarPoint(_camera->getWorldDirection(), _selected->cposition());
 
   //translate the plane to the position of the selected object. Why it's not created there
   //in the first place by fromNormalAndCoplanarPoint - don't know
   math::Vector3 intersect;
   _raycaster.centerRay().intersectPlane(_plane, intersect);
-  _plane.translate((intersect - object->position()) * -1);
+  _plane.translate((intersect - object->cposition()) * -1);
 }
 
 void Drag::dragOnPlane()
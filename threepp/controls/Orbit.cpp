@@ -15,7 +15,7 @@ using namespace math;
 
 bool Orbit::update()
 {
-  _offset = _camera->position() - target;
+  _offset = _camera->cposition() - target;
 
   // rotate offset to "y-axis-is-up" space
   _offset.apply(_quat);
@@ -75,13 +75,13 @@ bool Orbit::update()
   // using small-angle approximation cos(x/2) = 1 - x^2 / 8
 
   if (_zoomChanged ||
-      lastPosition.distanceToSquared(_camera->position()) > EPS ||
-      8 * (1 - lastQuaternion.dot(_camera->quaternion())) > EPS) {
+      lastPosition.distanceToSquared(_camera->cposition()) > EPS ||
+      8 * (1 - lastQuaternion.dot(_camera->cquaternion())) > EPS) {
 
     onChanged.emitSignal(_state);
 
-    lastPosition = _camera->position();
-    lastQuaternion = _camera->quaternion();
+    lastPosition = _camera->cposition();
+    lastQuaternion = _camera->cquaternion();
     _zoomChanged = false;
 
     return true;
@@ -95,7 +95,7 @@ void Orbit::_pan(float deltaX, float deltaY)
   if(PerspectiveCamera *pcamera = _camera->typer) {
 
     // perspective
-    math::Vector3 offset = _camera->position() - target;
+    math::Vector3 offset = _camera->cposition() - target;
     float targetDistance = offset.length();
 
     // half of the fov is center to top of screen
@@ -103,17 +103,17 @@ void Orbit::_pan(float deltaX, float deltaY)
 
     // we actually don't use screenWidth, since perspective camera is fixed to screen height
     if (deltaX != 0)
-      panLeft(2.0f * deltaX * targetDistance / clientHeight(), pcamera->matrix());
+      panLeft(2.0f * deltaX * targetDistance / clientHeight(), pcamera->cmatrix());
     if (deltaY != 0)
-      panUp(2.0f * deltaY * targetDistance / clientHeight(), pcamera->matrix());
+      panUp(2.0f * deltaY * targetDistance / clientHeight(), pcamera->cmatrix());
   }
   else if(OrthographicCamera *ocamera = _camera->typer) {
 
     // orthographic
     if (deltaX != 0)
-      panLeft(deltaX * (ocamera->right() - ocamera->left()) / ocamera->zoom() / clientWidth(), ocamera->matrix());
+      panLeft(deltaX * (ocamera->right() - ocamera->left()) / ocamera->zoom() / clientWidth(), ocamera->cmatrix());
     if (deltaY != 0)
-      panUp(deltaY * (ocamera->top() - ocamera->bottom()) / ocamera->zoom() / clientHeight(), ocamera->matrix());
+      panUp(deltaY * (ocamera->top() - ocamera->bottom()) / ocamera->zoom() / clientHeight(), ocamera->cmatrix());
   }
   else {
     // camera neither orthographic nor perspective
@@ -283,7 +283,7 @@ void Orbit::pan(float deltaX, float deltaY)
 
 float Orbit::getDistance()
 {
-  return _camera ? _camera->position().distanceTo(target) : 0.0f;
+  return _camera ? _camera->cposition().distanceTo(target) : 0.0f;
 }
 
 void Orbit::set(float polar, float azimuth)
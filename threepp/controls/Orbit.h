@@ -80,7 +80,7 @@ protected:
   }
 
   Orbit(Camera::Ptr camera, const math::Vector3 &target)
-     : _camera(camera), target(target), _target0(target), _position0(camera->position()), _zoom0(camera->zoom())
+     : _camera(camera), target(target), _target0(target), _position0(camera->cposition()), _zoom0(camera->zoom())
   {
     init();
   }
@@ -243,7 +243,7 @@ public:
   void saveState()
   {
     _target0 = target;
-    _position0 = _camera->position();
+    _position0 = _camera->cposition();
     _zoom0 = _camera->zoom();
   }
 
@@ -43,7 +43,7 @@ Vector3 OrthographicTrackball::getMouseProjectionOnBall(unsigned x, unsigned y)
     mouseOnBall.z() = sqrt(1.0f - length * length);
   }
 
-  _eye = _camera->position() - _target;
+  _eye = _camera->cposition() - _target;
 
   Vector3 vector(_camera->up());
   vector.setLength(mouseOnBall.y());
@@ -149,7 +149,7 @@ void OrthographicTrackball::panCamera()
 
 void OrthographicTrackball::update()
 {
-  _eye = _camera->position() - _target;
+  _eye = _camera->cposition() - _target;
 
   if (!noRotate) {
 
@@ -192,7 +192,7 @@ bool OrthographicTrackball::reset()
   _camera->position() = _position0;
   _camera->up() = _up0;
 
-  _eye = _camera->position() - _target;
+  _eye = _camera->cposition() - _target;
 
   _camera->set(_left0, _right0, _top0, _bottom0);
 
@@ -72,7 +72,7 @@ protected:
 
   OrthographicTrackball(OrthographicCamera::Ptr camera) : _camera(camera)
   {
-    _position0 = _camera->position();
+    _position0 = _camera->cposition();
     _up0 = _camera->up();
 
     _left0 = _camera->left();
@@ -0,0 +1,259 @@
+//
+// Created by byter on 18.10.26.
+//
+
+#include "BVH.h"
+#include "BufferGeometry.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace three {
+
+using namespace std;
+
+namespace {
+
+const unsigned SAH_BINS = 16;
+const unsigned MAX_LEAF_SIZE = 4;
+const unsigned MAX_SAH_DEPTH = 32;
+
+struct Bounds
+{
+  float min[3] = {numeric_limits<float>::infinity(), numeric_limits<float>::infinity(), numeric_limits<float>::infinity()};
+  float max[3] = {-numeric_limits<float>::infinity(), -numeric_limits<float>::infinity(), -numeric_limits<float>::infinity()};
+
+  void expand(const float *bmin, const float *bmax)
+  {
+    for(unsigned i=0; i<3; i++) {
+      if(bmin[i] < min[i]) min[i] = bmin[i];
+      if(bmax[i] > max[i]) max[i] = bmax[i];
+    }
+  }
+
+  void expand(float x, float y, float z)
+  {
+    float p[3] = {x, y, z};
+    expand(p, p);
+  }
+
+  float area() const
+  {
+    float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+    if(dx < 0 || dy < 0 || dz < 0) return 0;
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+  }
+};
+
+/**
+ * recursive top-down builder. Primitive bounds are stored as 6 floats (min, max) per primitive
+ */
+class Builder
+{
+  const float *_bounds;
+  vector<BVH::Node> &_nodes;
+  vector<uint32_t> &_prims;
+
+  float centroid(uint32_t prim, unsigned axis) const
+  {
+    return (_bounds[prim * 6 + axis] + _bounds[prim * 6 + 3 + axis]) * 0.5f;
+  }
+
+  void makeLeaf(uint32_t node, uint32_t begin, uint32_t end)
+  {
+    _nodes[node].offset = begin;
+    _nodes[node].count = end - begin;
+  }
+
+  /**
+   * find the best SAH split. Returns false if no split is cheaper than a leaf
+   */
+  bool findSplit(uint32_t begin, uint32_t end, const Bounds &bounds, unsigned &splitAxis, float &splitPos)
+  {
+    Bounds centroids;
+    for(uint32_t i=begin; i<end; i++) {
+      uint32_t p = _prims[i];
+      centroids.expand(centroid(p, 0), centroid(p, 1), centroid(p, 2));
+    }
+
+    float bestCost = numeric_limits<float>::infinity();
+    bool found = false;
+
+    for(unsigned axis=0; axis<3; axis++) {
+
+      float cmin = centroids.min[axis], cmax = centroids.max[axis];
+      if(cmax <= cmin) continue;
+
+      Bounds binBounds[SAH_BINS];
+      uint32_t binCounts[SAH_BINS] = {0};
+      float scale = SAH_BINS / (cmax - cmin);
+
+      for(uint32_t i=begin; i<end; i++) {
+        uint32_t p = _prims[i];
+        unsigned bin = min((unsigned)((centroid(p, axis) - cmin) * scale), SAH_BINS - 1);
+        binCounts[bin]++;
+        binBounds[bin].expand(&_bounds[p * 6], &_bounds[p * 6 + 3]);
+      }
+
+      //sweep from the right, then evaluate from the left
+      float rightAreas[SAH_BINS];
+      uint32_t rightCounts[SAH_BINS];
+      Bounds right;
+      uint32_t rightCount = 0;
+      for(unsigned b=SAH_BINS-1; b>0; b--) {
+        right.expand(binBounds[b].min, binBounds[b].max);
+        rightCount += binCounts[b];
+        rightAreas[b] = right.area();
+        rightCounts[b] = rightCount;
+      }
+
+      Bounds left;
+      uint32_t leftCount = 0;
+      for(unsigned b=0; b<SAH_BINS-1; b++) {
+        left.expand(binBounds[b].min, binBounds[b].max);
+        leftCount += binCounts[b];
+
+        if(!leftCount || !rightCounts[b+1]) continue;
+
+        float cost = left.area() * leftCount + rightAreas[b+1] * rightCounts[b+1];
+        if(cost < bestCost) {
+          bestCost = cost;
+          splitAxis = axis;
+          splitPos = cmin + (b + 1) / scale;
+          found = true;
+        }
+      }
+    }
+
+    //compare against the cost of intersecting all primitives
+    return found && bestCost < bounds.area() * (end - begin);
+  }
+
+public:
+  Builder(const float *bounds, vector<BVH::Node> &nodes, vector<uint32_t> &prims)
+     : _bounds(bounds), _nodes(nodes), _prims(prims) {}
+
+  void build(uint32_t begin, uint32_t end, unsigned depth)
+  {
+    uint32_t node = (uint32_t)_nodes.size();
+    _nodes.emplace_back();
+
+    Bounds bounds;
+    for(uint32_t i=begin; i<end; i++) {
+      uint32_t p = _prims[i];
+      bounds.expand(&_bounds[p * 6], &_bounds[p * 6 + 3]);
+    }
+    memcpy(_nodes[node].min, bounds.min, sizeof(bounds.min));
+    memcpy(_nodes[node].max, bounds.max, sizeof(bounds.max));
+
+    if(end - begin <= MAX_LEAF_SIZE) {
+      makeLeaf(node, begin, end);
+      return;
+    }
+
+    uint32_t mid = begin;
+    unsigned axis;
+    float pos;
+
+    if(depth < MAX_SAH_DEPTH && findSplit(begin, end, bounds, axis, pos)) {
+      mid = (uint32_t)(partition(_prims.begin() + begin, _prims.begin() + end, [&](uint32_t p) {
+        return centroid(p, axis) < pos;
+      }) - _prims.begin());
+    }
+
+    if(mid == begin || mid == end) {
+      //no useful SAH split. Split at the median along the largest extent, which also bounds the depth
+      float ext[3] = {bounds.max[0] - bounds.min[0], bounds.max[1] - bounds.min[1], bounds.max[2] - bounds.min[2]};
+      axis = ext[0] > ext[1] ? (ext[0] > ext[2] ? 0 : 2) : (ext[1] > ext[2] ? 1 : 2);
+
+      mid = begin + (end - begin) / 2;
+      nth_element(_prims.begin() + begin, _prims.begin() + mid, _prims.begin() + end, [&](uint32_t a, uint32_t b) {
+        return centroid(a, axis) < centroid(b, axis);
+      });
+    }
+
+    _nodes[node].count = 0;
+    build(begin, mid, depth + 1);
+    _nodes[node].offset = (uint32_t)_nodes.size();
+    build(mid, end, depth + 1);
+  }
+};
+
+}
+
+size_t BVH::primitiveCount(const BufferGeometry &geometry, Primitive primitive, unsigned step)
+{
+  const auto &index = geometry.index();
+  const auto &position = geometry.position();
+
+  if(!position) return 0;
+
+  switch(primitive) {
+    case Primitive::Triangles:
+      return (index ? index->size() : position->itemCount()) / 3;
+    case Primitive::Segments: {
+      size_t count = index ? index->size() : position->size() / 3;
+      return count > 1 ? (count - 2) / step + 1 : 0;
+    }
+  }
+  return 0;
+}
+
+BVH::BVH(const BufferGeometry &geometry, Primitive primitive, unsigned step)
+   : _primitive(primitive), _step(step),
+     _positionAttr(geometry.position().get()),
+     _positionVersion(geometry.position() ? geometry.position()->version() : 0),
+     _indexAttr(geometry.index().get()),
+     _indexVersion(geometry.index() ? geometry.index()->version() : 0)
+{
+  size_t count = primitiveCount(geometry, primitive, step);
+  if(!count) return;
+
+  const auto &index = geometry.index();
+  const auto &position = geometry.position();
+
+  unsigned vertexCount = primitive == Primitive::Triangles ? 3 : 2;
+  unsigned stride = primitive == Primitive::Triangles ? 3 : step;
+
+  vector<float> bounds(count * 6);
+  _primitives.resize(count);
+
+  for(size_t i=0; i<count; i++) {
+    Bounds b;
+    for(unsigned v=0; v<vertexCount; v++) {
+      size_t element = i * stride + v;
+      uint32_t vertex = index ? index->at(element) : (uint32_t)element;
+      b.expand(position->get_x(vertex), position->get_y(vertex), position->get_z(vertex));
+    }
+    memcpy(&bounds[i * 6], b.min, sizeof(b.min));
+    memcpy(&bounds[i * 6 + 3], b.max, sizeof(b.max));
+
+    _primitives[i] = (uint32_t)i;
+  }
+
+  build(bounds.data());
+
+  if(primitive == Primitive::Segments) {
+    //report segments by their start element, as the line raycasting code does
+    for(auto &p : _primitives) p *= stride;
+  }
+}
+
+void BVH::build(const float *bounds)
+{
+  _nodes.reserve(_primitives.size() * 2 / MAX_LEAF_SIZE + 1);
+
+  Builder builder(bounds, _nodes, _primitives);
+  builder.build(0, (uint32_t)_primitives.size(), 0);
+}
+
+bool BVH::matches(const BufferGeometry &geometry, Primitive primitive, unsigned step) const
+{
+  return _primitive == primitive && _step == step
+         && _positionAttr == geometry.position().get()
+         && _positionVersion == (geometry.position() ? geometry.position()->version() : 0)
+         && _indexAttr == geometry.index().get()
+         && _indexVersion == (geometry.index() ? geometry.index()->version() : 0);
+}
+
+}
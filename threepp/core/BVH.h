@@ -0,0 +1,191 @@
+//
+// Created by byter on 18.10.26.
+//
+
+#ifndef THREEPP_BVH_H
+#define THREEPP_BVH_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <limits>
+#include <threepp/util/osdecl.h>
+#include <threepp/math/Ray.h>
+#include "impl/raypacket.h"
+
+namespace three {
+
+class BufferGeometry;
+class BufferAttribute;
+
+/**
+ * bounding volume hierarchy over the triangles or line segments of a BufferGeometry, used
+ * to accelerate raycasting. The tree is built using the surface area heuristic and stored as
+ * a flat node array in depth-first order
+ */
+class DLX BVH
+{
+public:
+  enum class Primitive {Triangles, Segments};
+
+  /**
+   * a tree node. The left child of an inner node immediately follows its parent
+   */
+  struct Node
+  {
+    float min[3];
+    float max[3];
+
+    //leaf: first entry in primitives(), inner node: index of the right child
+    uint32_t offset;
+
+    //number of primitives, 0 for inner nodes
+    uint32_t count;
+  };
+
+  /**
+   * geometries with fewer primitives are raycast without a BVH
+   */
+  static const size_t minPrimitives = 256;
+
+  using Ptr = std::shared_ptr<BVH>;
+
+private:
+  const Primitive _primitive;
+  const unsigned _step;
+
+  //identity of the source data
+  const BufferAttribute *_positionAttr;
+  unsigned _positionVersion;
+  const BufferAttribute *_indexAttr;
+  unsigned _indexVersion;
+
+  std::vector<Node> _nodes;
+  std::vector<uint32_t> _primitives;
+
+  BVH(const BufferGeometry &geometry, Primitive primitive, unsigned step);
+
+  void build(const float *bounds);
+
+  static bool intersects(const Node &node, const math::Vector3 &origin, const math::Vector3 &invDir, float margin)
+  {
+    float tmin = 0, tmax = std::numeric_limits<float>::infinity();
+
+    for(unsigned axis=0; axis<3; axis++) {
+      float t1 = (node.min[axis] - margin - origin[axis]) * invDir[axis];
+      float t2 = (node.max[axis] + margin - origin[axis]) * invDir[axis];
+
+      if(t1 > t2) std::swap(t1, t2);
+      if(t1 > tmin) tmin = t1;
+      if(t2 < tmax) tmax = t2;
+
+      if(tmin > tmax) return false;
+    }
+    return true;
+  }
+
+public:
+  /**
+   * build a BVH
+   *
+   * @param geometry the geometry providing positions and (optional) indices
+   * @param primitive the primitive type
+   * @param step for Segments, the distance between consecutive segment start points (1 for line
+   * strips, 2 for line segments)
+   */
+  static Ptr make(const BufferGeometry &geometry, Primitive primitive, unsigned step=1)
+  {
+    return Ptr(new BVH(geometry, primitive, step));
+  }
+
+  /**
+   * @return the number of primitives in a geometry
+   */
+  static size_t primitiveCount(const BufferGeometry &geometry, Primitive primitive, unsigned step=1);
+
+  /**
+   * @return true if this BVH was built for the current state of the geometry
+   */
+  bool matches(const BufferGeometry &geometry, Primitive primitive, unsigned step=1) const;
+
+  const std::vector<Node> &nodes() const {return _nodes;}
+
+  const std::vector<uint32_t> &primitives() const {return _primitives;}
+
+  /**
+   * visit all primitives whose bounds (extended by margin) are hit by the ray. Primitives are
+   * identified by their number: triangle number for Triangles, start element for Segments
+   *
+   * @param ray the ray, in geometry space
+   * @param margin bounds extension, e.g. line precision
+   * @param visit callback, receives the primitive number
+   */
+  template <typename Visit>
+  void intersect(const math::Ray &ray, float margin, Visit visit) const
+  {
+    if(_nodes.empty()) return;
+
+    const math::Vector3 &origin = ray.origin();
+    math::Vector3 invDir(1.0f / ray.direction().x(), 1.0f / ray.direction().y(), 1.0f / ray.direction().z());
+
+    uint32_t stack[64];
+    unsigned top = 0;
+    stack[top++] = 0;
+
+    while(top) {
+      uint32_t index = stack[--top];
+      const Node &node = _nodes[index];
+
+      if(!intersects(node, origin, invDir, margin)) continue;
+
+      if(node.count) {
+        for(uint32_t i=node.offset, l=node.offset+node.count; i<l; i++) visit(_primitives[i]);
+      }
+      else {
+        stack[top++] = node.offset;
+        stack[top++] = index + 1;
+      }
+    }
+  }
+
+  /**
+   * packet version of intersect(). Nodes are visited while at least one ray in the packet hits
+   * them, each ray sees the same primitives as with the single ray version
+   *
+   * @param visit callback, receives the primitive number and the mask of packet lanes that reached it
+   */
+  template <typename Visit>
+  void intersect(const impl::RayPacket &packet, float margin, Visit visit) const
+  {
+    if(_nodes.empty()) return;
+
+    uint32_t stack[64];
+    unsigned masks[64];
+    unsigned top = 0;
+    stack[top] = 0;
+    masks[top++] = packet.all();
+
+    while(top) {
+      --top;
+      uint32_t index = stack[top];
+      const Node &node = _nodes[index];
+
+      unsigned mask = packet.intersectsBox(node.min, node.max, margin, masks[top]);
+      if(!mask) continue;
+
+      if(node.count) {
+        for(uint32_t i=node.offset, l=node.offset+node.count; i<l; i++) visit(_primitives[i], mask);
+      }
+      else {
+        stack[top] = node.offset;
+        masks[top++] = mask;
+        stack[top] = index + 1;
+        masks[top++] = mask;
+      }
+    }
+  }
+};
+
+}
+
+#endif //THREEPP_BVH_H
@@ -54,6 +54,11 @@ struct Cpp2GL<uint8_t> {
   static const GLenum glEnum = GL_UNSIGNED_BYTE;
 };
 
+enum class AttributeName
+{
+  index, color, position, normal, uv, uv2, lineDistances, instanceMatrix, instanceColor, unknown
+};
+
 struct Index
 {
   union
@@ -484,7 +489,8 @@ public:
 };
 
 /**
- * a buffer attribute that wraps an externally managed buffer
+ * a buffer attribute that wraps an externally managed buffer. The buffer either outlives the
+ * attribute, or is kept alive through the owner, which is shared by all clones
  *
  * @tparam Type
  */
@@ -495,9 +501,11 @@ class ExternalBufferAttribute : public three::BufferAttributeT<Type>
 
   using Super = three::BufferAttributeT<Type>;
 
+  std::shared_ptr<void> _owner;
+
 protected:
-  ExternalBufferAttribute(Type *data, size_t itemSize, size_t itemCount)
-     : three::BufferAttributeT<Type>(itemCount * itemSize, itemSize, true)
+  ExternalBufferAttribute(Type *data, size_t itemSize, size_t itemCount, const std::shared_ptr<void> &owner=nullptr)
+     : three::BufferAttributeT<Type>(itemCount * itemSize, itemSize, true), _owner(owner)
   {
     Super::_data = data;
   }
@@ -573,6 +581,13 @@ struct attribute {
     return typename ExternalBufferAttribute<ComponentType>::Ptr(new ExternalBufferAttribute<ComponentType> (
        reinterpret_cast<ComponentType *>(data), sizeof(ItemType) / sizeof(ComponentType), size));
   }
+
+  //externally allocated buffer kept alive by owner, fixed size
+  template <typename ComponentType, typename ItemType>
+  static typename ExternalBufferAttribute<ComponentType>::Ptr external(void *data, size_t size, const std::shared_ptr<void> &owner) {
+    return typename ExternalBufferAttribute<ComponentType>::Ptr(new ExternalBufferAttribute<ComponentType> (
+       reinterpret_cast<ComponentType *>(data), sizeof(ItemType) / sizeof(ComponentType), size, owner));
+  }
 };
 
 }
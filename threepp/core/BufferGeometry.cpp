@@ -16,7 +16,7 @@ namespace three {
 using namespace math;
 using namespace impl;
 
-size_t Geometry::id_count = 0;
+std::atomic<uint64_t> Geometry::id_count {0};
 
 BufferGeometry::BufferGeometry(const BufferGeometry &geom) : Geometry(geom)
 {
@@ -46,9 +46,17 @@ BufferGeometry::BufferGeometry(const BufferGeometry &geom) : Geometry(geom)
     //_indexedAttributes.insert(iatt.first, BufferAttributeT<float>::Ptr(iatt.second->clone()));
   }
 
+  if(geom._packed) _packed = PackedVertexBuffer::make(*this, geom._packed->options());
+
   UpdateRange _drawRange;
 }
 
+BufferGeometry &BufferGeometry::compile(const PackedVertexBuffer::Options &options)
+{
+  _packed = PackedVertexBuffer::make(*this, options);
+  return *this;
+}
+
 math::Vector3 BufferGeometry::centroid(const Face3 &face) const
 {
   math::Vector3 vA = math::Vector3::fromBufferAttribute(*_position, face.a);
@@ -78,47 +86,100 @@ BufferGeometry &BufferGeometry::computeBoundingSphere()
   return *this;
 }
 
+const BVH *BufferGeometry::bvh(BVH::Primitive primitive, unsigned step)
+{
+  if(!raycastBVH || BVH::primitiveCount(*this, primitive, step) < BVH::minPrimitives) {
+    _bvh.reset();
+    return nullptr;
+  }
+  if(!_bvh || !_bvh->matches(*this, primitive, step)) {
+    _bvh = BVH::make(*this, primitive, step);
+  }
+  return _bvh.get();
+}
+
 void BufferGeometry::raycast(Mesh &mesh,
                              const Raycaster &raycaster,
                              const std::vector<math::Ray> &rays,
                              IntersectList &intersects)
 {
-  if (_index != nullptr) {
+  //vertices of triangle number t
+  auto vertices = [&](size_t t, unsigned &a, unsigned &b, unsigned &c) {
+    if (_index != nullptr) {
+      // indexed buffer geometry
+      a = _index->get_x(t * 3);
+      b = _index->get_x(t * 3 + 1);
+      c = _index->get_x(t * 3 + 2);
+    }
+    else {
+      // non-indexed buffer geometry
+      a = (unsigned)t * 3;
+      b = a + 1;
+      c = a + 2;
+    }
+  };
 
-    // indexed buffer geometry
-    for (size_t i = 0, l = _index->size(); i < l; i += 3) {
+  auto report = [&](size_t t, unsigned a, unsigned rayIndex, Intersection &intersection) {
+    if (_index != nullptr)
+      intersection.faceIndex = (unsigned)t; // triangle number in indices buffer semantics
+    else
+      intersection.index = a; // triangle number in positions buffer semantics
 
-      uint32_t a = _index->get_x(i);
-      uint32_t b = _index->get_x(i + 1);
-      uint32_t c = _index->get_x(i + 2);
+    intersects.add(rayIndex, intersection);
+  };
 
-      Intersection intersection;
-      unsigned rayIndex = 0;
-      for(const auto &ray : rays) {
-        if(checkBufferGeometryIntersection(mesh, raycaster, ray, _position, _uv, a, b, c, intersection)) {
-          intersection.faceIndex = (unsigned)std::floor(i / 3); // triangle number in indices buffer semantics
-          intersects.add(rayIndex, intersection);
-        }
-        rayIndex++;
+  //test triangle number t against a ray
+  auto check = [&](size_t t, const math::Ray &ray, unsigned rayIndex) {
+    unsigned a, b, c;
+    vertices(t, a, b, c);
+
+    Intersection intersection;
+    if(checkBufferGeometryIntersection(mesh, raycaster, ray, _position, _uv, a, b, c, intersection)) {
+      report(t, a, rayIndex, intersection);
+    }
+  };
+
+  //test triangle number t against the rays in mask, first is the index of the packet's first ray
+  auto checkPacket = [&](size_t t, const RayPacket &packet, unsigned first, unsigned mask) {
+    unsigned a, b, c;
+    vertices(t, a, b, c);
+
+    Intersection intersections[RayPacket::width];
+    unsigned hit = checkBufferGeometryIntersection(mesh, raycaster, packet, mask, _position, _uv, a, b, c, intersections);
+
+    for(unsigned lane=0; hit; lane++, hit >>= 1) {
+      if(hit & 1) report(t, a, first + lane, intersections[lane]);
+    }
+  };
+
+  const BVH *tree = bvh(BVH::Primitive::Triangles);
+  size_t count = BVH::primitiveCount(*this, BVH::Primitive::Triangles);
+
+  if(rays.size() > 1) {
+    //ray bundle, test RayPacket::width rays at once
+    for(unsigned first = 0; first < rays.size(); first += RayPacket::width) {
+      RayPacket packet(rays, first);
+
+      if(tree) {
+        tree->intersect(packet, 0.0f, [&](uint32_t t, unsigned mask) {checkPacket(t, packet, first, mask);});
+      }
+      else {
+        for (size_t t = 0; t < count; t++) checkPacket(t, packet, first, packet.all());
       }
     }
   }
+  else if(tree) {
+    unsigned rayIndex = 0;
+    for(const auto &ray : rays) {
+      tree->intersect(ray, 0.0f, [&](uint32_t t) {check(t, ray, rayIndex);});
+      rayIndex++;
+    }
+  }
   else {
-    // non-indexed buffer geometry
-    for (unsigned i = 0, l = (unsigned) _position->itemCount(); i < l; i += 3) {
-
-      unsigned a = i;
-      unsigned b = i + 1;
-      unsigned c = i + 2;
-
-      Intersection intersection;
+    for (size_t t = 0; t < count; t++) {
       unsigned rayIndex = 0;
       for(const auto &ray : rays) {
-        if (checkBufferGeometryIntersection(mesh, raycaster, ray, _position, _uv, a, b, c, intersection)) {
-          intersection.index = a; // triangle number in positions buffer semantics
-          intersects.add(rayIndex, intersection);
-        }
-        rayIndex++;
+        check(t, ray, rayIndex++);
       }
     }
   }
@@ -132,71 +193,51 @@ void BufferGeometry::raycast(Line &line,
   float precisionSq = raycaster.linePrecision() * raycaster.linePrecision();
   unsigned step = line.steps();
 
-  Vector3 interSegment;
-  Vector3 interRay;
+  //test the segment starting at element i against a ray
+  auto check = [&](size_t i, const math::Ray &ray, unsigned rayIndex) {
 
-  if (_index != nullptr) {
+    uint32_t a = _index ? (*_index)[ i ] : (uint32_t)i;
+    uint32_t b = _index ? (*_index)[ i + 1 ] : (uint32_t)i + 1;
 
-    for (size_t i = 0, l = _index->size() - 1; i < l; i += step ) {
+    Vector3 vStart = Vector3::fromArray(_position->data_t(), a * 3 );
+    Vector3 vEnd = Vector3::fromArray(_position->data_t(), b * 3 );
 
-      uint32_t a = (*_index)[ i ];
-      uint32_t b = (*_index)[ i + 1 ];
+    Vector3 interSegment;
+    Vector3 interRay;
 
-      Vector3 vStart = Vector3::fromArray(_position->data_t(), a * 3 );
-      Vector3 vEnd = Vector3::fromArray(_position->data_t(), b * 3 );
+    float distSq = ray.distanceSqToSegment( vStart, vEnd, &interRay, &interSegment );
 
-      unsigned rayIndex = 0;
-      for(const auto &ray : rays) {
-        float distSq = ray.distanceSqToSegment( vStart, vEnd, &interRay, &interSegment );
+    if ( distSq > precisionSq ) return;
 
-        if ( distSq > precisionSq ) continue;
+    interRay.apply( line.matrixWorld() ); //Move back to world space for distance calculation
 
-        interRay.apply( line.matrixWorld() ); //Move back to world space for distance calculation
+    float distance = raycaster.origin().distanceTo( interRay );
 
-        float distance = raycaster.origin().distanceTo( interRay );
+    if ( distance < raycaster.near() || distance > raycaster.far() ) return;
 
-        if ( distance < raycaster.near() || distance > raycaster.far() ) continue;
+    Intersection &intersection = intersects.add(rayIndex);
 
-        Intersection &intersection = intersects.add(rayIndex);
-        rayIndex++;
+    intersection.distance = distance;
+    intersection.direction = ray.direction();
+    // What do we want? intersection point on the ray or on the segment??
+    // point: raycaster.ray.at( distance ),
+    intersection.point = interSegment.apply(line.matrixWorld());
+    intersection.index = i;
+    intersection.object = &line;
+  };
 
-        intersection.distance = distance;
-        intersection.direction = ray.direction();
-        // What do we want? intersection point on the ray or on the segment??
-        // point: raycaster.ray.at( distance ),
-        intersection.point = interSegment.apply(line.matrixWorld());
-        intersection.index = i;
-        intersection.object = &line;
-      }
+  if(const BVH *tree = bvh(BVH::Primitive::Segments, step)) {
+    unsigned rayIndex = 0;
+    for(const auto &ray : rays) {
+      tree->intersect(ray, raycaster.linePrecision(), [&](uint32_t i) {check(i, ray, rayIndex);});
+      rayIndex++;
     }
-  } else {
-
-    for (size_t i = 0, l = _position->size() / 3 - 1; i < l; i += step ) {
-
-      Vector3 vStart = Vector3::fromArray(_position->data_t(), 3 * i );
-      Vector3 vEnd = Vector3::fromArray(_position->data_t(), 3 * i + 3 );
-
+  }
+  else {
+    for (size_t s = 0, l = BVH::primitiveCount(*this, BVH::Primitive::Segments, step); s < l; s++) {
       unsigned rayIndex = 0;
       for(const auto &ray : rays) {
-        float distSq = ray.distanceSqToSegment(vStart, vEnd, &interRay, &interSegment);
-
-        if (distSq > precisionSq) continue;
-
-        interRay.apply(line.matrixWorld()); //Move back to world space for distance calculation
-
-        float distance = raycaster.origin().distanceTo(interRay);
-
-        if (distance < raycaster.near() || distance > raycaster.far()) continue;
-
-        Intersection &intersection = intersects.add(rayIndex);
-
-        intersection.distance = distance;
-        intersection.direction = ray.direction();
-        // What do we want? intersection point on the ray or on the segment??
-        // point: raycaster.ray.at( distance ),
-        intersection.point = interSegment.apply(line.matrixWorld());
-        intersection.index = i;
-        intersection.object = &line;
+        check(s * step, ray, rayIndex++);
       }
     }
   }
@@ -11,6 +11,8 @@
 #include <threepp/util/osdecl.h>
 #include "Geometry.h"
 #include "BufferAttribute.h"
+#include "PackedVertexBuffer.h"
+#include "BVH.h"
 
 namespace three {
 enum class IndexedAttributeName : size_t
@@ -41,11 +43,6 @@ class Object3D;
 class LinearGeometry;
 class DirectGeometry;
 
-enum class AttributeName
-{
-  index, color, position, normal, uv, uv2, lineDistances, unknown
-};
-
 class DLX BufferGeometry : public Geometry
 {
   friend class BufferGeometryAccess;
@@ -70,6 +67,16 @@ class DLX BufferGeometry : public Geometry
 
   UpdateRange _drawRange;
 
+  PackedVertexBuffer::Ptr _packed;
+
+  BVH::Ptr _bvh;
+
+  /**
+   * @return the raycasting BVH for the current geometry state, or nullptr if the geometry is too
+   * small to benefit from one
+   */
+  const BVH *bvh(BVH::Primitive primitive, unsigned step=1);
+
   void setFromLinearGeometry(const LinearGeometry &geometry);
   void setFromMeshGeometry(LinearGeometry &geometry);
   void setFromDirectGeometry(std::shared_ptr<DirectGeometry> geometry);
@@ -119,6 +126,12 @@ protected:
   }
 
 public:
+  /**
+   * accelerate raycasting using a lazily built bounding volume hierarchy. The BVH is rebuilt
+   * whenever the position or index attribute changes
+   */
+  bool raycastBVH = true;
+
   using Ptr = std::shared_ptr<BufferGeometry>;
   static Ptr make() {
     return Ptr(new BufferGeometry());
@@ -146,6 +159,7 @@ public:
     _indexedAttributes = geom._indexedAttributes;
 
     _drawRange = geom._drawRange;
+    _packed = geom._packed;
     return *this;
   }
 
@@ -155,6 +169,19 @@ public:
 
   void normalizeNormals();
 
+  /**
+   * interleave the vertex attributes into one buffer using compact formats, see PackedVertexBuffer.
+   * The renderer draws from the packed buffer instead of the individual attributes, which remain
+   * available for raycasting and bounding volumes. The buffer is rebuilt whenever one of the
+   * packed attributes is replaced or updated.
+   *
+   * Shaders of built-in materials decode quantized attributes. Custom vertex shaders need to use
+   * the begin_vertex, beginnormal_vertex, uv_vertex and uv2_vertex chunks, or disable quantization
+   */
+  BufferGeometry &compile(const PackedVertexBuffer::Options &options=PackedVertexBuffer::Options());
+
+  const PackedVertexBuffer::Ptr &packed() const {return _packed;}
+
   bool useMorphing() const override
   {
     return !_morphAttributes_position.empty();
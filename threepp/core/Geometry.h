@@ -5,6 +5,7 @@
 #ifndef THREEPP_GEOMETRY_H
 #define THREEPP_GEOMETRY_H
 
+#include <atomic>
 #include <threepp/math/Vector3.h>
 #include <threepp/math/Matrix4.h>
 #include <threepp/math/Sphere.h>
@@ -38,7 +39,7 @@ class Geometry
 {
   friend class BufferGeometry;
 
-  static size_t id_count;
+  static std::atomic<uint64_t> id_count;
 
 protected:
   math::Box3 _boundingBox;
@@ -48,9 +49,9 @@ protected:
 
   virtual Geometry &apply(const math::Matrix4 &matrix) = 0;
 
-  Geometry(const geometry::Typer &typer=geometry::Typer()) : id(id_count++), typer(typer) {}
+  Geometry(const geometry::Typer &typer=geometry::Typer()) : id(++id_count), typer(typer) {}
 
-  Geometry(const Geometry &geometry) : id(id_count++)
+  Geometry(const Geometry &geometry) : id(++id_count)
   {
     _boundingBox = geometry._boundingBox;
     _boundingSphere = geometry._boundingSphere;
@@ -60,7 +61,8 @@ protected:
 public:
   virtual ~Geometry() {}
 
-  const size_t id;
+  //automatically assigned, unique within process
+  const uint64_t id;
 
   geometry::Typer typer;
 
@@ -5,6 +5,8 @@
 #include "Object3D.h"
 #include "LinearGeometry.h"
 #include "BufferGeometry.h"
+#include <threepp/scene/SceneIndex.h>
+#include <threepp/scene/TransformSystem.h>
 
 namespace three {
 
@@ -52,17 +54,20 @@ void Object3D::visit(std::function<bool(Object3D *)> f)
 void Object3D::onRotationChange(const math::Euler &rotation)
 {
   _quaternion.set(_rotation, false);
+  transformChanged();
 }
 
 void Object3D::onQuaternionChange(const math::Quaternion &quaternion)
 {
   _rotation.set(_quaternion, Euler::RotationOrder::Default, false);
+  transformChanged();
 }
 
 void Object3D::apply(const Matrix4 &matrix)
 {
   _matrix.multiply(matrix, _matrix);
   math::decompose(_matrix, _position, _quaternion, _scale );
+  transformChanged();
 }
 
 Box3 Object3D::computeBoundingBox()
@@ -168,37 +173,91 @@ void Object3D::traverseAncestors(std::function<void(Object3D &)> callback)
   }
 }
 
-void Object3D::updateMatrix()
+size_t Object3D::__matrixWorldUpdates = 0;
+std::atomic<uint64_t> Object3D::__id_count {0};
+
+size_t Object3D::matrixWorldUpdates()
+{
+  return __matrixWorldUpdates;
+}
+
+void Object3D::composeMatrix()
 {
   _matrix = Matrix4::rotation(_quaternion);
   _matrix.scale(_scale);
   _matrix.setPosition(_position);
 
+  _matrixNeedsUpdate = false;
   _matrixWorldNeedsUpdate = true;
 }
 
+void Object3D::updateMatrix()
+{
+  composeMatrix();
+  markChanged();
+}
+
 void Object3D::updateMatrixWorld(bool force)
 {
-  if (matrixAutoUpdate) updateMatrix();
+  if (matrixAutoUpdate && _matrixNeedsUpdate) composeMatrix();
 
   if (_matrixWorldNeedsUpdate || force ) {
 
+    bool indexed = _sceneIndex && _sceneSlot >= 0 && _sceneCulled;
+    math::Matrix4 previous;
+    if(indexed) previous = _matrixWorld;
+
     if (_parent) {
       _matrixWorld.multiply(_parent->_matrixWorld, _matrix);
     } else {
       _matrixWorld = _matrix;
     }
 
+    if(indexed && !(previous == _matrixWorld)) _sceneIndex->moved(*this);
+
     _matrixWorldNeedsUpdate = false;
+    __matrixWorldUpdates++;
+    matrixWorldChanged();
     force = true;
   }
 
-  // update children
-  for (Object3D::Ptr child : _children) {
-    child->updateMatrixWorld( force );
+  // update children, skipping unchanged subtrees
+  if (force || _descendantsNeedUpdate) {
+    _descendantsNeedUpdate = false;
+
+    for (const Object3D::Ptr &child : _children) {
+      child->updateMatrixWorld( force );
+    }
   }
 }
 
+void Object3D::indexAdded(const Ptr &object)
+{
+  _sceneIndex->add(object);
+}
+
+void Object3D::indexRemoved(Object3D &object)
+{
+  object._sceneIndex->remove(object);
+}
+
+void Object3D::transformsAdded()
+{
+  _transforms->invalidate();
+}
+
+void Object3D::transformsRemoved(Object3D &object)
+{
+  TransformSystem *transforms = object._transforms;
+  transforms->detach(object);
+  transforms->invalidate();
+}
+
+void Object3D::transformQueued()
+{
+  _transforms->queue(_transformSlot);
+}
+
 Object3D::Object3D() : _id(++__id_count)
 {
   _rotation.onChange.connect(*this, &Object3D::onRotationChange);
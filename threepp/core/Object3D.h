@@ -7,6 +7,7 @@
 
 #include <vector>
 #include <memory>
+#include <atomic>
 #include <functional>
 #include <tuple>
 #include <array>
@@ -28,11 +29,11 @@ class Renderer;
 class Raycaster;
 class Intersection;
 class Scene;
+class SceneIndex;
+class TransformSystem;
 using ScenePtr = std::shared_ptr<Scene>;
 using CameraPtr = std::shared_ptr<Camera>;
 
-static uint16_t __id_count = 0;
-
 namespace loader {
 class Access;
 }
@@ -43,6 +44,8 @@ class Access;
 class DLX Object3D
 {
   friend class three::loader::Access;
+  friend class SceneIndex;
+  friend class TransformSystem;
 
   template <typename G, typename... M> friend class Object3D_GM;
 
@@ -51,10 +54,10 @@ public:
 
 protected:
   //automatically assigned, unique within process
-  uint16_t _id;
+  uint64_t _id;
 
   //unique among children, 1-based, 0==undefined
-  uint16_t _childId;
+  uint32_t _childId;
 
   std::string _name;
 
@@ -70,7 +73,13 @@ protected:
   math::Matrix4 _matrix = math::Matrix4::identity();
   math::Matrix4 _matrixWorld = math::Matrix4::identity();
 
-  bool _matrixWorldNeedsUpdate = false;
+  //local matrix must be recomposed from position, quaternion and scale
+  bool _matrixNeedsUpdate = true;
+
+  bool _matrixWorldNeedsUpdate = true;
+
+  //some descendant needs a matrix update
+  bool _descendantsNeedUpdate = false;
 
   Layers _layers;
   bool _visible = true;
@@ -80,6 +89,56 @@ protected:
   Geometry::Ptr _geometry;
   std::vector<Material::Ptr> _materials;
 
+  //registration with the spatial index of the containing scene, see SceneIndex
+  SceneIndex *_sceneIndex = nullptr;
+  int32_t _sceneSlot = -1;
+  bool _sceneCulled = false;
+  int32_t _sceneMoved = -1;
+
+  //slot in the transform system of the containing scene, see TransformSystem
+  TransformSystem *_transforms = nullptr;
+  int32_t _transformSlot = -1;
+
+  static size_t __matrixWorldUpdates;
+  static std::atomic<uint64_t> __id_count;
+
+  void indexAdded(const Ptr &object);
+  void indexRemoved(Object3D &object);
+
+  void transformsAdded();
+  void transformsRemoved(Object3D &object);
+  void transformQueued();
+
+  void composeMatrix();
+
+  /**
+   * make sure the next world matrix update reaches this object. Flags the ancestors so that
+   * updateMatrixWorld() descends into this subtree, or queues the object with the transform system
+   */
+  void markChanged()
+  {
+    if(_transforms) {
+      transformQueued();
+      return;
+    }
+    for(Object3D *o = _parent; o && !o->_descendantsNeedUpdate; o = o->_parent)
+      o->_descendantsNeedUpdate = true;
+  }
+
+  /**
+   * to be called whenever position, rotation or scale change
+   */
+  void transformChanged()
+  {
+    _matrixNeedsUpdate = true;
+    markChanged();
+  }
+
+  /**
+   * called after the world matrix was recomputed
+   */
+  virtual void matrixWorldChanged() {}
+
   void onRotationChange(const math::Euler &rotation);
   void onQuaternionChange(const math::Quaternion &quaternion);
 
@@ -94,7 +153,7 @@ protected:
 public:
   virtual ~Object3D() {}
 
-  uint16_t childId() const {return _childId;}
+  uint32_t childId() const {return _childId;}
 
   void visit(bool (*f)(Object3D *));
   void visit(std::function<bool(Object3D *)> f);
@@ -122,11 +181,11 @@ public:
     return (bool)((Mat *)typer);
   }
 
-  uint16_t id() const {return _id;}
+  uint64_t id() const {return _id;}
   const Layers &layers() const {return _layers;}
   const math::Matrix4 &matrix() const {return _matrix;}
 
-  math::Matrix4 &matrix() {return _matrix;}
+  math::Matrix4 &matrix() {_matrixWorldNeedsUpdate = true; markChanged(); return _matrix;}
 
   void apply(const math::Matrix4 &matrix);
 
@@ -143,11 +202,16 @@ public:
   const std::vector<Ptr> &children() const {return _children;}
 
   math::Vector3 &up() {return _up;}
-  math::Vector3 &position() {return _position;}
-  math::Euler &rotation() {return _rotation;}
+  /*
+   * the non-const transform accessors assume that the returned reference is used for
+   * modification and flag the object for a matrix update. Use the const accessors or
+   * cposition(), crotation(), cquaternion(), cscale() and cmatrix() for reading
+   */
+  math::Vector3 &position() {transformChanged(); return _position;}
+  math::Euler &rotation() {transformChanged(); return _rotation;}
   math::Matrix4 &matrixWorld() {return _matrixWorld;}
-  math::Quaternion &quaternion() {return _quaternion;}
-  math::Vector3 &scale() {return _scale;}
+  math::Quaternion &quaternion() {transformChanged(); return _quaternion;}
+  math::Vector3 &scale() {transformChanged(); return _scale;}
 
   const math::Vector3 &position() const {return _position;}
   const math::Euler &rotation() const {return _rotation;}
@@ -155,8 +219,30 @@ public:
   const math::Quaternion &quaternion() const {return _quaternion;}
   const math::Vector3 &scale() const {return _scale;}
 
+  //read-only access which does not flag the object for a matrix update
+  const math::Vector3 &cposition() const {return _position;}
+  const math::Euler &crotation() const {return _rotation;}
+  const math::Quaternion &cquaternion() const {return _quaternion;}
+  const math::Vector3 &cscale() const {return _scale;}
+  const math::Matrix4 &cmatrix() const {return _matrix;}
+
   Object3D *parent() const {return _parent;}
 
+  /**
+   * @return the spatial index of the scene this object belongs to, or nullptr
+   */
+  SceneIndex *sceneIndex() const {return _sceneIndex;}
+
+  /**
+   * @return the transform system of the scene this object belongs to, or nullptr
+   */
+  TransformSystem *transformSystem() const {return _transforms;}
+
+  /**
+   * @return the index of this object in the arrays of the transform system, or -1
+   */
+  int32_t transformSlot() const {return _transformSlot;}
+
   int renderOrder() const {return _renderOrder;}
 
   virtual bool isShadowRenderable() const {return false;}
@@ -183,30 +269,34 @@ public:
   void apply(const math::Quaternion &q)
   {
     _quaternion *= q;
+    transformChanged();
   }
 
   void setRotationFromAxisAngle(const math::Vector3 &axis, float angle )
   {
     // assumes axis is normalized
     _quaternion.set( axis, angle );
+    transformChanged();
   }
 
   void setRotationFromEuler(const math::Euler &euler)
   {
     _quaternion = euler.toQuaternion();
+    transformChanged();
   }
 
   void setRotationFromMatrix(const math::Matrix4 &m)
   {
     // assumes the upper 3x3 of m is a pure rotation matrix (i.e, unscaled)
     _quaternion.set(m);
-
+    transformChanged();
   }
 
   void setRotationFromQuaternion(const math::Quaternion &q)
   {
     // assumes q is normalized
     _quaternion = q;
+    transformChanged();
   }
 
   Object3D &rotateOnAxis(const math::Vector3 &axis, float angle)
@@ -214,6 +304,7 @@ public:
     // rotate object on axis in object space
     // axis is assumed to be normalized
     _quaternion *= math::Quaternion(axis, angle);
+    transformChanged();
     return *this;
   }
 
@@ -241,6 +332,7 @@ public:
     v.apply(_quaternion);
 
     _position += (v * distance);
+    transformChanged();
 
     return *this;
   }
@@ -276,6 +368,7 @@ public:
     math::Matrix4 m1( vector, _position, _up );
 
     _quaternion.set(m1);
+    transformChanged();
   }
 
   void add(Object3D::Ptr object)
@@ -292,6 +385,13 @@ public:
     object->_childId = _children.size()+1;
 
     _children.push_back( object );
+
+    //world matrix is relative to the new parent
+    object->_matrixWorldNeedsUpdate = true;
+    object->markChanged();
+
+    if(_sceneIndex) indexAdded(object);
+    if(_transforms) transformsAdded();
   }
 
   void remove(Object3D::Ptr object)
@@ -300,6 +400,9 @@ public:
 
     if (found != _children.end()) {
 
+      if((*found)->_sceneIndex) indexRemoved(**found);
+      if((*found)->_transforms) transformsRemoved(**found);
+
       (*found)->_parent = nullptr;
       (*found)->_childId = 0;
 
@@ -311,6 +414,9 @@ public:
   {
     for(auto child : _children) {
 
+      if(child->_sceneIndex) indexRemoved(*child);
+      if(child->_transforms) transformsRemoved(*child);
+
       child->_parent = nullptr;
       child->_childId = 0;
     }
@@ -361,8 +467,17 @@ public:
 
   void updateMatrix();
 
+  /**
+   * update the world matrices of this object and its descendants. Only objects whose transform
+   * changed (and their descendants) are recomputed
+   */
   virtual void updateMatrixWorld(bool force);
 
+  /**
+   * @return the total number of world matrices computed by updateMatrixWorld
+   */
+  static size_t matrixWorldUpdates();
+
   virtual void raycast(const Raycaster &raycaster, IntersectList &intersects) {}
 };
 
@@ -0,0 +1,291 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#include "PackedVertexBuffer.h"
+#include "BufferGeometry.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace three {
+
+using namespace std;
+
+namespace {
+
+const unsigned max_uint16 = numeric_limits<uint16_t>::max();
+const unsigned max_int16 = numeric_limits<int16_t>::max();
+
+uint16_t unorm16(float value, float offset, float scale)
+{
+  float v = scale > 0.0f ? (value - offset) / scale : 0.0f;
+  return (uint16_t)lround(min(max(v, 0.0f), 1.0f) * max_uint16);
+}
+
+int16_t snorm16(float value)
+{
+  return (int16_t)lround(min(max(value, -1.0f), 1.0f) * max_int16);
+}
+
+uint8_t unorm8(float value)
+{
+  return (uint8_t)lround(min(max(value, 0.0f), 1.0f) * 255.0f);
+}
+
+template <typename T>
+void put(uint8_t *dest, T value)
+{
+  memcpy(dest, &value, sizeof(T));
+}
+
+void put(uint8_t *dest, std::initializer_list<float> values)
+{
+  for(float value : values) {
+    put(dest, value);
+    dest += sizeof(float);
+  }
+}
+
+//octahedral encoding. Projects the unit vector onto the octahedron, then folds the lower half up
+void octEncode(float x, float y, float z, float &u, float &v)
+{
+  float l1 = fabs(x) + fabs(y) + fabs(z);
+  if(l1 == 0.0f) {
+    u = v = 0.0f;
+    return;
+  }
+  x /= l1;
+  y /= l1;
+
+  if(z < 0.0f) {
+    float ox = x;
+    x = (1.0f - fabs(y)) * (ox >= 0.0f ? 1.0f : -1.0f);
+    y = (1.0f - fabs(ox)) * (y >= 0.0f ? 1.0f : -1.0f);
+  }
+  u = x;
+  v = y;
+}
+
+//offset.xy, scale.zw of the 2D attribute's bounding rectangle
+math::Vector4 range2(const BufferAttributeT<float> &attribute, size_t count)
+{
+  float minU = numeric_limits<float>::infinity(), minV = minU;
+  float maxU = -minU, maxV = -minU;
+
+  for(size_t i=0; i<count; i++) {
+    float u = attribute.get_x(i), v = attribute.get_y(i);
+    minU = min(minU, u); maxU = max(maxU, u);
+    minV = min(minV, v); maxV = max(maxV, v);
+  }
+  return math::Vector4(minU, minV, maxU - minU, maxV - minV);
+}
+
+bool inUnitRange(const BufferAttributeT<float> &attribute, size_t count)
+{
+  for(size_t i=0, l=count * attribute.itemSize(); i<l; i++) {
+    float value = attribute.at(i);
+    if(value < 0.0f || value > 1.0f) return false;
+  }
+  return true;
+}
+
+}
+
+PackedVertexBuffer::Ptr PackedVertexBuffer::make(const BufferGeometry &geometry, const Options &options)
+{
+  if(!geometry.position()) return nullptr;
+
+  Ptr buffer(new PackedVertexBuffer(options));
+  buffer->pack(geometry);
+  return buffer;
+}
+
+void PackedVertexBuffer::pack(const BufferGeometry &geometry)
+{
+  const BufferAttributeT<float>::Ptr &position = geometry.position();
+  const BufferAttributeT<float>::Ptr &normal = geometry.normal();
+  const BufferAttributeT<float>::Ptr &uv = geometry.uv();
+  const BufferAttributeT<float>::Ptr &uv2 = geometry.uv2();
+  const BufferAttributeT<float>::Ptr &color = geometry.color();
+
+  _count = position->itemCount();
+  _stride = 0;
+
+  auto place = [this](Layout &layout, GLenum type, unsigned size, bool normalized, bool quantized, unsigned bytes) {
+    layout.type = type;
+    layout.size = size;
+    layout.normalized = normalized;
+    layout.quantized = quantized;
+    layout.offset = _stride;
+    _stride += bytes;
+  };
+  //attributes with fewer items than positions are left to the renderer
+  auto usable = [this](const BufferAttributeT<float>::Ptr &attribute, unsigned itemSize) {
+    return attribute && attribute->itemSize() >= itemSize && attribute->itemCount() >= _count;
+  };
+
+  _position = _normal = _uv = _uv2 = _color = Layout();
+
+  //the morph target chunks combine the raw attributes
+  if(_options.quantizePosition && geometry.morphPositions().empty())
+    place(_position, GL_UNSIGNED_SHORT, 3, true, true, 4 * sizeof(uint16_t));
+  else
+    place(_position, GL_FLOAT, 3, false, false, 3 * sizeof(float));
+
+  if(usable(normal, 3)) {
+    if(_options.quantizeNormal && geometry.morphNormals().empty())
+      place(_normal, GL_SHORT, 2, true, true, 2 * sizeof(int16_t));
+    else
+      place(_normal, GL_FLOAT, 3, false, false, 3 * sizeof(float));
+  }
+  if(usable(uv, 2)) {
+    if(_options.quantizeUV)
+      place(_uv, GL_UNSIGNED_SHORT, 2, true, true, 2 * sizeof(uint16_t));
+    else
+      place(_uv, GL_FLOAT, 2, false, false, 2 * sizeof(float));
+  }
+  if(usable(uv2, 2)) {
+    if(_options.quantizeUV)
+      place(_uv2, GL_UNSIGNED_SHORT, 2, true, true, 2 * sizeof(uint16_t));
+    else
+      place(_uv2, GL_FLOAT, 2, false, false, 2 * sizeof(float));
+  }
+  if(usable(color, 3)) {
+    unsigned size = min(color->itemSize(), 4u);
+
+    //normalized bytes need no decoding
+    if(_options.quantizeColor && inUnitRange(*color, _count))
+      place(_color, GL_UNSIGNED_BYTE, size, true, false, 4);
+    else
+      place(_color, GL_FLOAT, size, false, false, size * sizeof(float));
+  }
+
+  _data.assign(_count * _stride, 0);
+
+  math::Box3 box = position->box3();
+  _positionOffset = box.min();
+  _positionScale = box.max() - box.min();
+
+  if(_uv.quantized) _uvRange = range2(*uv, _count);
+  if(_uv2.quantized) _uv2Range = range2(*uv2, _count);
+
+  for(size_t i=0; i<_count; i++) {
+    uint8_t *vertex = _data.data() + i * _stride;
+
+    float x = position->get_x(i), y = position->get_y(i), z = position->get_z(i);
+    if(_position.quantized) {
+      put(vertex + _position.offset, unorm16(x, _positionOffset.x(), _positionScale.x()));
+      put(vertex + _position.offset + 2, unorm16(y, _positionOffset.y(), _positionScale.y()));
+      put(vertex + _position.offset + 4, unorm16(z, _positionOffset.z(), _positionScale.z()));
+    }
+    else {
+      put(vertex + _position.offset, {x, y, z});
+    }
+
+    if(_normal.size) {
+      float nx = normal->get_x(i), ny = normal->get_y(i), nz = normal->get_z(i);
+      if(_normal.quantized) {
+        float u, v;
+        octEncode(nx, ny, nz, u, v);
+        put(vertex + _normal.offset, snorm16(u));
+        put(vertex + _normal.offset + 2, snorm16(v));
+      }
+      else {
+        put(vertex + _normal.offset, {nx, ny, nz});
+      }
+    }
+
+    if(_uv.size) {
+      if(_uv.quantized) {
+        put(vertex + _uv.offset, unorm16(uv->get_x(i), _uvRange.x(), _uvRange.z()));
+        put(vertex + _uv.offset + 2, unorm16(uv->get_y(i), _uvRange.y(), _uvRange.w()));
+      }
+      else {
+        put(vertex + _uv.offset, {uv->get_x(i), uv->get_y(i)});
+      }
+    }
+
+    if(_uv2.size) {
+      if(_uv2.quantized) {
+        put(vertex + _uv2.offset, unorm16(uv2->get_x(i), _uv2Range.x(), _uv2Range.z()));
+        put(vertex + _uv2.offset + 2, unorm16(uv2->get_y(i), _uv2Range.y(), _uv2Range.w()));
+      }
+      else {
+        put(vertex + _uv2.offset, {uv2->get_x(i), uv2->get_y(i)});
+      }
+    }
+
+    if(_color.size) {
+      for(unsigned c=0; c<_color.size; c++) {
+        float value = color->at(i * color->itemSize() + c);
+
+        if(_color.type == GL_UNSIGNED_BYTE)
+          put(vertex + _color.offset + c, unorm8(value));
+        else
+          put(vertex + _color.offset + c * sizeof(float), value);
+      }
+    }
+  }
+
+  _sources = {{
+    {position.get(), position->version()},
+    {normal.get(), normal ? normal->version() : 0},
+    {uv.get(), uv ? uv->version() : 0},
+    {uv2.get(), uv2 ? uv2->version() : 0},
+    {color.get(), color ? color->version() : 0}
+  }};
+
+  needsUpdate();
+}
+
+const PackedVertexBuffer::Layout *PackedVertexBuffer::layout(AttributeName name) const
+{
+  const Layout *layout;
+  switch(name) {
+    case AttributeName::position:
+      layout = &_position;
+      break;
+    case AttributeName::normal:
+      layout = &_normal;
+      break;
+    case AttributeName::uv:
+      layout = &_uv;
+      break;
+    case AttributeName::uv2:
+      layout = &_uv2;
+      break;
+    case AttributeName::color:
+      layout = &_color;
+      break;
+    default:
+      return nullptr;
+  }
+  return layout->size ? layout : nullptr;
+}
+
+unsigned PackedVertexBuffer::quantized() const
+{
+  unsigned bits = 0;
+  if(_position.quantized) bits |= Position;
+  if(_normal.quantized) bits |= Normal;
+  if(_uv.quantized) bits |= UV;
+  if(_uv2.quantized) bits |= UV2;
+  return bits;
+}
+
+bool PackedVertexBuffer::outdated(const BufferGeometry &geometry) const
+{
+  const BufferAttribute *attributes[] = {
+     geometry.position().get(), geometry.normal().get(), geometry.uv().get(),
+     geometry.uv2().get(), geometry.color().get()
+  };
+
+  for(unsigned i=0; i<_sources.size(); i++) {
+    if(attributes[i] != _sources[i].attribute) return true;
+    if(attributes[i] && attributes[i]->version() != _sources[i].version) return true;
+  }
+  return false;
+}
+
+}
@@ -0,0 +1,134 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#ifndef THREEPP_PACKEDVERTEXBUFFER_H
+#define THREEPP_PACKEDVERTEXBUFFER_H
+
+#include <array>
+#include <threepp/util/osdecl.h>
+#include "BufferAttribute.h"
+
+namespace three {
+
+class BufferGeometry;
+
+/**
+ * the vertex attributes of a buffer geometry, interleaved into one buffer using compact formats:
+ *
+ * - positions as normalized 16 bit unsigned integers relative to the bounding box
+ * - normals octahedron-encoded into two normalized 16 bit integers
+ * - uv and uv2 as normalized 16 bit unsigned integers relative to their bounding rectangle
+ * - colors as normalized 8 bit unsigned integers, if all components lie within [0, 1]
+ *
+ * Attributes not quantized are stored as floats. The shaders decode quantized attributes based on
+ * the QUANTIZED_POSITION, QUANTIZED_NORMAL, QUANTIZED_UV and QUANTIZED_UV2 defines, using the
+ * positionOffset, positionScale, uvRange and uv2Range uniforms.
+ */
+class DLX PackedVertexBuffer : public BufferAttribute
+{
+public:
+  struct Options
+  {
+    bool quantizePosition = true;
+    bool quantizeNormal = true;
+    bool quantizeUV = true;
+    bool quantizeColor = true;
+  };
+
+  struct Layout
+  {
+    GLenum type = 0;
+    //number of components, 0 if the attribute is not packed
+    unsigned size = 0;
+    bool normalized = false;
+    //whether the shader needs to decode the attribute
+    bool quantized = false;
+    //byte offset inside a vertex
+    unsigned offset = 0;
+  };
+
+  //bits returned by quantized()
+  enum Quantized : unsigned {Position=1, Normal=2, UV=4, UV2=8};
+
+private:
+  Options _options;
+
+  std::vector<uint8_t> _data;
+  unsigned _stride = 0;
+  size_t _count = 0;
+
+  Layout _position, _normal, _uv, _uv2, _color;
+
+  math::Vector3 _positionOffset, _positionScale;
+  math::Vector4 _uvRange, _uv2Range;
+
+  //the attributes packed into this buffer, to detect changes
+  struct Source
+  {
+    const BufferAttribute *attribute;
+    unsigned version;
+  };
+  std::array<Source, 5> _sources;
+
+  explicit PackedVertexBuffer(const Options &options)
+     : BufferAttribute(1, false), _options(options) {}
+
+  PackedVertexBuffer(const PackedVertexBuffer &buffer) = default;
+
+  void pack(const BufferGeometry &geometry);
+
+public:
+  using Ptr = std::shared_ptr<PackedVertexBuffer>;
+
+  /**
+   * @return a buffer holding the packed attributes of geometry, or nullptr if the geometry has no
+   * position attribute
+   */
+  static Ptr make(const BufferGeometry &geometry, const Options &options);
+
+  const Options &options() const {return _options;}
+
+  unsigned stride() const {return _stride;}
+
+  size_t count() const {return _count;}
+
+  /**
+   * @return the layout of the attribute inside a vertex, or nullptr if the attribute is not part
+   * of this buffer
+   */
+  const Layout *layout(AttributeName name) const;
+
+  /**
+   * @return the Quantized bits of the attributes the shader needs to decode
+   */
+  unsigned quantized() const;
+
+  /**
+   * @return true if the geometry's attributes were replaced or updated since packing
+   */
+  bool outdated(const BufferGeometry &geometry) const;
+
+  const math::Vector3 &positionOffset() const {return _positionOffset;}
+
+  const math::Vector3 &positionScale() const {return _positionScale;}
+
+  const math::Vector4 &uvRange() const {return _uvRange;}
+
+  const math::Vector4 &uv2Range() const {return _uv2Range;}
+
+  const void *data(size_t offset) const override {return _data.data() + offset;}
+
+  GLenum glType() const override {return Cpp2GL<uint8_t>::glEnum;}
+
+  size_t byteCount() const override {return _data.size();}
+
+  unsigned bytesPerElement() const override {return 1;}
+
+  PackedVertexBuffer *clone() const override {
+    return new PackedVertexBuffer(*this);
+  }
+};
+
+}
+#endif //THREEPP_PACKEDVERTEXBUFFER_H
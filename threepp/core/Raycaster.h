@@ -44,6 +44,11 @@ struct Intersection
    * triangle number in positions/vertices buffer (LinearGeometry and BufferGeometry)
    */
   unsigned index;
+
+  /**
+   * instance number (InstancedMesh only)
+   */
+  unsigned instance = 0;
 };
 
 /**
@@ -84,6 +89,14 @@ public:
 
   unsigned rayCount() const {return _intersections.size();}
 
+  /**
+   * @return the number of intersections for a ray
+   */
+  size_t count(unsigned rayIndex) const
+  {
+    return rayIndex < _intersections.size() ? _intersections[rayIndex].size() : 0;
+  }
+
   /**
    * calculate the surface to place a planar, circular object of the same
    * diameter as the ray bundle
@@ -11,6 +11,7 @@
 #include <threepp/core/Face3.h>
 #include <threepp/core/BufferAttribute.h>
 #include <threepp/material/Material.h>
+#include "raypacket.h"
 
 #ifdef near
 #undef near
@@ -20,6 +21,23 @@
 namespace three {
 namespace impl {
 
+/**
+ * complete an intersection whose point (in object space) has been determined
+ */
+inline bool finishIntersection(Object3D &object, const Raycaster &raycaster, Intersection &result)
+{
+  result.point.apply(object.matrixWorld());
+
+  float distance = raycaster.origin().distanceTo(result.point);
+
+  if (distance < raycaster.near() || distance > raycaster.far()) return false;
+
+  result.distance = distance;
+  result.object = &object;
+
+  return true;
+}
+
 inline bool checkIntersection(Object3D &object,
                               const Material::Ptr &material,
                               const Raycaster &raycaster,
@@ -37,16 +55,7 @@ inline bool checkIntersection(Object3D &object,
 
   if (!intersect) return false;
 
-  result.point.apply(object.matrixWorld());
-
-  float distance = raycaster.origin().distanceTo(result.point);
-
-  if (distance < raycaster.near() || distance > raycaster.far()) return false;
-
-  result.distance = distance;
-  result.object = &object;
-
-  return true;
+  return finishIntersection(object, raycaster, result);
 }
 
 inline math::Vector2 uvIntersection(const math::Vector3 &point,
@@ -94,6 +103,62 @@ inline bool checkBufferGeometryIntersection(Object3D &object,
   return false;
 }
 
+/**
+ * packet version of checkBufferGeometryIntersection, intersects all rays in mask with one triangle
+ *
+ * @param intersections (out) one intersection per lane
+ * @return the mask of lanes with a valid intersection
+ */
+inline unsigned checkBufferGeometryIntersection(Object3D &object,
+                                                const Raycaster &raycaster,
+                                                const RayPacket &packet,
+                                                unsigned mask,
+                                                const BufferAttributeT<float>::Ptr &position,
+                                                const BufferAttributeT<float>::Ptr &uv,
+                                                unsigned a, unsigned b, unsigned c,
+                                                Intersection *intersections)
+{
+  math::Vector3 vA = math::Vector3::fromBufferAttribute(*position, a);
+  math::Vector3 vB = math::Vector3::fromBufferAttribute(*position, b);
+  math::Vector3 vC = math::Vector3::fromBufferAttribute(*position, c);
+
+  const Material::Ptr &material = object.material();
+  math::Vector3 points[RayPacket::width];
+
+  unsigned hit;
+  if (material->side == Side::Back) {
+    hit = packet.intersectTriangle(vC, vB, vA, true, mask, points);
+  }
+  else {
+    hit = packet.intersectTriangle(vA, vB, vC, material->side != Side::Double, mask, points);
+  }
+
+  for(unsigned lane=0; lane<RayPacket::width; lane++) {
+    if(!(hit & (1u << lane))) continue;
+
+    Intersection &intersection = intersections[lane];
+    intersection.point = points[lane];
+
+    if(!finishIntersection(object, raycaster, intersection)) {
+      hit &= ~(1u << lane);
+      continue;
+    }
+
+    if(uv) {
+      math::Vector2 uvA = math::Vector2::fromBufferAttribute(*uv, a);
+      math::Vector2 uvB = math::Vector2::fromBufferAttribute(*uv, b);
+      math::Vector2 uvC = math::Vector2::fromBufferAttribute(*uv, c);
+
+      intersection.uv = uvIntersection(intersection.point, vA, vB, vC, uvA, uvB, uvC);
+    }
+
+    intersection.face = Face3(a, b, c, math::Triangle::normal(vA, vB, vC));
+    intersection.faceIndex = a;
+  }
+
+  return hit;
+}
+
 }
 }
 #endif //THREEPP_RAYCAST_H
@@ -0,0 +1,266 @@
+//
+// Created by byter on 19.10.26.
+//
+
+#ifndef THREEPP_RAYPACKET_H
+#define THREEPP_RAYPACKET_H
+
+#include <vector>
+#include <threepp/math/Ray.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define THREE_RAYPACKET_AVX
+#define THREE_RAYPACKET_SIMD
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define THREE_RAYPACKET_SSE
+#define THREE_RAYPACKET_SIMD
+#endif
+
+namespace three {
+namespace impl {
+
+#if defined(THREE_RAYPACKET_AVX)
+
+/**
+ * 8 float lanes (AVX)
+ */
+struct Lanes
+{
+  static const unsigned width = 8;
+
+  __m256 v;
+
+  Lanes(__m256 v) : v(v) {}
+  explicit Lanes(float f) : v(_mm256_set1_ps(f)) {}
+
+  static Lanes load(const float *f) {return _mm256_loadu_ps(f);}
+  void store(float *f) const {_mm256_storeu_ps(f, v);}
+
+  unsigned mask() const {return (unsigned)_mm256_movemask_ps(v);}
+
+  friend Lanes operator +(Lanes a, Lanes b) {return _mm256_add_ps(a.v, b.v);}
+  friend Lanes operator -(Lanes a, Lanes b) {return _mm256_sub_ps(a.v, b.v);}
+  friend Lanes operator *(Lanes a, Lanes b) {return _mm256_mul_ps(a.v, b.v);}
+  friend Lanes operator /(Lanes a, Lanes b) {return _mm256_div_ps(a.v, b.v);}
+  friend Lanes operator <(Lanes a, Lanes b) {return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ);}
+  friend Lanes operator >(Lanes a, Lanes b) {return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ);}
+  friend Lanes operator &(Lanes a, Lanes b) {return _mm256_and_ps(a.v, b.v);}
+  friend Lanes operator |(Lanes a, Lanes b) {return _mm256_or_ps(a.v, b.v);}
+
+  //mask ? a : b
+  static Lanes select(Lanes mask, Lanes a, Lanes b) {return _mm256_blendv_ps(b.v, a.v, mask.v);}
+};
+
+#elif defined(THREE_RAYPACKET_SSE)
+
+/**
+ * 4 float lanes (SSE2)
+ */
+struct Lanes
+{
+  static const unsigned width = 4;
+
+  __m128 v;
+
+  Lanes(__m128 v) : v(v) {}
+  explicit Lanes(float f) : v(_mm_set1_ps(f)) {}
+
+  static Lanes load(const float *f) {return _mm_loadu_ps(f);}
+  void store(float *f) const {_mm_storeu_ps(f, v);}
+
+  unsigned mask() const {return (unsigned)_mm_movemask_ps(v);}
+
+  friend Lanes operator +(Lanes a, Lanes b) {return _mm_add_ps(a.v, b.v);}
+  friend Lanes operator -(Lanes a, Lanes b) {return _mm_sub_ps(a.v, b.v);}
+  friend Lanes operator *(Lanes a, Lanes b) {return _mm_mul_ps(a.v, b.v);}
+  friend Lanes operator /(Lanes a, Lanes b) {return _mm_div_ps(a.v, b.v);}
+  friend Lanes operator <(Lanes a, Lanes b) {return _mm_cmplt_ps(a.v, b.v);}
+  friend Lanes operator >(Lanes a, Lanes b) {return _mm_cmpgt_ps(a.v, b.v);}
+  friend Lanes operator &(Lanes a, Lanes b) {return _mm_and_ps(a.v, b.v);}
+  friend Lanes operator |(Lanes a, Lanes b) {return _mm_or_ps(a.v, b.v);}
+
+  //mask ? a : b
+  static Lanes select(Lanes mask, Lanes a, Lanes b) {
+    return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+  }
+};
+
+#endif
+
+/**
+ * a group of up to RayPacket::width rays from a ray bundle, stored as structure of arrays so the
+ * triangle and box tests can process all rays at once. The SIMD tests perform the same
+ * floating point operations in the same order as the scalar code in math::Ray and BVH, so
+ * results are identical. Without SSE2/AVX the tests fall back to the scalar code
+ */
+class RayPacket
+{
+public:
+#ifdef THREE_RAYPACKET_SIMD
+  static const unsigned width = Lanes::width;
+#else
+  static const unsigned width = 4;
+#endif
+
+private:
+  const math::Ray *_rays[width];
+  unsigned _size;
+
+  float _ox[width], _oy[width], _oz[width];
+  float _dx[width], _dy[width], _dz[width];
+  float _ix[width], _iy[width], _iz[width];
+
+public:
+  /**
+   * load rays [first, first + width) from rays (or less, if there are not enough)
+   */
+  RayPacket(const std::vector<math::Ray> &rays, size_t first)
+  {
+    _size = (unsigned)std::min<size_t>(width, rays.size() - first);
+
+    for(unsigned i=0; i<width; i++) {
+      //pad with copies of the first ray, masked out by all()
+      const math::Ray &ray = rays[first + (i < _size ? i : 0)];
+      _rays[i] = &ray;
+
+      _ox[i] = ray.origin().x(); _oy[i] = ray.origin().y(); _oz[i] = ray.origin().z();
+      _dx[i] = ray.direction().x(); _dy[i] = ray.direction().y(); _dz[i] = ray.direction().z();
+      _ix[i] = 1.0f / _dx[i]; _iy[i] = 1.0f / _dy[i]; _iz[i] = 1.0f / _dz[i];
+    }
+  }
+
+  unsigned size() const {return _size;}
+
+  const math::Ray &ray(unsigned lane) const {return *_rays[lane];}
+
+  /**
+   * @return the mask of lanes holding valid rays
+   */
+  unsigned all() const {return (1u << _size) - 1;}
+
+  /**
+   * intersect all rays in mask with a triangle, see math::Ray::intersectTriangle
+   *
+   * @param points (out) the intersection point for each hit lane
+   * @return the mask of lanes that hit the triangle
+   */
+  unsigned intersectTriangle(const math::Vector3 &a, const math::Vector3 &b, const math::Vector3 &c,
+                             bool backfaceCulling, unsigned mask, math::Vector3 *points) const
+  {
+#ifdef THREE_RAYPACKET_SIMD
+    math::Vector3 edge1 = b - a;
+    math::Vector3 edge2 = c - a;
+    math::Vector3 normal = math::cross(edge1, edge2);
+
+    const Lanes zero(0.0f);
+    Lanes dx = Lanes::load(_dx), dy = Lanes::load(_dy), dz = Lanes::load(_dz);
+    Lanes nx(normal.x()), ny(normal.y()), nz(normal.z());
+
+    Lanes DdN = dx * nx + dy * ny + dz * nz;
+    Lanes pos = DdN > zero, neg = DdN < zero;
+    unsigned hit = mask & (backfaceCulling ? neg.mask() : (pos | neg).mask());
+    if(!hit) return 0;
+
+    Lanes sign = Lanes::select(pos, Lanes(1.0f), Lanes(-1.0f));
+    DdN = Lanes::select(neg, zero - DdN, DdN);
+
+    Lanes diffx = Lanes::load(_ox) - Lanes(a.x());
+    Lanes diffy = Lanes::load(_oy) - Lanes(a.y());
+    Lanes diffz = Lanes::load(_oz) - Lanes(a.z());
+
+    Lanes e1x(edge1.x()), e1y(edge1.y()), e1z(edge1.z());
+    Lanes e2x(edge2.x()), e2y(edge2.y()), e2z(edge2.z());
+
+    //Dot(D, Cross(Q, E2))
+    Lanes DdQxE2 = sign * (dx * (diffy * e2z - diffz * e2y)
+                           + dy * (diffz * e2x - diffx * e2z)
+                           + dz * (diffx * e2y - diffy * e2x));
+
+    //Dot(D, Cross(E1, Q))
+    Lanes DdE1xQ = sign * (dx * (e1y * diffz - e1z * diffy)
+                           + dy * (e1z * diffx - e1x * diffz)
+                           + dz * (e1x * diffy - e1y * diffx));
+
+    Lanes QdN = (zero - sign) * (diffx * nx + diffy * ny + diffz * nz);
+
+    Lanes reject = (DdQxE2 < zero) | (DdE1xQ < zero) | (DdQxE2 + DdE1xQ > DdN) | (QdN < zero);
+    hit &= ~reject.mask();
+
+    if(hit) {
+      float t[width];
+      (QdN / DdN).store(t);
+
+      for(unsigned i=0; i<width; i++) {
+        if(hit & (1u << i)) points[i] = _rays[i]->at(t[i]);
+      }
+    }
+    return hit;
+#else
+    unsigned hit = 0;
+    for(unsigned i=0; i<width; i++) {
+      if((mask & (1u << i)) && _rays[i]->intersectTriangle(a, b, c, backfaceCulling, points[i])) {
+        hit |= 1u << i;
+      }
+    }
+    return hit;
+#endif
+  }
+
+  /**
+   * slab test of all rays in mask against a box extended by margin, see BVH::intersects
+   *
+   * @return the mask of lanes that hit the box
+   */
+  unsigned intersectsBox(const float *min, const float *max, float margin, unsigned mask) const
+  {
+#ifdef THREE_RAYPACKET_SIMD
+    const float *origin[3] = {_ox, _oy, _oz};
+    const float *invDir[3] = {_ix, _iy, _iz};
+
+    Lanes tmin(0.0f), tmax(std::numeric_limits<float>::infinity());
+
+    for(unsigned axis=0; axis<3; axis++) {
+      Lanes o = Lanes::load(origin[axis]), inv = Lanes::load(invDir[axis]);
+
+      Lanes t1 = (Lanes(min[axis] - margin) - o) * inv;
+      Lanes t2 = (Lanes(max[axis] + margin) - o) * inv;
+
+      Lanes swap = t1 > t2;
+      Lanes lo = Lanes::select(swap, t2, t1), hi = Lanes::select(swap, t1, t2);
+
+      tmin = Lanes::select(lo > tmin, lo, tmin);
+      tmax = Lanes::select(hi < tmax, hi, tmax);
+    }
+    return mask & ~(tmin > tmax).mask();
+#else
+    unsigned hit = 0;
+    for(unsigned i=0; i<width; i++) {
+      if(!(mask & (1u << i))) continue;
+
+      float o[3] = {_ox[i], _oy[i], _oz[i]}, inv[3] = {_ix[i], _iy[i], _iz[i]};
+      float tmin = 0, tmax = std::numeric_limits<float>::infinity();
+
+      bool miss = false;
+      for(unsigned axis=0; axis<3 && !miss; axis++) {
+        float t1 = (min[axis] - margin - o[axis]) * inv[axis];
+        float t2 = (max[axis] + margin - o[axis]) * inv[axis];
+
+        if(t1 > t2) std::swap(t1, t2);
+        if(t1 > tmin) tmin = t1;
+        if(t2 < tmax) tmax = t2;
+
+        miss = tmin > tmax;
+      }
+      if(!miss) hit |= 1u << i;
+    }
+    return hit;
+#endif
+  }
+};
+
+}
+}
+
+#endif //THREEPP_RAYPACKET_H
@@ -0,0 +1,167 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#ifndef THREE_PP_PATHLEXER_H
+#define THREE_PP_PATHLEXER_H
+
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+namespace three {
+namespace extras {
+
+inline bool isSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+inline bool isDigit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+/**
+ * parse a number in SVG syntax, [+-] digits [. digits] [(e|E) [+-] digits]
+ *
+ * @return the end of the number, or pos if there is no number at pos
+ */
+inline const char *parseFloat(const char *pos, const char *end, float &value)
+{
+  static const double powers[] = {
+     1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const char *start = pos;
+
+  bool negative = false;
+  if(pos < end && (*pos == '+' || *pos == '-')) negative = *pos++ == '-';
+
+  //up to 19 significant digits fit into the mantissa, further digits only scale it
+  uint64_t mantissa = 0;
+  int exponent = 0, digits = 0;
+  bool found = false;
+
+  for(; pos < end && isDigit(*pos); pos++) {
+    found = true;
+    if(digits < 19) {
+      mantissa = mantissa * 10 + (*pos - '0');
+      if(mantissa) digits++;
+    }
+    else exponent++;
+  }
+  if(pos < end && *pos == '.') {
+    for(pos++; pos < end && isDigit(*pos); pos++) {
+      found = true;
+      if(digits < 19) {
+        mantissa = mantissa * 10 + (*pos - '0');
+        if(mantissa) digits++;
+        exponent--;
+      }
+    }
+  }
+  if(!found) return start;
+
+  //the exponent is optional, "1e" is the number 1 followed by 'e'
+  if(pos < end && (*pos == 'e' || *pos == 'E')) {
+    const char *exp = pos + 1;
+    bool expNegative = false;
+    if(exp < end && (*exp == '+' || *exp == '-')) expNegative = *exp++ == '-';
+
+    if(exp < end && isDigit(*exp)) {
+      int e = 0;
+      for(; exp < end && isDigit(*exp); exp++) {
+        if(e < 1000) e = e * 10 + (*exp - '0');
+      }
+      exponent += expNegative ? -e : e;
+      pos = exp;
+    }
+  }
+
+  double result = (double)mantissa;
+  if(exponent < 0)
+    result /= -exponent <= 22 ? powers[-exponent] : std::pow(10.0, -exponent);
+  else if(exponent > 0)
+    result *= exponent <= 22 ? powers[exponent] : std::pow(10.0, exponent);
+
+  value = (float)(negative ? -result : result);
+  return pos;
+}
+
+/**
+ * single pass lexer for path data and point lists. Numbers are separated by whitespace and/or a
+ * comma, or not at all if the next number starts with a sign or a second decimal point
+ */
+class PathLexer
+{
+  const char *_pos;
+  const char * const _end;
+
+  void skipSeparators()
+  {
+    while(_pos < _end && isSpace(*_pos)) _pos++;
+    if(_pos < _end && *_pos == ',') _pos++;
+    while(_pos < _end && isSpace(*_pos)) _pos++;
+  }
+
+public:
+  explicit PathLexer(const char *data) : _pos(data), _end(data + strlen(data)) {}
+
+  /**
+   * @return the next command letter, or 0 at the end of the data. Anything else is skipped
+   */
+  char command()
+  {
+    while(_pos < _end) {
+      char c = *_pos++;
+      if(c != 'e' && c != 'E' && ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))) return c;
+    }
+    return 0;
+  }
+
+  /**
+   * read count numbers
+   *
+   * @return false if there were less than count numbers before the next command
+   */
+  bool numbers(float *values, unsigned count)
+  {
+    for(unsigned i=0; i<count; i++) {
+      skipSeparators();
+
+      const char *next = parseFloat(_pos, _end, values[i]);
+      if(next == _pos) return false;
+      _pos = next;
+    }
+    return true;
+  }
+
+  /**
+   * read a flag, which need not be separated from the next number
+   */
+  bool flag(float &value)
+  {
+    skipSeparators();
+
+    if(_pos < _end && (*_pos == '0' || *_pos == '1')) {
+      value = *_pos++ == '1' ? 1.0f : 0.0f;
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * read the parameters of an arc: rx ry x-axis-rotation large-arc-flag sweep-flag x y
+   */
+  bool arc(float *values)
+  {
+    return numbers(values, 3) && flag(values[3]) && flag(values[4]) && numbers(values + 5, 2);
+  }
+};
+
+}
+}
+
+#endif //THREE_PP_PATHLEXER_H
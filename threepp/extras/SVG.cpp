@@ -5,8 +5,10 @@
 #include <unordered_map>
 #include <regex>
 #include "SVG.h"
+#include "PathLexer.h"
 #include <3rdparty/tinyxml2/tinyxml2.h>
-#include <sstream>
+#include <cstring>
+#include <cstdint>
 #include <ctgmath>
 
 namespace three {
@@ -25,13 +27,6 @@ struct StyleData
   }
 };
 
-float _stof(const string &s) {
-  stringstream ss(s);
-  float ret;
-  ss >> ret;
-  return ret;
-}
-
 float reflection( float a, float b )
 {
   return a - ( b - a );
@@ -42,23 +37,32 @@ bool isVisible(const StyleData &data)
   return data.styles.find("fill") != data.styles.cend() && data.styles.at("fill") != "transparent";
 }
 
+//the declarations of a style attribute, "key: value; ..."
 void parseStyle(const XMLElement *element, StyleData &styleData )
 {
   styleData.resetLocal();
 
   const char *style = element->Attribute( "style" );
-  if(style) {
-    static const regex rex(R"(;?(([^:]+)\:([^;]+)))");
+  if(!style) return;
 
-    cregex_iterator rex_it(style, style + strlen(style), rex);
-    cregex_iterator rex_end;
+  for(const char *pos = style; *pos; ) {
+    const char *end = pos;
+    while(*end && *end != ';') end++;
 
-    while(rex_it != rex_end) {
-      cmatch match = *rex_it;
+    const char *colon = pos;
+    while(colon < end && *colon != ':') colon++;
 
-      styleData.styles[match[2]] = match[3];
-      rex_it++;
+    if(colon < end) {
+      const char *key = pos, *keyEnd = colon, *value = colon + 1, *valueEnd = end;
+      while(key < keyEnd && isSpace(*key)) key++;
+      while(keyEnd > key && isSpace(keyEnd[-1])) keyEnd--;
+      while(value < valueEnd && isSpace(*value)) value++;
+      while(valueEnd > value && isSpace(valueEnd[-1])) valueEnd--;
+
+      if(key < keyEnd && value < valueEnd)
+        styleData.styles[string(key, keyEnd)] = string(value, valueEnd);
     }
+    pos = *end ? end + 1 : end;
   }
 }
 
@@ -78,25 +82,6 @@ void applyColorStyle(const XMLElement *element, Color &color, StyleData &style)
   color.setStyle( fill );
 }
 
-vector<float> parseFloats( string data )
-{
-  static const regex rex(R"([+-]?\d*\.\d+|[+-]?\d+)");
-
-  vector<float> floats;
-
-  sregex_iterator rex_it(data.begin(), data.end(), rex);
-  sregex_iterator rex_end;
-
-  while(rex_it != rex_end) {
-    smatch match = *rex_it;
-
-    floats.push_back( _stof(match.str()) );
-    rex_it++;
-  }
-
-  return floats;
-}
-
 float svgAngle( float ux, float uy, float vx, float vy )
 {
   float dot = ux * vx + uy * vy;
@@ -171,34 +156,22 @@ void parseArcCommand( extras::ShapePath &path, float rx, float ry, float x_axis_
 
 void parsePathNode(const XMLElement *element, StyleData &style, vector<extras::ShapePath> &paths)
 {
-  static const regex rex("([a-df-z])([^a-df-z]*)", regex::icase);
-
   extras::ShapePath path;
   applyColorStyle(element, path.color, style);
 
   math::Vector2 point;
   math::Vector2 control;
 
-  const char *d = element->Attribute( "d" );
+  PathLexer lexer(element->Attribute( "d" ));
+  float n[7];
 
-  cregex_iterator rex_it(d, d + strlen(d), rex);
-  cregex_iterator rex_end;
-
-  vector<float> numbers;
-
-  while(rex_it != rex_end) {
-    cmatch match = *rex_it;
-    rex_it++;
-
-    char command = match[1].str().at(0);
-    string data = match[2];
+  while(char command = lexer.command()) {
 
     switch ( command ) {
 
       case 'M':
-        numbers = parseFloats( data );
-        for ( unsigned j = 0, jl = numbers.size(); j < jl; j += 2 ) {
-          point.set(numbers[ j + 0 ], numbers[ j + 1 ]);
+        while(lexer.numbers(n, 2)) {
+          point.set(n[ 0 ], n[ 1 ]);
           control = point;
 
           path.moveTo( point.x(), point.y() );
@@ -206,102 +179,94 @@ void parsePathNode(const XMLElement *element, StyleData &style, vector<extras::S
         break;
 
       case 'H':
-        numbers = parseFloats( data );
-        for ( unsigned j = 0, jl = numbers.size(); j < jl; j ++ ) {
-          point.x() = numbers[ j ];
+        while(lexer.numbers(n, 1)) {
+          point.x() = n[ 0 ];
           control = point;
           path.lineTo( point.x(), point.y(), true );
         }
         break;
 
       case 'V':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j ++ ) {
-          point.y() = numbers[ j ];
+        while(lexer.numbers(n, 1)) {
+          point.y() = n[ 0 ];
           control = point;
           path.lineTo( point.x(), point.y(), true );
         }
         break;
 
       case 'L':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j += 2 ) {
-          point.set(numbers[ j + 0 ], numbers[ j + 1 ]);
+        while(lexer.numbers(n, 2)) {
+          point.set(n[ 0 ], n[ 1 ]);
           control = point;
           path.lineTo( point.x(), point.y(), true );
         }
         break;
 
       case 'C':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j += 6 ) {
+        while(lexer.numbers(n, 6)) {
           path.bezierCurveTo(
-             numbers[ j + 0 ],
-             numbers[ j + 1 ],
-             numbers[ j + 2 ],
-             numbers[ j + 3 ],
-             numbers[ j + 4 ],
-             numbers[ j + 5 ]
+             n[ 0 ],
+             n[ 1 ],
+             n[ 2 ],
+             n[ 3 ],
+             n[ 4 ],
+             n[ 5 ]
           );
-          control.set(numbers[ j + 2 ], numbers[ j + 3 ]);
-          point.set(numbers[ j + 4 ], numbers[ j + 5 ]);
+          control.set(n[ 2 ], n[ 3 ]);
+          point.set(n[ 4 ], n[ 5 ]);
         }
         break;
 
       case 'S':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j += 4 ) {
+        while(lexer.numbers(n, 4)) {
           path.bezierCurveTo(
              reflection( point.x(), control.x() ),
              reflection( point.y(), control.y() ),
-             numbers[ j + 0 ],
-             numbers[ j + 1 ],
-             numbers[ j + 2 ],
-             numbers[ j + 3 ]
+             n[ 0 ],
+             n[ 1 ],
+             n[ 2 ],
+             n[ 3 ]
           );
-          control.set(numbers[ j + 0 ], numbers[ j + 1 ]);
-          point.set(numbers[ j + 2 ], numbers[ j + 3 ]);
+          control.set(n[ 0 ], n[ 1 ]);
+          point.set(n[ 2 ], n[ 3 ]);
         }
         break;
 
       case 'Q':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j += 4 ) {
+        while(lexer.numbers(n, 4)) {
           path.quadraticCurveTo(
-             numbers[ j + 0 ],
-             numbers[ j + 1 ],
-             numbers[ j + 2 ],
-             numbers[ j + 3 ]
+             n[ 0 ],
+             n[ 1 ],
+             n[ 2 ],
+             n[ 3 ]
           );
-          control.set(numbers[ j + 0 ], numbers[ j + 1 ]);
-          point.set(numbers[ j + 2 ], numbers[ j + 3 ]);
+          control.set(n[ 0 ], n[ 1 ]);
+          point.set(n[ 2 ], n[ 3 ]);
         }
         break;
 
       case 'T':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j += 2 ) {
+        while(lexer.numbers(n, 2)) {
           float rx = reflection( point.x(), control.x() );
           float ry = reflection( point.y(), control.y() );
           path.quadraticCurveTo(
              rx,
              ry,
-             numbers[ j + 0 ],
-             numbers[ j + 1 ]
+             n[ 0 ],
+             n[ 1 ]
           );
           control.set(rx, ry);
-          point.set(numbers[ j + 0 ], numbers[ j + 1 ]);
+          point.set(n[ 0 ], n[ 1 ]);
         }
         break;
 
       case 'A':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j += 7 ) {
+        while(lexer.arc(n)) {
           math::Vector2 start = point;
-          point.set(numbers[ j + 5 ], numbers[ j + 6 ]);
+          point.set(n[ 5 ], n[ 6 ]);
           control = point;
           parseArcCommand(
-             path, numbers[ j ], numbers[ j + 1 ], numbers[ j + 2 ], numbers[ j + 3 ], numbers[ j + 4 ], start, point
+             path, n[ 0 ], n[ 1 ], n[ 2 ], n[ 3 ], n[ 4 ], start, point
           );
         }
         break;
@@ -309,121 +274,112 @@ void parsePathNode(const XMLElement *element, StyleData &style, vector<extras::S
         //
 
       case 'm':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j += 2 ) {
-          point.x() += numbers[ j + 0 ];
-          point.y() += numbers[ j + 1 ];
+        while(lexer.numbers(n, 2)) {
+          point.x() += n[ 0 ];
+          point.y() += n[ 1 ];
           control = point;
           path.moveTo( point.x(), point.y() );
         }
         break;
 
       case 'h':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j ++ ) {
-          point.x() += numbers[ j ];
+        while(lexer.numbers(n, 1)) {
+          point.x() += n[ 0 ];
           control = point;
           path.lineTo( point.x(), point.y(), true );
         }
         break;
 
       case 'v':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j ++ ) {
-          point.y() += numbers[ j ];
+        while(lexer.numbers(n, 1)) {
+          point.y() += n[ 0 ];
           control = point;
           path.lineTo( point.x(), point.y(), true );
         }
         break;
 
       case 'l':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j += 2 ) {
-          point.x() += numbers[ j + 0 ];
-          point.y() += numbers[ j + 1 ];
+        while(lexer.numbers(n, 2)) {
+          point.x() += n[ 0 ];
+          point.y() += n[ 1 ];
           control = point;
           path.lineTo( point.x(), point.y(), true );
         }
         break;
 
       case 'c':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j += 6 ) {
+        while(lexer.numbers(n, 6)) {
           path.bezierCurveTo(
-             point.x() + numbers[ j + 0 ],
-             point.y() + numbers[ j + 1 ],
-             point.x() + numbers[ j + 2 ],
-             point.y() + numbers[ j + 3 ],
-             point.x() + numbers[ j + 4 ],
-             point.y() + numbers[ j + 5 ]
+             point.x() + n[ 0 ],
+             point.y() + n[ 1 ],
+             point.x() + n[ 2 ],
+             point.y() + n[ 3 ],
+             point.x() + n[ 4 ],
+             point.y() + n[ 5 ]
           );
-          control.x() = point.x() + numbers[ j + 2 ];
-          control.y() = point.y() + numbers[ j + 3 ];
-          point.x() += numbers[ j + 4 ];
-          point.y() += numbers[ j + 5 ];
+          control.x() = point.x() + n[ 2 ];
+          control.y() = point.y() + n[ 3 ];
+          point.x() += n[ 4 ];
+          point.y() += n[ 5 ];
         }
         break;
 
       case 's':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j += 4 ) {
+        while(lexer.numbers(n, 4)) {
           path.bezierCurveTo(
              reflection( point.x(), control.x() ),
              reflection( point.y(), control.y() ),
-             point.x() + numbers[ j + 0 ],
-             point.y() + numbers[ j + 1 ],
-             point.x() + numbers[ j + 2 ],
-             point.y() + numbers[ j + 3 ]
+             point.x() + n[ 0 ],
+             point.y() + n[ 1 ],
+             point.x() + n[ 2 ],
+             point.y() + n[ 3 ]
           );
-          control.x() = point.x() + numbers[ j + 0 ];
-          control.y() = point.y() + numbers[ j + 1 ];
-          point.x() += numbers[ j + 2 ];
-          point.y() += numbers[ j + 3 ];
+          control.x() = point.x() + n[ 0 ];
+          control.y() = point.y() + n[ 1 ];
+          point.x() += n[ 2 ];
+          point.y() += n[ 3 ];
         }
         break;
 
       case 'q':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j += 4 ) {
+        while(lexer.numbers(n, 4)) {
           path.quadraticCurveTo(
-             point.x() + numbers[ j + 0 ],
-             point.y() + numbers[ j + 1 ],
-             point.x() + numbers[ j + 2 ],
-             point.y() + numbers[ j + 3 ]
+             point.x() + n[ 0 ],
+             point.y() + n[ 1 ],
+             point.x() + n[ 2 ],
+             point.y() + n[ 3 ]
           );
-          control.x() = point.x() + numbers[ j + 0 ];
-          control.y() = point.y() + numbers[ j + 1 ];
-          point.x() += numbers[ j + 2 ];
-          point.y() += numbers[ j + 3 ];
+          control.x() = point.x() + n[ 0 ];
+          control.y() = point.y() + n[ 1 ];
+          point.x() += n[ 2 ];
+          point.y() += n[ 3 ];
         }
         break;
 
       case 't':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j += 2 ) {
+        while(lexer.numbers(n, 2)) {
           float rx = reflection( point.x(), control.x() );
           float ry = reflection( point.y(), control.y() );
           path.quadraticCurveTo(
              rx,
              ry,
-             point.x() + numbers[ j + 0 ],
-             point.y() + numbers[ j + 1 ]
+             point.x() + n[ 0 ],
+             point.y() + n[ 1 ]
           );
           control.set(rx, ry);
-          point.x() = point.x() + numbers[ j + 0 ];
-          point.y() = point.y() + numbers[ j + 1 ];
+          point.x() = point.x() + n[ 0 ];
+          point.y() = point.y() + n[ 1 ];
         }
         break;
 
       case 'a':
-        numbers = parseFloats( data );
-        for ( unsigned j=0, jl=numbers.size(); j < jl; j += 7 ) {
+        while(lexer.arc(n)) {
           math::Vector2 start = point;
-          point.x() += numbers[ j + 5 ];
-          point.y() += numbers[ j + 6 ];
+          point.x() += n[ 5 ];
+          point.y() += n[ 6 ];
           control = point;
           parseArcCommand(
-             path, numbers[ j ], numbers[ j + 1 ], numbers[ j + 2 ], numbers[ j + 3 ], numbers[ j + 4 ], start, point
+             path, n[ 0 ], n[ 1 ], n[ 2 ], n[ 3 ], n[ 4 ], start, point
           );
         }
         break;
@@ -473,28 +429,20 @@ void parseRectNode(const XMLElement *element, StyleData &style, vector<extras::S
 
 void parsePolyNode(const XMLElement *element, StyleData &style, vector<extras::ShapePath> &paths, bool closed)
 {
-  static const regex rex(R"((-?[\d\.?]+)[,|\s](-?[\d\.?]+))");
-
   extras::ShapePath path;
   applyColorStyle(element, path.color, style);
 
   unsigned index = 0;
 
   const char *points = element->Attribute( "points" );
-  cregex_iterator rex_it(points, points + strlen(points), rex);
-  cregex_iterator rex_end;
-
-  while(rex_it != rex_end) {
-    std::cmatch match = *rex_it;
-
-    float x = _stof(match[1]);
-    float y = _stof(match[2]);
+  PathLexer lexer(points ? points : "");
+  float xy[2];
 
-    if(index == 0) path.moveTo(x, y);
-    else path.lineTo(x, y);
+  while(lexer.numbers(xy, 2)) {
+    if(index == 0) path.moveTo(xy[0], xy[1]);
+    else path.lineTo(xy[0], xy[1]);
 
     index++;
-    rex_it++;
   }
 
   path.currentPath->setAutoClose(closed);
@@ -9,8 +9,8 @@ namespace extras {
 
 std::vector<ShapePath> Font::createPaths(const std::wstring &text, float size) const
 {
-  float scale = size / _data.resolution;
-  float line_height = (_data.boundingBox.max().y() - _data.boundingBox.min().y() + _data.underlineThickness) * scale;
+  float scale = size / _data->resolution;
+  float line_height = lineHeight(size);
 
   std::vector<ShapePath> paths;
 
@@ -36,7 +36,7 @@ std::vector<ShapePath> Font::createPaths(const std::wstring &text, float size) c
 
 float Font::createPath(wchar_t c, float scale, float offsetX, float offsetY, std::vector<ShapePath> &paths) const
 {
-  Glyph glyph = _data.glyphAt(c);
+  const Glyph &glyph = _data->glyphAt(c);
 
   paths.emplace_back();
   ShapePath &path = paths.back();
@@ -45,7 +45,7 @@ float Font::createPath(wchar_t c, float scale, float offsetX, float offsetY, std
   return glyph.ha * scale;
 }
 
-void Glyph::apply(ShapePath &path, float scale, float offsetX, float offsetY)
+void Glyph::apply(ShapePath &path, float scale, float offsetX, float offsetY) const
 {
   float x, y, cpx, cpy, cpx1, cpy1, cpx2, cpy2;
 
@@ -4,6 +4,7 @@
 #include "ShapePath.h"
 #include <threepp/math/Box2.h>
 #include <unordered_map>
+#include <memory>
 
 namespace three {
 namespace extras {
@@ -24,7 +25,7 @@ public:
   int ha;
 
   /** apply the commands to the given path */
-  void apply(ShapePath &path, float scale, float offsetX, float offsetY);
+  void apply(ShapePath &path, float scale, float offsetX, float offsetY) const;
 
   /** add a move command */
   void moveTo(int x, int y);
@@ -65,11 +66,12 @@ public:
 };
 
 /**
- * Font wraps a FontData and adds the capability of creating Shapes
+ * Font wraps a FontData and adds the capability of creating Shapes. The data is shared between
+ * copies of a Font
  */
 class Font
 {
-  FontData _data;
+  std::shared_ptr<const FontData> _data;
 
   float createPath(wchar_t c,
                    float scale,
@@ -79,14 +81,8 @@ class Font
 
   std::vector<ShapePath> createPaths(const std::wstring &text, float size) const;
 
-public:
-  explicit Font(const FontData &data) : _data(data)
-  {}
-
-  std::vector<Shape::Ptr> generateShapes(const std::wstring &text, float size) const
+  static std::vector<Shape::Ptr> toShapes(const std::vector<ShapePath> &paths)
   {
-    const auto &paths = createPaths(text, size);
-
     std::vector<Shape::Ptr> shapes;
 
     for (const auto &path : paths) {
@@ -97,6 +93,40 @@ public:
 
     return shapes;
   }
+
+public:
+  explicit Font(const FontData &data) : _data(std::make_shared<FontData>(data))
+  {}
+
+  explicit Font(const std::shared_ptr<const FontData> &data) : _data(data)
+  {}
+
+  const FontData &data() const {return *_data;}
+
+  /** the distance between the baselines of two lines of text */
+  float lineHeight(float size) const
+  {
+    return (_data->boundingBox.max().y() - _data->boundingBox.min().y() + _data->underlineThickness)
+           * size / _data->resolution;
+  }
+
+  std::vector<Shape::Ptr> generateShapes(const std::wstring &text, float size) const
+  {
+    return toShapes(createPaths(text, size));
+  }
+
+  /**
+   * generate the shapes of a single glyph placed at the origin
+   *
+   * @param advance receives the horizontal distance to the next glyph
+   */
+  std::vector<Shape::Ptr> generateShapes(wchar_t c, float size, float &advance) const
+  {
+    std::vector<ShapePath> paths;
+    advance = createPath(c, size / _data->resolution, 0, 0, paths);
+
+    return toShapes(paths);
+  }
 };
 
 }
@@ -571,6 +571,11 @@ void Builder::addShape( Shape::Ptr shape )
 }
 
 Extrude::Extrude(const std::vector<Shape::Ptr> &shapes, const ExtrudeOptions &options)
+{
+  build(shapes, options);
+}
+
+void Extrude::build(const std::vector<Shape::Ptr> &shapes, const ExtrudeOptions &options)
 {
   Builder builder(options, *this);
 
@@ -610,7 +615,7 @@ void WorldUVGenerator::generateSideWallUV(const attribute::growing_t<float, Vert
   const auto &itemC = positions->item(indexC);
   const auto &itemD = positions->item(indexD);
 
-  if ( abs( itemA.y() - itemB.y() ) < 0.01 ) {
+  if ( sideWallAlongX( itemA, itemB ) ) {
 
     uvs->next() = {itemA.x(), 1 - itemA.z()}; //0
     uvs->next() = {itemB.x(), 1 - itemB.z()}; //1
@@ -38,6 +38,14 @@ struct WorldUVGenerator : public UVGenerator
     return Ptr(new WorldUVGenerator());
   }
 
+  /**
+   * @return whether the u coordinate of a side wall quad follows x (otherwise y). A and B are
+   * the first two corners of the quad
+   */
+  static bool sideWallAlongX(const Vertex &a, const Vertex &b) {
+    return std::abs(a.y() - b.y()) < 0.01;
+  }
+
   void generateTopUV(const attribute::growing_t<float, Vertex> &positions,
                      attribute::growing_t<float, UV> &uvs,
                      unsigned indexA,
@@ -142,6 +150,10 @@ class DLX Extrude : public BufferGeometry
 protected:
   Extrude(const std::vector<extras::Shape::Ptr> &shapes, const ExtrudeOptions &options);
 
+  Extrude() = default;
+
+  void build(const std::vector<extras::Shape::Ptr> &shapes, const ExtrudeOptions &options);
+
 public:
   using Ptr = std::shared_ptr<Extrude>;
 
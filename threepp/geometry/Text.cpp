@@ -34,9 +34,145 @@ static inline std::vector<extras::Shape::Ptr> makeShapes(const std::wstring &tex
 }
 
 Text::Text(const std::wstring &text, const TextOptions &options)
-   : Extrude(makeShapes(text, options), extrudeOptions(options))
+{
+  if(options.glyphCache && options.glyphCache->matches(options))
+    options.glyphCache->assemble(text, *this);
+  else
+    build(makeShapes(text, options), extrudeOptions(options));
+}
+
+}
+
+GlyphCache::GlyphCache(const TextOptions &options)
+   : _font(options.font), _size(options.size), _options(buffer::extrudeOptions(options))
 {}
 
+GlyphCache::Ptr GlyphCache::get(const TextOptions &options)
+{
+  static std::mutex mutex;
+  static std::vector<std::weak_ptr<GlyphCache>> caches;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  for(auto it = caches.begin(); it != caches.end(); ) {
+    Ptr cache = it->lock();
+    if(!cache) {
+      it = caches.erase(it);
+      continue;
+    }
+    if(cache->matches(options)) return cache;
+    it++;
+  }
+
+  Ptr cache(new GlyphCache(options));
+  caches.push_back(cache);
+  return cache;
+}
+
+bool GlyphCache::matches(const TextOptions &options) const
+{
+  return &_font.data() == &options.font.data() && _size == options.size
+         && _options.depth == options.height && _options.curveSegments == options.curveSegments
+         && _options.bevelEnabled == options.bevelEnabled
+         && _options.bevelThickness == options.bevelThickness && _options.bevelSize == options.bevelSize;
+}
+
+const GlyphCache::Glyph &GlyphCache::glyph(wchar_t c)
+{
+  auto found = _glyphs.find(c);
+  if(found != _glyphs.end()) return found->second;
+
+  Glyph &glyph = _glyphs[c];
+
+  buffer::Extrude::Ptr extrude = buffer::Extrude::make(_font.generateShapes(c, _size, glyph.advance), _options);
+
+  const BufferAttributeT<float> &position = *extrude->position();
+  const BufferAttributeT<float> &normal = *extrude->normal();
+
+  //the extrusion has one lid and one side group per shape
+  for(const Group &group : extrude->groups()) {
+    bool lid = group.materialIndex == 0;
+
+    std::vector<Vertex> &positions = lid ? glyph.lidPositions : glyph.sidePositions;
+    std::vector<Vertex> &normals = lid ? glyph.lidNormals : glyph.sideNormals;
+
+    for(uint32_t i=group.start, end=group.start + group.count; i<end; i++) {
+      positions.emplace_back(position.get_x(i), position.get_y(i), position.get_z(i));
+      normals.emplace_back(normal.get_x(i), normal.get_y(i), normal.get_z(i));
+    }
+
+    //side walls are made of quads, 6 vertices each
+    if(!lid) {
+      for(size_t q = positions.size() - group.count; q < positions.size(); q += 6)
+        glyph.sideAlongX.push_back(WorldUVGenerator::sideWallAlongX(positions[q], positions[q + 3]));
+    }
+  }
+
+  return glyph;
+}
+
+void GlyphCache::assemble(const std::wstring &text, BufferGeometry &geometry)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  struct Placement
+  {
+    const Glyph *glyph;
+    Vertex offset;
+  };
+  std::vector<Placement> placements;
+  placements.reserve(text.size());
+
+  size_t lidCount = 0, sideCount = 0;
+  float offsetX = 0, offsetY = 0;
+  float lineHeight = _font.lineHeight(_size);
+
+  for(wchar_t c : text) {
+
+    if(c == '\n') {
+      offsetX = 0;
+      offsetY -= lineHeight;
+      continue;
+    }
+
+    const Glyph &g = glyph(c);
+    placements.push_back({&g, Vertex(offsetX, offsetY, 0)});
+
+    lidCount += g.lidPositions.size();
+    sideCount += g.sidePositions.size();
+    offsetX += g.advance;
+  }
+
+  auto positions = attribute::prealloc<float, Vertex>(lidCount + sideCount);
+  auto normals = attribute::prealloc<float, Vertex>(lidCount + sideCount);
+  auto uvs = attribute::prealloc<float, UV>(lidCount + sideCount);
+
+  //all lids first, then all sides, so each material is drawn with one call
+  for(const Placement &placement : placements) {
+    const Glyph &g = *placement.glyph;
+
+    for(size_t i=0, l=g.lidPositions.size(); i<l; i++) {
+      const Vertex &position = positions->next() = g.lidPositions[i] + placement.offset;
+      normals->next() = g.lidNormals[i];
+      uvs->next() = {position.x(), position.y()};
+    }
+  }
+  for(const Placement &placement : placements) {
+    const Glyph &g = *placement.glyph;
+
+    for(size_t i=0, l=g.sidePositions.size(); i<l; i++) {
+      const Vertex &position = positions->next() = g.sidePositions[i] + placement.offset;
+      normals->next() = g.sideNormals[i];
+      uvs->next() = {g.sideAlongX[i / 6] ? position.x() : position.y(), 1 - position.z()};
+    }
+  }
+
+  geometry.addGroup(0, lidCount, 0);
+  geometry.addGroup(lidCount, sideCount, 1);
+
+  geometry.setPosition(positions);
+  geometry.setNormal(normals);
+  geometry.setUV(uvs);
 }
 }
 }
\ No newline at end of file
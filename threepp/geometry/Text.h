@@ -6,6 +6,8 @@
 #define THREE_PP_TEXT_H
 
 #include <string>
+#include <mutex>
+#include <unordered_map>
 #include <threepp/core/LinearGeometry.h>
 #include <threepp/core/BufferGeometry.h>
 #include <threepp/geometry/Extrude.h>
@@ -14,6 +16,8 @@
 namespace three {
 namespace geometry {
 
+class GlyphCache;
+
 struct TextOptions
 {
   extras::Font font;
@@ -25,9 +29,65 @@ struct TextOptions
   float bevelThickness = 10;
   float bevelSize = 8;
 
+  // glyph geometry to build the text from, see GlyphCache. Ignored if the cache was created for
+  // another font or other options
+  std::shared_ptr<GlyphCache> glyphCache;
+
   explicit TextOptions(const extras::Font &font) : font(font) {}
 };
 
+/**
+ * the extruded geometry of the glyphs of one font, for one set of text options. Text built with
+ * a cache copies the geometry of each character instead of triangulating and extruding the
+ * outlines again, which makes text that changes often, or many labels in the same font, cheap.
+ *
+ * The geometry of a glyph is created when it is first used. Text built from a cache has world UVs
+ * (see WorldUVGenerator) and two groups, holding all lids (material 0) and all sides (material 1).
+ */
+class DLX GlyphCache
+{
+  struct Glyph
+  {
+    //non-indexed triangles, placed at the origin
+    std::vector<Vertex> lidPositions, lidNormals;
+    std::vector<Vertex> sidePositions, sideNormals;
+
+    //for each side wall quad, see WorldUVGenerator::sideWallAlongX
+    std::vector<bool> sideAlongX;
+
+    float advance = 0;
+  };
+
+  const extras::Font _font;
+  const float _size;
+  const ExtrudeOptions _options;
+
+  std::unordered_map<wchar_t, Glyph> _glyphs;
+  std::mutex _mutex;
+
+  explicit GlyphCache(const TextOptions &options);
+
+  const Glyph &glyph(wchar_t c);
+
+public:
+  using Ptr = std::shared_ptr<GlyphCache>;
+
+  /**
+   * @return the cache for the font and options. Caches are shared as long as they are in use
+   */
+  static Ptr get(const TextOptions &options);
+
+  /**
+   * @return whether this cache was created for the font and options
+   */
+  bool matches(const TextOptions &options) const;
+
+  /**
+   * set the position, normal and uv attributes and the groups of geometry for the text
+   */
+  void assemble(const std::wstring &text, BufferGeometry &geometry);
+};
+
 class Text : public LinearGeometry
 {
 protected:
@@ -47,7 +47,7 @@ public:
   }
 
   void update() {
-    _matrix = _camera->matrixWorld();
+    matrix() = _camera->matrixWorld();
     Maker::update(_camera);
   }
 };
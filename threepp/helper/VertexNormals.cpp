@@ -34,7 +34,7 @@ struct LinearGeometryAccess
         auto normal = face.vertexNormals[ j ];
 
         vertex.apply( helper._object->matrixWorld() );
-        normal.apply( math::Matrix4::rotation(helper._object->rotation()) );
+        normal.apply( math::Matrix4::rotation(helper._object->crotation()) );
 
         normal *= helper._config.size;
         normal += vertex;
@@ -68,7 +68,7 @@ struct BufferGeometryAccess
       vertex.apply( helper._object->matrixWorld() );
 
       math::Vector3 normal( objNorm->get_x( j ), objNorm->get_y( j ), objNorm->get_z( j ) );
-      normal.apply( math::Matrix4::rotation(helper._object->rotation()) );
+      normal.apply( math::Matrix4::rotation(helper._object->crotation()) );
       normal *= helper._config.size;
       normal += vertex;
 
@@ -5,12 +5,84 @@
 #ifndef THREEPP_DIRECTIONALLIGHT_H
 #define THREEPP_DIRECTIONALLIGHT_H
 
+#include <algorithm>
 #include <threepp/camera/OrthographicCamera.h>
 #include "TargetLight.h"
 
 namespace three {
 
-using DirectionalLightShadow = LightShadowT<OrthographicCamera>;
+/**
+ * directional light shadow, optionally split into up to 4 cascades. Cascades divide the view
+ * frustum along its depth and render each part into a tile of the shadow map, so that near
+ * objects get more shadow map texels than far ones. mapSize is the size of one tile.
+ *
+ * With cascades, the left, right, top and bottom planes of the shadow camera are fitted to the
+ * view frustum each frame. Near and far still define the depth range along the light direction
+ */
+class DirectionalLightShadow : public LightShadowT<OrthographicCamera>
+{
+  unsigned _cascades = 1;
+  float _cascadeSplitLambda = 0.75f;
+  float _cascadeDistance = 0;
+
+  //offset.xy and scale.zw from the shadow coordinate to each cascade's tile, one column per cascade
+  math::Matrix4 _cascadeMatrix;
+
+  explicit DirectionalLightShadow(OrthographicCamera::Ptr camera) : LightShadowT(camera)
+  {
+    setCascades(1);
+  }
+
+public:
+  using Ptr = std::shared_ptr<DirectionalLightShadow>;
+  static Ptr make(OrthographicCamera::Ptr camera) {
+    return Ptr(new DirectionalLightShadow(camera));
+  }
+
+  static const unsigned maxCascades = 4;
+
+  unsigned cascades() const {return _cascades;}
+
+  /**
+   * set the number of cascades, at most maxCascades. Releases the shadow map, which is recreated
+   * with a matching tile layout
+   */
+  void setCascades(unsigned cascades)
+  {
+    _cascades = std::max(1u, std::min(cascades, maxCascades));
+    _map = nullptr;
+
+    //a single cascade covers the whole shadow coordinate range
+    float *e = _cascadeMatrix.elements();
+    std::fill(e, e + 16, 0.0f);
+    e[2] = e[3] = 1.0f;
+  }
+
+  /**
+   * blend between logarithmic (1) and uniform (0) split distances
+   */
+  float cascadeSplitLambda() const {return _cascadeSplitLambda;}
+  float &cascadeSplitLambda() {return _cascadeSplitLambda;}
+
+  /**
+   * view distance covered by the cascades, 0 for the camera's far plane
+   */
+  float cascadeDistance() const {return _cascadeDistance;}
+  float &cascadeDistance() {return _cascadeDistance;}
+
+  const math::Matrix4 &cascadeMatrix() const {return _cascadeMatrix;}
+  math::Matrix4 &cascadeMatrix() {return _cascadeMatrix;}
+
+  /**
+   * @return the number of tile columns and rows in the shadow map
+   */
+  unsigned columns() const {return _cascades > 1 ? 2 : 1;}
+  unsigned rows() const {return _cascades > 2 ? 2 : 1;}
+
+  DirectionalLightShadow *cloned() const override {
+    return new DirectionalLightShadow(*this);
+  }
+};
 
 class DirectionalLight : public TargetLight
 {
@@ -2,6 +2,7 @@
 // Created by byter on 1/6/18.
 //
 #include "Assimp.h"
+#include "SceneCache.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/ProgressHandler.hpp>
@@ -16,6 +17,8 @@
 #include <threepp/material/MeshStandardMaterial.h>
 #include <threepp/textures/ImageTexture.h>
 #include <threepp/textures/DataTexture.h>
+#include <threepp/math/Vector4.h>
+#include <threepp/util/ThreadPool.h>
 
 #include <QDebug>
 
@@ -151,25 +154,69 @@ const char *to_string(aiTextureType type)
   }
 }
 
+/**
+ * reports progress through Loader::onProgress. Reading and post-processing take up the first 80%,
+ * the conversion into the scene cache the rest
+ */
 class ProgressHandler : public as::ProgressHandler
 {
+  Signal<void(float)> &_progress;
+
+  static float fraction(unsigned step, unsigned steps)
+  {
+    return steps ? (float)step / steps : 1.0f;
+  }
+
 public:
+  explicit ProgressHandler(Signal<void(float)> &progress) : _progress(progress) {}
+
   bool Update(float percentage) override
   {
+    _progress.emitSignal(percentage);
     return false;
   }
 
   void UpdateFileRead(int currentStep, int numberOfSteps) override
   {
-    as::ProgressHandler::UpdateFileRead(currentStep, numberOfSteps);
+    Update(fraction(currentStep, numberOfSteps) * 0.4f);
   }
 
   void UpdatePostProcess(int currentStep, int numberOfSteps) override
   {
-    as::ProgressHandler::UpdatePostProcess(currentStep, numberOfSteps);
+    Update(0.4f + fraction(currentStep, numberOfSteps) * 0.4f);
   }
+
+  void UpdateConversion(unsigned currentStep, unsigned numberOfSteps)
+  {
+    Update(0.8f + fraction(currentStep, numberOfSteps) * 0.2f);
+  }
+};
+
+//the texture types read by the materials
+const aiTextureType textureTypes[] = {
+   aiTextureType_DIFFUSE, aiTextureType_UNKNOWN, aiTextureType_SPECULAR, aiTextureType_AMBIENT,
+   aiTextureType_EMISSIVE, aiTextureType_HEIGHT, aiTextureType_NORMALS, aiTextureType_OPACITY,
+   aiTextureType_DISPLACEMENT, aiTextureType_LIGHTMAP, aiTextureType_REFLECTION
 };
 
+/**
+ * determine the texture format for an image, converting the image if the format is not supported
+ */
+TextureFormat textureFormat(QImage &image)
+{
+  switch(image.format()) {
+    case QImage::Format_RGBA8888:
+      return TextureFormat::RGBA;
+    case QImage::Format_RGB888:
+      return TextureFormat::RGB;
+    case QImage::Format_Grayscale8:
+      return TextureFormat::Luminance;
+    default:
+      image = image.convertToFormat(QImage::Format_RGB888);
+      return TextureFormat::RGB;
+  }
+}
+
 class MeshMaker
 {
 public:
@@ -185,7 +232,8 @@ struct Access
   friend class MeshMaker;
 
   Scene::Ptr scene;
-  const aiScene * aiscene;
+  SceneCache::Ptr cache;
+  const vector<const aiMaterial *> &aimaterials;
   ResourceLoader &loader;
   enum_map<ShadingModel, ShadingModel> &modelMap;
 
@@ -195,35 +243,31 @@ struct Access
 
   const AssimpMaterialHandler *materialHandler = nullptr;
 
-  Access(Scene::Ptr scene, const aiScene * aiscene,
+  Access(Scene::Ptr scene, SceneCache::Ptr cache,
+         const vector<const aiMaterial *> &aimaterials,
          ResourceLoader &loader,
          enum_map<ShadingModel, ShadingModel> &modelMap,
          const AssimpMaterialHandler *materialHandler)
-     : scene(scene), aiscene(aiscene), loader(loader), modelMap(modelMap), materialHandler(materialHandler) {}
+     : scene(scene), cache(cache), aimaterials(aimaterials), loader(loader), modelMap(modelMap),
+       materialHandler(materialHandler) {}
 
   void readMaterial(unsigned materialIndex);
 
-  BufferAttributeT<float>::Ptr readUVChannel(unsigned index, const aiMesh *mesh);
+  Mesh::Ptr readMesh(unsigned index);
 
-  Mesh::Ptr readMesh(int index);
+  void readObject(const SceneCache::Node &node, Object3D::Ptr object);
 
-  void readObject(const aiNode *ai, Object3D::Ptr object);
+  void readImages();
 
   void readScene()
   {
-    for(unsigned i=0; i<aiscene->mNumMaterials; i++) {
+    readImages();
+
+    for(unsigned i=0; i<aimaterials.size(); i++) {
       readMaterial(i);
     }
 
-    readObject(aiscene->mRootNode, scene);
-
-    for(int i=0; i<aiscene->mNumMeshes; i++) {
-      //hookupSkeletons(ai->mMeshes[i], scene);
-    }
-    if(aiscene->mNumAnimations > 0) {
-      //Animation::Ptr animation = Animation::make();
-      //readAnimation(ai->mAnimations[0], animation);
-    }
+    readObject(cache->root, scene);
   }
 
   Texture::Ptr loadTexture(aiTextureType type, unsigned index, const aiMaterial *material);
@@ -484,10 +528,6 @@ Texture::Ptr Access::loadTexture(aiTextureType type, unsigned index, const aiMat
       qWarning() << "UV index" << uvindex << "not used";
     }
     if(path.data[0] == '*') {
-      unsigned index = atoi(path.data + 1);
-      aiTexture *tex = aiscene->mTextures[index];
-
-      TextureOptions options = DataTexture::options();
       //return DataTexture::make(options, image);
       qWarning() << path.C_Str()  << ": embedded textures not (yet) supported";
     }
@@ -507,20 +547,7 @@ Texture::Ptr Access::loadTexture(aiTextureType type, unsigned index, const aiMat
         qWarning() << "error loading image" << imageFile.c_str();
       else {
         auto fmt = image.format();
-        switch(image.format()) {
-          case QImage::Format_RGBA8888:
-            options.format = TextureFormat::RGBA;
-            break;
-          case QImage::Format_RGB888:
-            options.format = TextureFormat::RGB;
-            break;
-          case QImage::Format_Grayscale8:
-            options.format = TextureFormat::Luminance;
-            break;
-          default:
-            image = image.convertToFormat(QImage::Format_RGB888);
-            options.format = TextureFormat::RGB;
-        }
+        options.format = textureFormat(image);
         qDebug() << "loaded texture" << imageFile.c_str() << "(" << fmt << to_string(type) << ")";
       }
 
@@ -594,55 +621,78 @@ Texture::Ptr Access::loadTexture(aiTextureType type, unsigned index, const aiMat
   return nullptr;
 }
 
-void Access::readObject(const aiNode *ai, Object3D::Ptr object)
+void Access::readImages()
+{
+  vector<string> files;
+  for(const aiMaterial *material : aimaterials) {
+    for(aiTextureType type : textureTypes) {
+      aiString path;
+      if(material->GetTexture(type, 0, &path) == AI_SUCCESS && path.data[0] != '*') {
+        string file(path.C_Str());
+        if(find(files.begin(), files.end(), file) == files.end()) files.push_back(file);
+      }
+    }
+  }
+
+  //decode on the pool, so the images are found in the cache once the materials are read
+  vector<QImage> decoded(files.size());
+  ThreadPool::instance().parallelFor(0, files.size(), 1, [&](size_t begin, size_t end) {
+    for(size_t i=begin; i<end; i++) {
+      loader.load(decoded[i], files[i]);
+      if(!decoded[i].isNull()) textureFormat(decoded[i]);
+    }
+  });
+
+  for(size_t i=0; i<files.size(); i++) images[files[i]] = decoded[i];
+}
+
+void Access::readObject(const SceneCache::Node &node, Object3D::Ptr object)
 {
-  object->_name = ai->mName.C_Str();
+  object->_name = node.name;
 
-  const aiMatrix4x4 & m = ai->mTransformation;
+  const float *m = node.matrix;
   object->_matrix.set(
-     m.a1, m.a2, m.a3, m.a4, m.b1, m.b2, m.b3, m.b4, m.c1, m.c2, m.c3, m.c4, m.d1, m.d2, m.d3, m.d4);
+     m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8], m[9], m[10], m[11], m[12], m[13], m[14], m[15]);
 
-  for(unsigned i=0; i<ai->mNumMeshes; i++) {
-    Mesh::Ptr mesh = readMesh(ai->mMeshes[i]);
+  for(unsigned index : node.meshes) {
+    Mesh::Ptr mesh = readMesh(index);
     object->add(mesh);
   }
 
-  for(unsigned i=0; i<ai->mNumChildren; i++) {
+  for(const SceneCache::Node &child : node.children) {
     Node::Ptr node = Node::make();
-    readObject(ai->mChildren[i], node);
+    readObject(child, node);
     object->add(node);
   }
 
   object->_matrix.decompose(object->_position, object->_quaternion, object->_scale);
 }
 
-BufferAttributeT<float>::Ptr Access::readUVChannel(unsigned index, const aiMesh *ai)
+//the attributes share ownership of the cache
+BufferAttributeT<float>::Ptr toAttribute(const SceneCache::Block &block, const SceneCache::Ptr &cache)
 {
-  if(ai->mTextureCoords[index]) {
-    if(ai->mNumUVComponents[index] != 2)
-      qWarning() << ai->mNumUVComponents[index] << "UV components found, 2 used";
-
-    auto uvs = attribute::prealloc<float, UV>(ai->mNumVertices);
-
-    for(unsigned i=0; i<ai->mNumVertices; i++) {
-      aiVector3t<float> &aiuv = ai->mTextureCoords[index][i];
-      uvs->next().set(aiuv.x, aiuv.y);
-    }
-    return uvs;
+  switch(block.data ? block.itemSize : 0) {
+    case 2:
+      return attribute::external<float, UV>(block.data, block.count, cache);
+    case 3:
+      return attribute::external<float, Vertex>(block.data, block.count, cache);
+    case 4:
+      return attribute::external<float, math::Vector4>(block.data, block.count, cache);
+    default:
+      return nullptr;
   }
-  return nullptr;
 }
 
-Mesh::Ptr Access::readMesh(int index)
+Mesh::Ptr Access::readMesh(unsigned index)
 {
   if(meshes.count(index) > 0) return meshes[index];
 
-  aiMesh *ai = aiscene->mMeshes[index];
+  const SceneCache::Mesh &data = cache->meshes[index];
   Mesh::Ptr mesh;
 
   BufferGeometry::Ptr geometry = BufferGeometry::make();
-  if(makers.count(ai->mMaterialIndex)) {
-    mesh = makers[ai->mMaterialIndex]->makeMesh(geometry);
+  if(makers.count(data.material)) {
+    mesh = makers[data.material]->makeMesh(geometry);
   }
   else {
     MeshLambertMaterial::Ptr mat = MeshLambertMaterial::make();
@@ -650,48 +700,19 @@ Mesh::Ptr Access::readMesh(int index)
   }
 
   if(mesh->_name.empty())
-    mesh->_name = ai->mName.C_Str();
-
-  auto indices = attribute::growing<uint32_t>(true);
+    mesh->_name = data.name;
 
-  for(unsigned i=0; i<ai->mNumFaces; i++) {
-    aiFace &f = ai->mFaces[i];
-    if ( f.mNumIndices == 3 ) {
+  geometry->setIndex(attribute::external<uint32_t, uint32_t>(data.index.data, data.index.count, cache));
 
-      indices->next() = f.mIndices[ 0 ];
-      indices->next() = f.mIndices[ 1 ];
-      indices->next() = f.mIndices[ 2 ];
-    }
-    else if ( f.mNumIndices == 4 ) {
+  geometry->setPosition(toAttribute(data.position, cache));
+  geometry->setNormal(toAttribute(data.normal, cache));
+  geometry->setColor(toAttribute(data.color, cache));
 
-      indices->next() = f.mIndices[ 0 ];
-      indices->next() = f.mIndices[ 1 ];
-      indices->next() = f.mIndices[ 2 ];
-      indices->next() = f.mIndices[ 2 ];
-      indices->next() = f.mIndices[ 3 ];
-      indices->next() = f.mIndices[ 0 ];
-    }
-  }
-  geometry->setIndex(indices);
+  geometry->setUV(toAttribute(data.uv, cache));
+  geometry->setUV2(toAttribute(data.uv2, cache));
 
-  geometry->setPosition(attribute::external<float, Vertex>(ai->mVertices, ai->mNumVertices));
-
-  if(ai->mNormals) {
-    geometry->setNormal(attribute::external<float, Vertex>(ai->mNormals, ai->mNumVertices));
-  }
-  if(ai->mColors[0]) {
-    geometry->setColor(attribute::external<float, Color>(ai->mColors[0], ai->mNumVertices));
-  }
-
-  geometry->setUV(readUVChannel(0, ai));
-  geometry->setUV2(readUVChannel(1, ai));
-
-  if(ai->mTangents) {
-    geometry->setTangents(attribute::external<float, Vertex>(ai->mTangents, ai->mNumVertices));
-  }
-  if(ai->mBitangents) {
-    geometry->setBitangents(attribute::external<float, Vertex>(ai->mBitangents, ai->mNumVertices));
-  }
+  geometry->setTangents(toAttribute(data.tangents, cache));
+  geometry->setBitangents(toAttribute(data.bitangents, cache));
 #if 0
   if ( this.mTangentBuffer && this.mTangentBuffer.length > 0 )
       geometry.addAttribute( 'tangents', new THREE.BufferAttribute( this.mTangentBuffer, 3 ) );
@@ -771,7 +792,7 @@ Mesh::Ptr Access::readMesh(int index)
 void Access::readMaterial(unsigned materialIndex)
 {
   MeshMaker::Ptr maker;
-  const aiMaterial *ai = aiscene->mMaterials[materialIndex];
+  const aiMaterial *ai = aimaterials[materialIndex];
 
   aiString ainame;
   ai->Get(AI_MATKEY_NAME, ainame);
@@ -863,13 +884,187 @@ void Access::readMaterial(unsigned materialIndex)
   makers[materialIndex] = maker;
 }
 
+SceneCache::Block external(void *data, unsigned itemSize, unsigned count)
+{
+  SceneCache::Block block;
+  block.data = data;
+  block.itemSize = itemSize;
+  block.count = count;
+  return block;
+}
+
+SceneCache::Block readUVChannel(unsigned index, aiMesh *ai)
+{
+  if(ai->mTextureCoords[index]) {
+    if(ai->mNumUVComponents[index] != 2)
+      qWarning() << ai->mNumUVComponents[index] << "UV components found, 2 used";
+
+    //compact the 3D coordinates in place. Item i is written at or before where item i was read
+    float *uv = &ai->mTextureCoords[index][0].x;
+    for(unsigned i=0; i<ai->mNumVertices; i++) {
+      uv[i * 2] = uv[i * 3];
+      uv[i * 2 + 1] = uv[i * 3 + 1];
+    }
+    ai->mNumUVComponents[index] = 2;
+
+    return external(uv, 2, ai->mNumVertices);
+  }
+  return SceneCache::Block();
+}
+
+void readMesh(SceneCache &cache, aiMesh *ai, SceneCache::Mesh &mesh)
+{
+  mesh.name = ai->mName.C_Str();
+  mesh.material = ai->mMaterialIndex;
+
+  unsigned indexCount = 0;
+  for(unsigned i=0; i<ai->mNumFaces; i++) {
+    aiFace &f = ai->mFaces[i];
+    if(f.mNumIndices == 3) indexCount += 3;
+    else if(f.mNumIndices == 4) indexCount += 6;
+  }
+
+  mesh.index = cache.allocate(1, indexCount);
+  uint32_t *indices = static_cast<uint32_t *>(mesh.index.data);
+
+  for(unsigned i=0; i<ai->mNumFaces; i++) {
+    aiFace &f = ai->mFaces[i];
+    if ( f.mNumIndices == 3 ) {
+
+      *indices++ = f.mIndices[ 0 ];
+      *indices++ = f.mIndices[ 1 ];
+      *indices++ = f.mIndices[ 2 ];
+    }
+    else if ( f.mNumIndices == 4 ) {
+
+      *indices++ = f.mIndices[ 0 ];
+      *indices++ = f.mIndices[ 1 ];
+      *indices++ = f.mIndices[ 2 ];
+      *indices++ = f.mIndices[ 2 ];
+      *indices++ = f.mIndices[ 3 ];
+      *indices++ = f.mIndices[ 0 ];
+    }
+  }
+
+  //the faces are no longer needed, which lowers the peak memory
+  delete[] ai->mFaces;
+  ai->mFaces = nullptr;
+  ai->mNumFaces = 0;
+
+  //the remaining attributes are used in place
+  mesh.position = external(ai->mVertices, 3, ai->mNumVertices);
+
+  if(ai->mNormals) {
+    mesh.normal = external(ai->mNormals, 3, ai->mNumVertices);
+  }
+  if(ai->mColors[0]) {
+    mesh.color = external(ai->mColors[0], 4, ai->mNumVertices);
+  }
+
+  mesh.uv = readUVChannel(0, ai);
+  mesh.uv2 = readUVChannel(1, ai);
+
+  if(ai->mTangents) {
+    mesh.tangents = external(ai->mTangents, 3, ai->mNumVertices);
+  }
+  if(ai->mBitangents) {
+    mesh.bitangents = external(ai->mBitangents, 3, ai->mNumVertices);
+  }
+}
+
+void readNode(const aiNode *ai, SceneCache::Node &node)
+{
+  node.name = ai->mName.C_Str();
+
+  const aiMatrix4x4 & m = ai->mTransformation;
+  const ai_real values[] {
+     m.a1, m.a2, m.a3, m.a4, m.b1, m.b2, m.b3, m.b4, m.c1, m.c2, m.c3, m.c4, m.d1, m.d2, m.d3, m.d4};
+  copy(begin(values), end(values), node.matrix);
+
+  node.meshes.assign(ai->mMeshes, ai->mMeshes + ai->mNumMeshes);
+
+  node.children.resize(ai->mNumChildren);
+  for(unsigned i=0; i<ai->mNumChildren; i++) {
+    readNode(ai->mChildren[i], node.children[i]);
+  }
+}
+
+/**
+ * transfer an imported scene into the cache. Vertex data is referenced, not copied, so the cache
+ * retains the scene. The scene is modified in the process and must not be used otherwise
+ */
+void readScene(SceneCache &cache, const shared_ptr<aiScene> &ai, ProgressHandler &progress)
+{
+  cache.retain(ai);
+
+  cache.materials.resize(ai->mNumMaterials);
+  for(unsigned i=0; i<ai->mNumMaterials; i++) {
+    const aiMaterial *material = ai->mMaterials[i];
+
+    cache.materials[i].properties.resize(material->mNumProperties);
+    for(unsigned p=0; p<material->mNumProperties; p++) {
+      const aiMaterialProperty *aiprop = material->mProperties[p];
+      SceneCache::Property &property = cache.materials[i].properties[p];
+
+      property.key = aiprop->mKey.C_Str();
+      property.semantic = aiprop->mSemantic;
+      property.index = aiprop->mIndex;
+      property.type = aiprop->mType;
+      property.data = aiprop->mData;
+      property.length = aiprop->mDataLength;
+    }
+  }
+
+  //meshes are converted in parallel, in rounds so that progress is reported from this thread
+  ThreadPool &pool = ThreadPool::instance();
+  size_t round = (pool.size() + 1) * 4;
+
+  cache.meshes.resize(ai->mNumMeshes);
+  for(size_t first=0; first < ai->mNumMeshes; first += round) {
+    size_t last = min(first + round, (size_t)ai->mNumMeshes);
+
+    pool.parallelFor(first, last, 1, [&](size_t begin, size_t end) {
+      for(size_t i=begin; i<end; i++) readMesh(cache, ai->mMeshes[i], cache.meshes[i]);
+    });
+    progress.UpdateConversion(last, ai->mNumMeshes);
+  }
+
+  readNode(ai->mRootNode, cache.root);
+}
+
 void Assimp::loadScene(string name, ResourceLoader &loader)
 {
-  _importer = make_shared<as::Importer>();
-  _importer->SetIOHandler(new IOSystem(loader));
-  _importer->SetProgressHandler(new ProgressHandler());
+  string cachePath = useSceneCache ? loader.cachePath(name.c_str()) : string();
+
+  SceneCache::Ptr cache;
+  if(!cachePath.empty() && (cache = SceneCache::map(cachePath))) {
+
+    //the materials are rebuilt from their properties, so material handling is unchanged
+    vector<unique_ptr<aiMaterial>> materials;
+    vector<const aiMaterial *> aimaterials;
+    for(const SceneCache::Material &material : cache->materials) {
+      materials.emplace_back(new aiMaterial());
+      for(const SceneCache::Property &property : material.properties) {
+        materials.back()->AddBinaryProperty(property.data, property.length, property.key.c_str(),
+                                            property.semantic, property.index, (aiPropertyTypeInfo)property.type);
+      }
+      aimaterials.push_back(materials.back().get());
+    }
+
+    Access access(_scene, cache, aimaterials, loader, modelMap, _materialHandler);
+    access.readScene();
+
+    onProgress.emitSignal(1.0f);
+    return;
+  }
 
-  const aiScene *aiscene = _importer->ReadFile(name.c_str(),
+  as::Importer importer;
+  importer.SetIOHandler(new IOSystem(loader));
+  ProgressHandler *progress = new ProgressHandler(onProgress);
+  importer.SetProgressHandler(progress);
+
+  //changing the post-processing requires a new scene cache version
+  const aiScene *imported = importer.ReadFile(name.c_str(),
                                              aiProcess_CalcTangentSpace |
                                              aiProcess_Triangulate |
                                              aiProcess_JoinIdenticalVertices |
@@ -883,14 +1078,25 @@ void Assimp::loadScene(string name, ResourceLoader &loader)
                                              //aiProcess_OptimizeGraph |
                                              aiProcess_SortByPType);
 
-  if (!aiscene || aiscene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) {
-    onError.emitSignal(_importer->GetErrorString());
-    qWarning() << _importer->GetErrorString();
+  if (!imported || imported->mFlags & AI_SCENE_FLAGS_INCOMPLETE) {
+    onError.emitSignal(importer.GetErrorString());
+    qWarning() << importer.GetErrorString();
     return;
   }
 
-  Access access(_scene, aiscene, loader, modelMap, _materialHandler);
+  //take over the scene, so the importer can go. The geometries keep it alive through the cache
+  shared_ptr<aiScene> aiscene(importer.GetOrphanedScene());
+
+  cache = make_shared<SceneCache>();
+  readScene(*cache, aiscene, *progress);
+
+  vector<const aiMaterial *> aimaterials(aiscene->mMaterials, aiscene->mMaterials + aiscene->mNumMaterials);
+
+  Access access(_scene, cache, aimaterials, loader, modelMap, _materialHandler);
   access.readScene();
+
+  if(!cachePath.empty() && !cache->write(cachePath))
+    qWarning() << "cannot write scene cache" << cachePath.c_str();
 }
 
 void Assimp::load(std::string name, const Color &background, ResourceLoader &loader)
@@ -911,10 +1117,5 @@ void Assimp::load(string name, ResourceLoader &loader)
   loadScene(name, loader);
 }
 
-Assimp::~Assimp()
-{
-  _importer = nullptr;
-}
-
 }
 }
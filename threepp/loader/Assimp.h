@@ -17,10 +17,6 @@
 
 #include "Loader.h"
 
-namespace Assimp {
-class Importer;
-}
-
 namespace three {
 namespace loader {
 
@@ -30,6 +26,10 @@ struct AssimpOptions
 {
   enum_map<ShadingModel, ShadingModel> modelMap;
 
+  //write a native scene cache after the import and load from it subsequently, if the ResourceLoader
+  //supports caching
+  bool useSceneCache = true;
+
   AssimpOptions() {
     modelMap[ShadingModel::Phong] = ShadingModel::Phong;
     modelMap[ShadingModel::Gouraud] = ShadingModel::Phong;
@@ -54,8 +54,6 @@ public:
   Assimp(const AssimpOptions &options=AssimpOptions()) : AssimpOptions(options)
   {}
 
-  ~Assimp() override;
-
   void substituteShading(ShadingModel old, ShadingModel subst)
   {
     modelMap[old] = subst;
@@ -69,8 +67,6 @@ protected:
   std::vector<Material::Ptr> _materials;
   std::vector<Mesh::Ptr> _meshes;
 
-  std::shared_ptr<::Assimp::Importer> _importer;
-
   const AssimpMaterialHandler *_materialHandler = nullptr;
 
   void loadScene(std::string name, ResourceLoader &loader);
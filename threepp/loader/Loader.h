@@ -27,8 +27,15 @@ struct Resource
 struct ResourceLoader
 {
   virtual bool exists(const char *path) = 0;
+  //may be called concurrently
   virtual void load(QImage &image, const std::string &file) = 0;
   virtual Resource::Ptr get(const char *path, std::ios_base::openmode) = 0;
+
+  /**
+   * @return a local file path for a cache of the given resource, or an empty string if caching
+   * is not supported. Stale caches must not be returned
+   */
+  virtual std::string cachePath(const char *path) {return std::string();}
 };
 
 namespace loader {
@@ -137,6 +144,9 @@ public:
 
   Signal<void(std::string message)> onError;
 
+  //loading progress in [0, 1], emitted on the loading thread
+  Signal<void(float progress)> onProgress;
+
   virtual void load(std::string name, ResourceLoader &loader) = 0;
   virtual void load(std::string name, const Color &background, ResourceLoader &loader) = 0;
   virtual void load(std::string name, Texture::Ptr background, ResourceLoader &loader) = 0;
@@ -0,0 +1,304 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#include "SceneCache.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <QSaveFile>
+#include <QDebug>
+
+namespace three {
+namespace loader {
+
+using namespace std;
+
+namespace {
+
+//incremented whenever the format or the import settings change
+const uint32_t version = 1;
+
+const char magic[8] = {'3', 'P', 'P', 'S', 'C', 'E', 'N', 'E'};
+
+struct Header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t structureOffset;
+  uint64_t structureSize;
+};
+
+const size_t alignment = 16;
+
+size_t aligned(size_t offset)
+{
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * accumulates the structure part of the file
+ */
+class Output
+{
+  vector<char> _bytes;
+
+public:
+  template <typename T>
+  void put(const T &value)
+  {
+    const char *bytes = reinterpret_cast<const char *>(&value);
+    _bytes.insert(_bytes.end(), bytes, bytes + sizeof(T));
+  }
+
+  void put(const char *data, uint32_t length)
+  {
+    put(length);
+    _bytes.insert(_bytes.end(), data, data + length);
+  }
+
+  void put(const string &value)
+  {
+    put(value.data(), (uint32_t)value.size());
+  }
+
+  const vector<char> &bytes() const {return _bytes;}
+};
+
+/**
+ * reads the structure part of the file, checking all bounds
+ */
+class Input
+{
+  const uchar * const _data;
+  const size_t _size;
+  size_t _pos;
+
+  void need(size_t bytes)
+  {
+    if(_size - _pos < bytes) throw out_of_range("truncated");
+  }
+
+public:
+  Input(const uchar *data, size_t size, size_t pos) : _data(data), _size(size), _pos(pos) {}
+
+  template <typename T>
+  T get()
+  {
+    need(sizeof(T));
+    T value;
+    memcpy(&value, _data + _pos, sizeof(T));
+    _pos += sizeof(T);
+    return value;
+  }
+
+  const char *get(uint32_t &length)
+  {
+    length = get<uint32_t>();
+    need(length);
+    const char *data = reinterpret_cast<const char *>(_data + _pos);
+    _pos += length;
+    return data;
+  }
+
+  string getString()
+  {
+    uint32_t length;
+    const char *data = get(length);
+    return string(data, length);
+  }
+};
+
+void writeNode(Output &out, const SceneCache::Node &node)
+{
+  out.put(node.name);
+  for(float value : node.matrix) out.put(value);
+
+  out.put((uint32_t)node.meshes.size());
+  for(unsigned mesh : node.meshes) out.put((uint32_t)mesh);
+
+  out.put((uint32_t)node.children.size());
+  for(const SceneCache::Node &child : node.children) writeNode(out, child);
+}
+
+void readNode(Input &in, SceneCache::Node &node, size_t meshCount)
+{
+  node.name = in.getString();
+  for(float &value : node.matrix) value = in.get<float>();
+
+  node.meshes.resize(in.get<uint32_t>());
+  for(unsigned &mesh : node.meshes) {
+    mesh = in.get<uint32_t>();
+    if(mesh >= meshCount) throw out_of_range("mesh index");
+  }
+
+  node.children.resize(in.get<uint32_t>());
+  for(SceneCache::Node &child : node.children) readNode(in, child, meshCount);
+}
+
+}
+
+SceneCache::~SceneCache()
+{
+  if(_mapped) _file->unmap(_mapped);
+}
+
+SceneCache::Block SceneCache::allocate(unsigned itemSize, unsigned count)
+{
+  lock_guard<mutex> lock(_storageMutex);
+  _storage.emplace_back(itemSize * count);
+
+  Block block;
+  block.data = _storage.back().data();
+  block.itemSize = itemSize;
+  block.count = count;
+  return block;
+}
+
+SceneCache::Ptr SceneCache::map(const std::string &path)
+{
+  unique_ptr<QFile> file(new QFile(QString::fromStdString(path)));
+  if(!file->exists() || !file->open(QIODevice::ReadOnly)) return nullptr;
+
+  size_t size = file->size();
+  if(size < sizeof(Header)) return nullptr;
+
+  uchar *mapped = file->map(0, size, QFileDevice::MapPrivateOption);
+  if(!mapped) {
+    qWarning() << "cannot map scene cache" << path.c_str();
+    return nullptr;
+  }
+
+  Ptr cache = make_shared<SceneCache>();
+  cache->_file = move(file);
+  cache->_mapped = mapped;
+
+  Header header;
+  memcpy(&header, mapped, sizeof(Header));
+  if(memcmp(header.magic, magic, sizeof(magic)) || header.version != version || header.byteOrder != 0x01020304) {
+    qWarning() << "ignoring incompatible scene cache" << path.c_str();
+    return nullptr;
+  }
+  if(header.structureOffset > size || header.structureSize > size - header.structureOffset) {
+    qWarning() << "ignoring truncated scene cache" << path.c_str();
+    return nullptr;
+  }
+
+  try {
+    Input in(mapped, header.structureOffset + header.structureSize, header.structureOffset);
+
+    cache->materials.resize(in.get<uint32_t>());
+    for(Material &material : cache->materials) {
+
+      material.properties.resize(in.get<uint32_t>());
+      for(Property &property : material.properties) {
+        property.key = in.getString();
+        property.semantic = in.get<uint32_t>();
+        property.index = in.get<uint32_t>();
+        property.type = in.get<uint32_t>();
+        property.data = in.get(property.length);
+      }
+    }
+
+    cache->meshes.resize(in.get<uint32_t>());
+    for(Mesh &mesh : cache->meshes) {
+      mesh.name = in.getString();
+      mesh.material = in.get<uint32_t>();
+      if(mesh.material >= cache->materials.size()) throw out_of_range("material index");
+
+      for(Block *block : {&mesh.index, &mesh.position, &mesh.normal, &mesh.color,
+                          &mesh.uv, &mesh.uv2, &mesh.tangents, &mesh.bitangents}) {
+        uint64_t offset = in.get<uint64_t>();
+        block->itemSize = in.get<uint32_t>();
+        block->count = in.get<uint32_t>();
+
+        if(offset == 0) continue;
+        if(offset % alignment || offset > size || block->bytes() > size - offset) throw out_of_range("block");
+
+        block->data = mapped + offset;
+      }
+    }
+
+    readNode(in, cache->root, cache->meshes.size());
+  }
+  catch(out_of_range &e) {
+    qWarning() << "ignoring corrupt scene cache" << path.c_str() << "(" << e.what() << ")";
+    return nullptr;
+  }
+
+  return cache;
+}
+
+bool SceneCache::write(const std::string &path) const
+{
+  Output structure;
+
+  //lay out the blocks behind the header
+  vector<pair<size_t, const Block *>> blocks;
+  size_t end = sizeof(Header);
+
+  structure.put((uint32_t)materials.size());
+  for(const Material &material : materials) {
+
+    structure.put((uint32_t)material.properties.size());
+    for(const Property &property : material.properties) {
+      structure.put(property.key);
+      structure.put((uint32_t)property.semantic);
+      structure.put((uint32_t)property.index);
+      structure.put((uint32_t)property.type);
+      structure.put(property.data, property.length);
+    }
+  }
+
+  structure.put((uint32_t)meshes.size());
+  for(const Mesh &mesh : meshes) {
+    structure.put(mesh.name);
+    structure.put((uint32_t)mesh.material);
+
+    for(const Block *block : {&mesh.index, &mesh.position, &mesh.normal, &mesh.color,
+                              &mesh.uv, &mesh.uv2, &mesh.tangents, &mesh.bitangents}) {
+      uint64_t offset = 0;
+      if(block->data && block->count) {
+        offset = aligned(end);
+        end = offset + block->bytes();
+        blocks.emplace_back(offset, block);
+      }
+      structure.put(offset);
+      structure.put((uint32_t)block->itemSize);
+      structure.put((uint32_t)block->count);
+    }
+  }
+
+  writeNode(structure, root);
+
+  Header header;
+  memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.byteOrder = 0x01020304;
+  header.structureOffset = aligned(end);
+  header.structureSize = structure.bytes().size();
+
+  QSaveFile file(QString::fromStdString(path));
+  if(!file.open(QIODevice::WriteOnly)) return false;
+
+  size_t written = 0;
+  auto write = [&](const void *data, size_t bytes) {
+    file.write(reinterpret_cast<const char *>(data), bytes);
+    written += bytes;
+  };
+  static const char padding[alignment] = {0};
+
+  write(&header, sizeof(Header));
+  for(const auto &block : blocks) {
+    write(padding, block.first - written);
+    write(block.second->data, block.second->bytes());
+  }
+  write(padding, header.structureOffset - written);
+  write(structure.bytes().data(), structure.bytes().size());
+
+  return file.commit();
+}
+
+}
+}
@@ -0,0 +1,137 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#ifndef THREEPP_SCENECACHE_H
+#define THREEPP_SCENECACHE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <mutex>
+#include <QFile>
+#include <threepp/util/osdecl.h>
+
+namespace three {
+namespace loader {
+
+/**
+ * native scene format, written after an import and memory-mapped on later loads of the same model,
+ * bypassing the importer. It holds the node hierarchy, the raw material properties (which include
+ * the texture references) and the mesh data.
+ *
+ * Mesh data is stored in blocks of 32-bit components, aligned to 16 bytes and used in place: the
+ * geometries built from a cache wrap its memory and share ownership of the cache. The mapping is
+ * private, so modified attributes don't write through to the file.
+ *
+ * The file is written in native byte order and is not meant to be exchanged between machines.
+ */
+class DLX SceneCache
+{
+public:
+  using Ptr = std::shared_ptr<SceneCache>;
+
+  /**
+   * an array of 32-bit components (float or uint32)
+   */
+  struct Block
+  {
+    void *data = nullptr;
+    unsigned itemSize = 0;
+    unsigned count = 0;
+
+    size_t bytes() const {return (size_t)itemSize * count * 4;}
+
+    explicit operator bool() const {return data != nullptr;}
+  };
+
+  struct Mesh
+  {
+    std::string name;
+    unsigned material = 0;
+
+    Block index, position, normal, color, uv, uv2, tangents, bitangents;
+  };
+
+  struct Node
+  {
+    std::string name;
+
+    //row-major
+    float matrix[16];
+
+    std::vector<unsigned> meshes;
+    std::vector<Node> children;
+  };
+
+  /**
+   * a material property as stored by the importer
+   */
+  struct Property
+  {
+    std::string key;
+    unsigned semantic = 0;
+    unsigned index = 0;
+    unsigned type = 0;
+
+    const char *data = nullptr;
+    unsigned length = 0;
+  };
+
+  struct Material
+  {
+    std::vector<Property> properties;
+  };
+
+private:
+  //the mapped file
+  std::unique_ptr<QFile> _file;
+  uchar *_mapped = nullptr;
+
+  //data created while filling the cache from an import
+  std::vector<std::vector<uint32_t>> _storage;
+  std::mutex _storageMutex;
+
+  //data referenced by the blocks, e.g. the imported scene
+  std::shared_ptr<void> _source;
+
+public:
+  Node root;
+  std::vector<Mesh> meshes;
+  std::vector<Material> materials;
+
+  SceneCache() = default;
+  SceneCache(const SceneCache &) = delete;
+
+  ~SceneCache();
+
+  /**
+   * allocate a block owned by this cache. May be called concurrently
+   */
+  Block allocate(unsigned itemSize, unsigned count);
+
+  /**
+   * keep the source of blocks which are referenced, not allocated, alive as long as the cache
+   */
+  void retain(const std::shared_ptr<void> &source) {_source = source;}
+
+  /**
+   * map a cache file
+   *
+   * @return the cache, or nullptr if the file does not exist or is unusable
+   */
+  static Ptr map(const std::string &path);
+
+  /**
+   * write the cache to a file. The file is replaced atomically
+   *
+   * @return false if the file could not be written
+   */
+  bool write(const std::string &path) const;
+};
+
+}
+}
+
+#endif //THREEPP_SCENECACHE_H
@@ -15,7 +15,7 @@
 
 namespace three {
 
-uint16_t Material::___material_id_count = 0;
+std::atomic<uint64_t> Material::___material_id_count {0};
 
 void MeshDistanceMaterial::setupPointLight(const math::Vector3 &position, float near, float far)
 {
@@ -105,7 +105,7 @@ void PointsMaterial::callback(const material::Selector &selector)
 }
 
 Material::Material(const Material &material, const material::Info &info, const material::Typer &typer)
-   : uuid(sole::uuid0()), id(___material_id_count++), info(info), typer(typer)
+   : uuid(sole::uuid0()), id(++___material_id_count), info(info), typer(typer)
 {
   fog = material.fog;
   lights = material.lights;
@@ -6,6 +6,7 @@
 #define THREEPP_MATERIAL_H
 
 #include <memory>
+#include <atomic>
 #include <threepp/util/osdecl.h>
 #include <threepp/Constants.h>
 #include <threepp/textures/Texture.h>
@@ -148,10 +149,11 @@ struct Selector
 
 struct DLX Material
 {
-  static uint16_t ___material_id_count;
+  static std::atomic<uint64_t> ___material_id_count;
 
   const sole::uuid uuid;
-  uint16_t id;
+  //automatically assigned, unique within process. Never 0
+  uint64_t id;
 
   std::string name;
 
@@ -220,7 +222,7 @@ struct DLX Material
 
 protected:
   Material(const material::Info &info, const material::Typer &typer)
-     : uuid(sole::uuid0()), id(___material_id_count++), info(info), typer(typer) {}
+     : uuid(sole::uuid0()), id(++___material_id_count), info(info), typer(typer) {}
 
   Material(const Material &material, const material::Info &info, const material::Typer &typer);
 
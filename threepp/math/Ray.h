@@ -398,7 +398,7 @@ public:
     else if (DdN < 0) {
 
       sign = -1;
-      DdN = abs(DdN);
+      DdN = std::abs(DdN);
     }
     else {
       return false;
@@ -0,0 +1,162 @@
+//
+// Created by byter on 22.10.26.
+//
+
+#include "InstancedMesh.h"
+#include <threepp/math/Frustum.h>
+#include <threepp/core/Raycaster.h>
+
+namespace three {
+
+using namespace math;
+
+InstancedMesh::InstancedMesh(const BufferGeometry::Ptr &geometry, const Material::Ptr &material, unsigned count)
+   : Mesh(geometry, {material}), _capacity(count), _count(count)
+{
+  Object3D::typer = object::Typer(this);
+  typer.allow<Mesh>();
+
+  frustumCulled = false;
+
+  _matrices = attribute::prealloc<float, Matrix4>(count);
+  _matrices->dynamic = true;
+}
+
+InstancedMesh::InstancedMesh(const InstancedMesh &mesh)
+   : Mesh(mesh), _capacity(mesh._capacity), _count(mesh._count), cullInstances(mesh.cullInstances)
+{
+  Object3D::typer = object::Typer(this);
+  typer.allow<Mesh>();
+
+  _matrices.reset(mesh._matrices->clone());
+  if(mesh._colors) _colors.reset(mesh._colors->clone());
+}
+
+void InstancedMesh::setCount(unsigned count)
+{
+  _count = std::min(count, _capacity);
+  _version++;
+}
+
+void InstancedMesh::setMatrixAt(unsigned index, const Matrix4 &matrix)
+{
+  _matrices->data<Matrix4>()[index] = matrix;
+  _changedMatrices.add(index);
+  _version++;
+}
+
+void InstancedMesh::setColorAt(unsigned index, const Color &color)
+{
+  if(!_colors) {
+    _colors = attribute::prealloc<float, Color>(_capacity);
+    _colors->dynamic = true;
+
+    Color *colors = _colors->data<Color>();
+    for(unsigned i=0; i<_capacity; i++) colors[i] = Color(1, 1, 1);
+  }
+  _colors->data<Color>()[index] = color;
+  _changedColors.add(index);
+  _version++;
+}
+
+void InstancedMesh::upload(BufferAttributeT<float> &attribute, Range &changed, unsigned itemSize)
+{
+  if(changed.begin == changed.end) return;
+
+  attribute.updateRange().offset = changed.begin * itemSize;
+  attribute.updateRange().count = (changed.end - changed.begin) * itemSize;
+  attribute.needsUpdate();
+
+  changed = Range();
+}
+
+unsigned InstancedMesh::prepare(const Matrix4 &projScreenMatrix, bool cull)
+{
+  _preparedAll = !cullInstances || !cull;
+
+  if(_preparedAll) {
+    upload(*_matrices, _changedMatrices, 16);
+    if(_colors) upload(*_colors, _changedColors, 3);
+
+    return _count;
+  }
+
+  //the frustum in object space
+  Matrix4 cullMatrix = projScreenMatrix * _matrixWorld;
+
+  if(_visibleMatrices && _version == _culledVersion && cullMatrix == _culledMatrix
+     && (bool)_visibleColors == (bool)_colors)
+    return _visibleCount;
+
+  _culledVersion = _version;
+  _culledMatrix = cullMatrix;
+
+  if(!_visibleMatrices) {
+    _visibleMatrices = attribute::prealloc<float, Matrix4>(_capacity);
+    _visibleMatrices->dynamic = true;
+  }
+  if(_colors && !_visibleColors) {
+    _visibleColors = attribute::prealloc<float, Color>(_capacity);
+    _visibleColors->dynamic = true;
+  }
+
+  Frustum frustum;
+  frustum.set(cullMatrix);
+
+  if (_geometry->boundingSphere().isEmpty()) _geometry->computeBoundingSphere();
+  const Sphere &bounds = _geometry->boundingSphere();
+
+  const Matrix4 *matrices = _matrices->data<Matrix4>();
+  const Color *colors = _colors ? _colors->data<Color>() : nullptr;
+  Matrix4 *visibleMatrices = _visibleMatrices->data<Matrix4>();
+  Color *visibleColors = _visibleColors ? _visibleColors->data<Color>() : nullptr;
+
+  unsigned visible = 0;
+  for(unsigned i=0; i<_count; i++) {
+    Sphere sphere = bounds;
+    sphere.apply(matrices[i]);
+
+    if(frustum.intersectsSphere(sphere)) {
+      visibleMatrices[visible] = matrices[i];
+      if(colors) visibleColors[visible] = colors[i];
+      visible++;
+    }
+  }
+
+  //the visible instances are always uploaded from the start
+  Range range;
+  range.end = visible;
+
+  _visibleCount = visible;
+  upload(*_visibleMatrices, range, 16);
+  if(_visibleColors) {
+    range.end = visible;
+    upload(*_visibleColors, range, 3);
+  }
+
+  return visible;
+}
+
+void InstancedMesh::raycast(const Raycaster &raycaster, IntersectList &intersects)
+{
+  Matrix4 matrixWorld = _matrixWorld;
+
+  std::vector<size_t> counts(intersects.rayCount());
+
+  for(unsigned i=0; i<_count; i++) {
+    for(unsigned r=0, l=intersects.rayCount(); r<l; r++) counts[r] = intersects.count(r);
+
+    //present the instance as the mesh itself
+    _matrixWorld = matrixWorld * matrixAt(i);
+    Mesh::raycast(raycaster, intersects);
+
+    counts.resize(intersects.rayCount(), 0);
+    for(unsigned r=0, l=intersects.rayCount(); r<l; r++) {
+      for(size_t n=counts[r], c=intersects.count(r); n<c; n++) intersects.get(r, n).instance = i;
+    }
+  }
+
+  _matrixWorld = matrixWorld;
+}
+
+}
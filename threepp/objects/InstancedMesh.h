@@ -0,0 +1,156 @@
+//
+// Created by byter on 22.10.26.
+//
+
+#ifndef THREEPP_INSTANCEDMESH_H
+#define THREEPP_INSTANCEDMESH_H
+
+#include <threepp/core/BufferGeometry.h>
+#include "Mesh.h"
+
+namespace three {
+
+/**
+ * a mesh which is drawn many times in one draw call, each instance with its own transform and,
+ * optionally, color. The instance transforms are relative to the mesh, i.e. the world matrix
+ * of instance i is matrixWorld() * matrixAt(i).
+ *
+ * Instances are frustum culled individually against their transformed geometry bounding sphere,
+ * so the mesh itself is not frustum culled by default. Only the instances changed through setMatrixAt()
+ * and setColorAt() are uploaded.
+ */
+class DLX InstancedMesh : public Mesh
+{
+  struct Range
+  {
+    unsigned begin = 0, end = 0;
+
+    void add(unsigned index) {
+      if(begin == end) {begin = index; end = index + 1;}
+      else {
+        if(index < begin) begin = index;
+        if(index >= end) end = index + 1;
+      }
+    }
+  };
+
+  unsigned _capacity;
+  unsigned _count;
+
+  attribute::prealloc_t<float, math::Matrix4> _matrices;
+  attribute::prealloc_t<float, Color> _colors;
+  Range _changedMatrices, _changedColors;
+
+  //the visible instances, compacted, if cullInstances is set
+  attribute::prealloc_t<float, math::Matrix4> _visibleMatrices;
+  attribute::prealloc_t<float, Color> _visibleColors;
+  unsigned _visibleCount = 0;
+
+  //state of the last culling
+  unsigned _version = 0, _culledVersion = 0;
+  math::Matrix4 _culledMatrix;
+
+  //the last prepare() selected all instances
+  bool _preparedAll = false;
+
+  void upload(BufferAttributeT<float> &attribute, Range &changed, unsigned itemSize);
+
+protected:
+  InstancedMesh(const BufferGeometry::Ptr &geometry, const Material::Ptr &material, unsigned count);
+
+  InstancedMesh(const InstancedMesh &mesh);
+
+public:
+  using Ptr = std::shared_ptr<InstancedMesh>;
+
+  static Ptr make(const BufferGeometry::Ptr &geometry, const Material::Ptr &material, unsigned count)
+  {
+    return Ptr(new InstancedMesh(geometry, material, count));
+  }
+
+  /**
+   * cull instances against the camera frustum before drawing
+   */
+  bool cullInstances = true;
+
+  /**
+   * @return the maximum number of instances
+   */
+  unsigned capacity() const {return _capacity;}
+
+  /**
+   * @return the number of instances drawn
+   */
+  unsigned count() const {return _count;}
+
+  /**
+   * @return a counter incremented whenever instance matrices, colors or the count change
+   */
+  unsigned version() const {return _version;}
+
+  /**
+   * set the number of instances drawn, at most capacity()
+   */
+  void setCount(unsigned count);
+
+  const math::Matrix4 &matrixAt(unsigned index) const
+  {
+    return _matrices->data<math::Matrix4>()[index];
+  }
+
+  void setMatrixAt(unsigned index, const math::Matrix4 &matrix);
+
+  /**
+   * @return the color of an instance, white if no colors were set
+   */
+  Color colorAt(unsigned index) const
+  {
+    return _colors ? _colors->data<Color>()[index] : Color(1, 1, 1);
+  }
+
+  /**
+   * set the color of an instance. The first call enables instance colors, which multiply the material color
+   */
+  void setColorAt(unsigned index, const Color &color);
+
+  bool hasColors() const {return (bool)_colors;}
+
+  /**
+   * prepare the instance attributes for drawing. Called by the renderer
+   *
+   * @param projScreenMatrix the camera's projection matrix times its inverse world matrix
+   * @param cull whether to cull, if cullInstances is set. Shadow passes draw all instances, so
+   * they leave the culling result of the camera pass intact
+   * @return the number of instances to draw
+   */
+  unsigned prepare(const math::Matrix4 &projScreenMatrix, bool cull=true);
+
+  /**
+   * @return the matrices to draw, as prepared by prepare()
+   */
+  BufferAttributeT<float>::Ptr instanceMatrices() const
+  {
+    return cullInstances && !_preparedAll ? _visibleMatrices : _matrices;
+  }
+
+  /**
+   * @return the colors to draw, as prepared by prepare(), or nullptr
+   */
+  BufferAttributeT<float>::Ptr instanceColors() const
+  {
+    return cullInstances && !_preparedAll ? _visibleColors : _colors;
+  }
+
+  /**
+   * raycast all instances. Intersection::instance holds the instance index
+   */
+  void raycast(const Raycaster &raycaster, IntersectList &intersects) override;
+
+  InstancedMesh *cloned() const override {
+    return new InstancedMesh(*this);
+  }
+};
+
+}
+
+#endif //THREEPP_INSTANCEDMESH_H
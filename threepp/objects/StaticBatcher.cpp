@@ -0,0 +1,278 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#include "StaticBatcher.h"
+#include "InstancedMesh.h"
+#include "SkinnedMesh.h"
+#include <threepp/core/Raycaster.h>
+#include <threepp/math/Vector4.h>
+#include <algorithm>
+
+namespace three {
+
+using namespace std;
+using namespace math;
+
+const BatchedMesh::Source *BatchedMesh::source(unsigned triangle) const
+{
+  auto found = upper_bound(_sources.begin(), _sources.end(), triangle,
+                           [](unsigned t, const Source &source) {return t < source.firstTriangle;});
+
+  if(found == _sources.begin()) return nullptr;
+  const Source &source = *prev(found);
+
+  return triangle < source.firstTriangle + source.triangleCount ? &source : nullptr;
+}
+
+void BatchedMesh::raycast(const Raycaster &raycaster, IntersectList &intersects)
+{
+  vector<size_t> counts(intersects.rayCount());
+  for(unsigned r=0, l=intersects.rayCount(); r<l; r++) counts[r] = intersects.count(r);
+
+  Mesh::raycast(raycaster, intersects);
+
+  //present the hits as hits on the source meshes
+  counts.resize(intersects.rayCount(), 0);
+  for(unsigned r=0, l=intersects.rayCount(); r<l; r++) {
+    for(size_t n=counts[r], c=intersects.count(r); n<c; n++) {
+      Intersection &intersection = intersects.get(r, n);
+
+      const Source *src = source(intersection.faceIndex);
+      if(!src) continue;
+
+      unsigned triangle = intersection.faceIndex - src->firstTriangle;
+
+      intersection.object = src->object.get();
+      intersection.face.a -= src->firstVertex;
+      intersection.face.b -= src->firstVertex;
+      intersection.face.c -= src->firstVertex;
+      if(src->indexed)
+        intersection.faceIndex = triangle;
+      else
+        intersection.index = triangle * 3;
+    }
+  }
+}
+
+namespace {
+
+//meshes which can be merged into one batch
+struct Bucket
+{
+  Material::Ptr material;
+  unsigned colorSize;
+  bool normal, uv, uv2;
+  bool castShadow, receiveShadow;
+  int renderOrder;
+  Layers layers;
+
+  std::vector<Mesh::Ptr> meshes;
+
+  bool matches(const Bucket &other) const
+  {
+    return material == other.material && colorSize == other.colorSize && normal == other.normal
+           && uv == other.uv && uv2 == other.uv2 && castShadow == other.castShadow
+           && receiveShadow == other.receiveShadow && renderOrder == other.renderOrder
+           && layers == other.layers;
+  }
+};
+
+BufferGeometry *eligible(Object3D &object)
+{
+  Mesh *mesh = object.typer;
+  if(!mesh || object.is<InstancedMesh>() || object.is<SkinnedMesh>() || object.is<BatchedMesh>()) return nullptr;
+  if(mesh->drawMode() != DrawMode::Triangles || object.materialCount() != 1) return nullptr;
+
+  BufferGeometry *geometry = nullptr;
+  if(object.geometry()) geometry = object.geometry()->typer;
+  if(!geometry || !geometry->position() || geometry->useMorphing()) return nullptr;
+
+  const UpdateRange &drawRange = geometry->drawRange();
+  if(drawRange.offset != 0 || drawRange.count >= 0) return nullptr;
+
+  return geometry;
+}
+
+void collect(const Object3D::Ptr &object, const StaticBatcher::Options &options, std::vector<Bucket> &buckets)
+{
+  for(const Object3D::Ptr &child : object->children()) {
+
+    //invisible or filtered objects are left alone, along with their descendants
+    if(!child->visible() || (options.filter && !options.filter(*child))) continue;
+
+    collect(child, options, buckets);
+
+    BufferGeometry *geometry = eligible(*child);
+    if(!geometry) continue;
+
+    Bucket bucket;
+    bucket.material = child->material();
+    bucket.colorSize = geometry->color() ? geometry->color()->itemSize() : 0;
+    bucket.normal = (bool)geometry->normal();
+    bucket.uv = (bool)geometry->uv();
+    bucket.uv2 = (bool)geometry->uv2();
+    bucket.castShadow = child->castShadow;
+    bucket.receiveShadow = child->receiveShadow;
+    bucket.renderOrder = child->renderOrder();
+    bucket.layers = child->layers();
+
+    auto found = find_if(buckets.begin(), buckets.end(), [&](const Bucket &b) {return b.matches(bucket);});
+    if(found == buckets.end()) {
+      buckets.push_back(bucket);
+      found = buckets.end() - 1;
+    }
+    found->meshes.push_back(std::dynamic_pointer_cast<Mesh>(child));
+  }
+}
+
+//copy the attribute items of a source to the batch
+void append(std::vector<float> &target, const BufferAttributeT<float> &attribute, unsigned count)
+{
+  const float *data = static_cast<const float *>(attribute.data(0));
+  target.insert(target.end(), data, data + count * attribute.itemSize());
+}
+
+template <typename Item>
+BufferAttributeT<float>::Ptr toAttribute(const std::vector<float> &values)
+{
+  const Item *items = reinterpret_cast<const Item *>(values.data());
+  return attribute::copied<float, Item>(std::vector<Item>(items, items + values.size() * sizeof(float) / sizeof(Item)));
+}
+
+BufferGeometry::Ptr build(const Bucket &bucket, std::vector<Mesh::Ptr>::const_iterator begin,
+                         std::vector<Mesh::Ptr>::const_iterator end, const Matrix4 &toRoot,
+                         std::vector<BatchedMesh::Source> &sources)
+{
+  std::vector<float> positions, normals, colors, uvs, uv2s;
+  std::vector<uint32_t> indices;
+
+  for(auto it = begin; it != end; it++) {
+    const Mesh::Ptr &mesh = *it;
+    BufferGeometry *geometry = mesh->geometry()->typer;
+
+    unsigned firstVertex = positions.size() / 3;
+    unsigned vertexCount = geometry->position()->itemCount();
+
+    Matrix4 matrix = toRoot * mesh->matrixWorld();
+    Matrix3 normalMatrix = matrix.normalMatrix();
+
+    for(unsigned i=0; i<vertexCount; i++) {
+      Vector3 position(geometry->position()->get_x(i), geometry->position()->get_y(i), geometry->position()->get_z(i));
+      position.apply(matrix);
+      positions.insert(positions.end(), {position.x(), position.y(), position.z()});
+    }
+    if(bucket.normal) {
+      for(unsigned i=0; i<vertexCount; i++) {
+        Vector3 normal(geometry->normal()->get_x(i), geometry->normal()->get_y(i), geometry->normal()->get_z(i));
+        normal.apply(normalMatrix).normalize();
+        normals.insert(normals.end(), {normal.x(), normal.y(), normal.z()});
+      }
+    }
+    if(bucket.colorSize) append(colors, *geometry->color(), vertexCount);
+    if(bucket.uv) append(uvs, *geometry->uv(), vertexCount);
+    if(bucket.uv2) append(uv2s, *geometry->uv2(), vertexCount);
+
+    //mirroring transforms turn the triangles inside out
+    bool flip = matrix.determinant() < 0;
+
+    unsigned firstTriangle = indices.size() / 3;
+    const BufferAttributeT<uint32_t>::Ptr &index = geometry->index();
+    unsigned triangleCount = (index ? index->itemCount() : vertexCount) / 3;
+
+    for(unsigned t=0; t<triangleCount; t++) {
+      uint32_t a = index ? index->get_x(t * 3) : t * 3;
+      uint32_t b = index ? index->get_x(t * 3 + 1) : t * 3 + 1;
+      uint32_t c = index ? index->get_x(t * 3 + 2) : t * 3 + 2;
+
+      if(flip) swap(b, c);
+      indices.insert(indices.end(), {firstVertex + a, firstVertex + b, firstVertex + c});
+    }
+
+    sources.push_back({mesh, firstTriangle, triangleCount, firstVertex, (bool)index});
+  }
+
+  BufferGeometry::Ptr geometry = BufferGeometry::make();
+  geometry->setPosition(toAttribute<Vector3>(positions));
+  geometry->setIndex(attribute::copied<uint32_t>(indices));
+
+  if(bucket.normal) geometry->setNormal(toAttribute<Vector3>(normals));
+  if(bucket.uv) geometry->setUV(toAttribute<Vector2>(uvs));
+  if(bucket.uv2) geometry->setUV2(toAttribute<Vector2>(uv2s));
+  if(bucket.colorSize == 3) geometry->setColor(toAttribute<Vector3>(colors));
+  else if(bucket.colorSize == 4) geometry->setColor(toAttribute<Vector4>(colors));
+
+  Geometry &geom = *geometry;
+  geom.computeBoundingBox();
+  geom.computeBoundingSphere();
+
+  return geometry;
+}
+
+}
+
+std::vector<BatchedMesh::Ptr> StaticBatcher::batch(const Object3D::Ptr &root)
+{
+  return batch(root, Options());
+}
+
+std::vector<BatchedMesh::Ptr> StaticBatcher::batch(const Object3D::Ptr &root, const Options &options)
+{
+  std::vector<Bucket> buckets;
+  collect(root, options, buckets);
+
+  Matrix4 toRoot = root->matrixWorld().inverted();
+
+  std::vector<BatchedMesh::Ptr> batches;
+
+  for(const Bucket &bucket : buckets) {
+    if(bucket.meshes.size() < std::max(options.minMeshes, 1u)) continue;
+
+    //split into batches of at most maxVertices
+    auto begin = bucket.meshes.begin();
+    while(begin != bucket.meshes.end()) {
+
+      auto end = begin;
+      unsigned vertices = 0;
+      do {
+        BufferGeometry *geometry = (*end)->geometry()->typer;
+        vertices += geometry->position()->itemCount();
+        end++;
+      } while(end != bucket.meshes.end() && vertices < options.maxVertices);
+
+      std::vector<BatchedMesh::Source> sources;
+      BufferGeometry::Ptr geometry = build(bucket, begin, end, toRoot, sources);
+
+      BatchedMesh::Ptr batch(new BatchedMesh(geometry, bucket.material));
+      batch->castShadow = bucket.castShadow;
+      batch->receiveShadow = bucket.receiveShadow;
+      batch->_renderOrder = bucket.renderOrder;
+      batch->_layers = bucket.layers;
+      batch->_sources = std::move(sources);
+      batches.push_back(batch);
+
+      begin = end;
+    }
+
+    if(options.removeSources) {
+      for(const Mesh::Ptr &mesh : bucket.meshes) {
+        Object3D *parent = mesh->parent();
+        if(!parent) continue;
+
+        //descendants which were not merged stay in the scene, keeping their world transforms
+        std::vector<Object3D::Ptr> children = mesh->children();
+        for(const Object3D::Ptr &child : children) {
+          child->apply(mesh->cmatrix());
+          parent->add(child);
+        }
+        parent->remove(mesh);
+      }
+    }
+  }
+
+  for(const BatchedMesh::Ptr &batch : batches) root->add(batch);
+
+  return batches;
+}
+
+}
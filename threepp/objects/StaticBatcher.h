@@ -0,0 +1,117 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#ifndef THREEPP_STATICBATCHER_H
+#define THREEPP_STATICBATCHER_H
+
+#include <functional>
+#include <threepp/core/BufferGeometry.h>
+#include "Mesh.h"
+
+namespace three {
+
+/**
+ * a mesh holding the merged geometry of several static meshes which share a material. The
+ * vertices are pre-transformed, so the batch is drawn with a single call.
+ *
+ * Raycasting reports intersections against the source meshes: Intersection::object is the
+ * source mesh, and faceIndex, index and face refer to the source geometry
+ */
+class DLX BatchedMesh : public Mesh
+{
+  friend class StaticBatcher;
+
+public:
+  /**
+   * a mesh merged into the batch
+   */
+  struct Source
+  {
+    Object3D::Ptr object;
+
+    //first triangle and vertex inside the batch
+    unsigned firstTriangle;
+    unsigned triangleCount;
+    unsigned firstVertex;
+
+    //whether the source geometry was indexed
+    bool indexed;
+  };
+
+private:
+  //ordered by firstTriangle
+  std::vector<Source> _sources;
+
+protected:
+  BatchedMesh(const BufferGeometry::Ptr &geometry, const Material::Ptr &material)
+     : Mesh(geometry, {material})
+  {
+    Object3D::typer = object::Typer(this);
+    typer.allow<Mesh>();
+  }
+
+  BatchedMesh(const BatchedMesh &mesh) : Mesh(mesh), _sources(mesh._sources)
+  {
+    Object3D::typer = object::Typer(this);
+    typer.allow<Mesh>();
+  }
+
+public:
+  using Ptr = std::shared_ptr<BatchedMesh>;
+
+  const std::vector<Source> &sources() const {return _sources;}
+
+  /**
+   * @return the source containing the batch triangle, or nullptr
+   */
+  const Source *source(unsigned triangle) const;
+
+  void raycast(const Raycaster &raycaster, IntersectList &intersects) override;
+
+  BatchedMesh *cloned() const override {
+    return new BatchedMesh(*this);
+  }
+};
+
+/**
+ * merges static meshes sharing a material into BatchedMesh objects, reducing the number of
+ * draw calls for scenes made up of many small meshes, as produced by the model loaders.
+ *
+ * Eligible are meshes with a single material and a triangle BufferGeometry without morph targets
+ * or skinning. Meshes are only merged if they also agree on the attributes present, shadow
+ * casting and receiving, render order and layers. Meshes with a negative determinant world matrix
+ * get their triangle winding reversed. Invisible objects and everything below them are skipped.
+ */
+class DLX StaticBatcher
+{
+public:
+  struct Options
+  {
+    // maximum number of vertices in one batch. Smaller batches are culled more effectively
+    unsigned maxVertices = 256 * 1024;
+
+    // minimum number of meshes sharing a material for a batch to be built
+    unsigned minMeshes = 2;
+
+    // remove the merged meshes from the scene graph. Their children are moved to their parents
+    bool removeSources = true;
+
+    // additional selection, e.g. by name or user data. Objects for which it returns false are
+    // skipped together with their descendants. All eligible meshes are merged if not set
+    std::function<bool(const Object3D &)> filter;
+  };
+
+  /**
+   * merge the meshes below root. Vertices are transformed into the space of root, and the
+   * batches added to root. World matrices must be up to date.
+   *
+   * @return the batches
+   */
+  static std::vector<BatchedMesh::Ptr> batch(const Object3D::Ptr &root, const Options &options);
+
+  static std::vector<BatchedMesh::Ptr> batch(const Object3D::Ptr &root);
+};
+
+}
+#endif //THREEPP_STATICBATCHER_H
@@ -56,9 +56,9 @@ void Camera::setController(CameraController *controller)
 
 void Camera::updateControllerValues()
 {
-  const math::Vector3 &p = _camera->position();
+  const math::Vector3 &p = _camera->cposition();
   setPosition(QVector3D(p.x(), p.y(), p.z()), false);
-  const math::Euler &r = _camera->rotation();
+  const math::Euler &r = _camera->crotation();
   setRotation(QVector3D(r.x(), r.y(), r.z()), false);
 }
 
@@ -93,7 +93,7 @@ public:
       if(_camera) {
         updateControllerValues();
 
-        const math::Euler &r = _camera->rotation();
+        const math::Euler &r = _camera->crotation();
         _rotation = QVector3D(r.x(), r.y(), r.z());
         emit rotationChanged();
       }
@@ -92,6 +92,18 @@ three::Resource::Ptr FileSystemLoader::get(const char *path, ios_base::openmode
   }
 }
 
+string FileSystemLoader::cachePath(const char *path)
+{
+  if(file.fileName() != path) return string();
+
+  //the cache lives next to the model and is discarded once the model changes
+  QFileInfo cache(file.absoluteFilePath() + ".scenecache");
+  if(cache.exists() && cache.lastModified() < file.lastModified()) {
+    QFile::remove(cache.absoluteFilePath());
+  }
+  return cache.absoluteFilePath().toStdString();
+}
+
 void FileSystemLoader::load(QImage &image, const string &file)
 {
   //fix spurious backslashes
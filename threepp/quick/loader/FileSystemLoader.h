@@ -43,6 +43,8 @@ public:
 
   void load(QImage &image, const std::string &file) override;
 
+  std::string cachePath(const char *path) override;
+
 private slots:
   void sendResult();
 
@@ -6,6 +6,8 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QFile>
+#include <mutex>
+#include <unordered_map>
 
 #include <threepp/extras/core/Font.h>
 
@@ -77,6 +79,29 @@ void loadFont(extras::FontData &fontData, const QJsonObject &json)
   }
 }
 
+/**
+ * fonts are loaded once per file and kept
+ */
+extras::Font loadFont(const QString &path)
+{
+  static std::mutex mutex;
+  static std::unordered_map<std::string, extras::Font> fonts;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  auto found = fonts.find(path.toStdString());
+  if(found != fonts.end()) return found->second;
+
+  QFile file(path);
+  file.open(QIODevice::Text | QIODevice::ReadOnly);
+  QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+
+  std::shared_ptr<extras::FontData> fontData = std::make_shared<extras::FontData>();
+  loadFont(*fontData, doc.object());
+
+  return fonts.emplace(path.toStdString(), extras::Font(fontData)).first->second;
+}
+
 void Text3D::append_material(QQmlListProperty<Material> *list, Material *obj)
 {
   Text3D *item = qobject_cast<Text3D *>(list->object);
@@ -107,18 +132,9 @@ QQmlListProperty<Material> Text3D::materials()
                                     &Text3D::clear_materials);
 }
 
-three::Object3D::Ptr Text3D::_create()
+Geometry::Ptr Text3D::createGeometry()
 {
-  if(_font.isEmpty()) return nullptr;
-
-  QFile file(_font);
-  file.open(QIODevice::Text | QIODevice::ReadOnly);
-  QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-
-  extras::FontData fontData;
-  loadFont(fontData, doc.object());
-
-  geometry::TextOptions options {extras::Font(fontData)};
+  geometry::TextOptions options {loadFont(_font)};
   options.height = _height;
   options.size = _size;
   options.curveSegments = _curveSegments;
@@ -126,16 +142,25 @@ three::Object3D::Ptr Text3D::_create()
   options.bevelSize = _bevelSize;
   options.bevelEnabled = _bevelEnabled;
 
+  //keep the cache while this object uses it
+  _glyphCache = geometry::GlyphCache::get(options);
+  options.glyphCache = _glyphCache;
+
   switch(_geometryType) {
-    case Three::BufferGeometry: {
-      _mesh = DynamicMesh::make(geometry::buffer::Text::make(_text.toStdWString(), options));
-      break;
-    }
-    case Three::LinearGeometry: {
-      _mesh = DynamicMesh::make(geometry::Text::make(_text.toStdWString(), options));
-      break;
-    }
+    case Three::BufferGeometry:
+      return geometry::buffer::Text::make(_text.toStdWString(), options);
+    case Three::LinearGeometry:
+      return geometry::Text::make(_text.toStdWString(), options);
   }
+  return nullptr;
+}
+
+three::Object3D::Ptr Text3D::_create()
+{
+  if(_font.isEmpty()) return nullptr;
+
+  _mesh = DynamicMesh::make(createGeometry());
+
   for(const auto &mat : _materials) {
     _mesh->addMaterial(mat->getMaterial());
   }
@@ -154,6 +179,7 @@ three::Object3D::Ptr Text3D::_copy(Object3D::Ptr copyable)
 void Text3D::setText(QString text) {
   if(_text != text) {
     _text = text;
+    if(_mesh && !_font.isEmpty()) _mesh->setGeometry(createGeometry());
     emit textChanged();
   }
 }
@@ -169,6 +195,7 @@ void Text3D::setFont(QString font) {
 void Text3D::setSize(float size) {
   if(_size != size) {
     _size = size;
+    recreate();
     emit sizeChanged();
   }
 }
@@ -44,6 +44,9 @@ class Text3D : public ThreeQObject
   QQmlListProperty<Material> materials();
 
   DynamicMesh::Ptr _mesh;
+  geometry::GlyphCache::Ptr _glyphCache;
+
+  Geometry::Ptr createGeometry();
 
 protected:
   three::Object3D::Ptr _copy(Object3D::Ptr copyable) override;
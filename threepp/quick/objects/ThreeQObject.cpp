@@ -167,7 +167,7 @@ void ThreeQObject::setObject(const three::Object3D::Ptr object)
       object->position().set(_position().x(), _position().y(), _position().z());
     }
     else {
-      const math::Vector3 pos = _object->position();
+      const math::Vector3 pos = _object->cposition();
       setPosition(QVector3D(pos.x(), pos.y(), pos.z()), false);
       _position.unset();
     }
@@ -176,7 +176,7 @@ void ThreeQObject::setObject(const three::Object3D::Ptr object)
       object->rotation().set(_rotation().x(), _rotation().y(), _rotation().z());
     }
     else {
-      const math::Euler rot = _object->rotation();
+      const math::Euler rot = _object->crotation();
       setRotation(QVector3D(rot.x(), rot.y(), rot.z()), false);
       _rotation.unset();
     }
@@ -196,7 +196,7 @@ void ThreeQObject::setObject(const three::Object3D::Ptr object)
       _object->scale().set(_scale().x(), _scale().y(), _scale().z());
     }
     else {
-      const math::Vector3 &s = _object->scale();
+      const math::Vector3 &s = _object->cscale();
       setScale(QVector3D(s.x(), s.y(), s.z()), false);
       _scale.unset();
     }
@@ -281,7 +281,7 @@ void ThreeQObject::lookAt(const QVector3D &position)
   if(_object) {
     _object->lookAt(math::Vector3(position.x(), position.y(), position.z()));
 
-    const math::Euler rot = _object->rotation();
+    const math::Euler rot = _object->crotation();
     setRotation(QVector3D(rot.x(), rot.y(), rot.z()), false);
   }
 }
@@ -141,9 +141,9 @@ void Scene::setItem(ThreeDItem *item)
     _scene = three::Scene::make(_name.toStdString());
   }
 
-  _position.setX(_scene->position().x());
-  _position.setY(_scene->position().y());
-  _position.setZ(_scene->position().z());
+  _position.setX(_scene->cposition().x());
+  _position.setY(_scene->cposition().y());
+  _position.setZ(_scene->cposition().z());
   positionChanged();
 
   if(_fog) _scene->fog() = _fog->create();
@@ -14,6 +14,37 @@
 
 namespace three {
 
+/**
+ * when to run glValidateProgram before draw calls. Validation forces a driver round-trip,
+ * so validating on every draw is meant for debugging only
+ */
+enum class ProgramValidation
+{
+  Off, Once, EveryDraw
+};
+
+/**
+ * how render() synchronizes with the GPU at the end of each call. Finish blocks until all
+ * commands are complete. Fences only blocks once more than maxFramesInFlight submissions
+ * are still executing, letting the CPU prepare the next frame(s) meanwhile. Fences needs sync
+ * objects (OpenGL 3.2, OpenGL ES 3.0 or ARB_sync) and falls back to Finish without them
+ */
+enum class FramePacing
+{
+  Finish, Fences
+};
+
+/**
+ * program binary cache statistics. Hits are programs loaded from the cache, misses programs
+ * which had to be compiled. Rejected binaries were found but not accepted by the driver
+ */
+struct ProgramCacheInfo
+{
+  unsigned hits = 0;
+  unsigned misses = 0;
+  unsigned rejected = 0;
+};
+
 struct DLX OpenGLRendererOptions
 {
   bool alpha = false;
@@ -22,6 +53,42 @@ struct DLX OpenGLRendererOptions
   bool antialias = false;
   bool premultipliedAlpha = true;
   bool preserveDrawingBuffer = false;
+
+  // keep the per-frame render lists in flat arrays with packed sort keys instead of
+  // reference-counted items. Pays off with many visible objects
+  bool flatRenderLists = false;
+
+  // validate each program before its first draw only
+  ProgramValidation programValidation = ProgramValidation::Once;
+
+  FramePacing framePacing = FramePacing::Finish;
+  unsigned maxFramesInFlight = 2;
+
+  // keep the attribute setup of each geometry/program pair in a vertex array object
+  bool vertexArrayObjects = true;
+
+  // share camera, fog and light uniforms between all programs through uniform buffer objects,
+  // if supported by the context
+  bool uniformBuffers = true;
+
+  // directory where linked program binaries are kept across runs. Empty disables the cache
+  std::string programCacheDir;
+
+  // prepare image textures on worker threads and upload them over several frames, showing a
+  // placeholder until done. textureUploadBudget limits the bytes uploaded per frame
+  bool asyncTextureUploads = false;
+  size_t textureUploadBudget = 8 * 1024 * 1024;
+
+  // sub-allocate static attribute and index buffers up to bufferArenaMaxAllocation bytes from
+  // shared buffers of bufferArenaPageSize bytes, instead of creating one buffer object each
+  bool bufferArena = false;
+  size_t bufferArenaPageSize = 4 * 1024 * 1024;
+  size_t bufferArenaMaxAllocation = 64 * 1024;
+
+  // re-render a shadow map (or a point light's cube face) only if the light, the shadow camera
+  // or any of the casters drawn into it changed. Changes to custom depth material uniforms are
+  // not detected and need ShadowMap::setNeedsUpdate
+  bool incrementalShadows = false;
 };
 
 class DLX OpenGLRenderer : public Renderer, public OpenGLRendererOptions
@@ -54,6 +121,19 @@ public:
   virtual void setFaceCulling( CullFace cullFace ) = 0;
   virtual void setFaceDirection(FrontFaceDirection frontFaceDirection ) = 0;
   virtual void clear() = 0;
+
+  /**
+   * block until all previously submitted GL commands have completed
+   */
+  virtual void finish() = 0;
+
+  /**
+   * compile the programs for all materials in the scene ahead of the first frame, so rendering
+   * does not stall on shader compilation. Must be called with the context current
+   */
+  virtual void compile(const Scene::Ptr &scene, const Camera::Ptr &camera) = 0;
+
+  virtual const ProgramCacheInfo &programCacheInfo() const = 0;
 };
 
 }
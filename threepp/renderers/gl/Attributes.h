@@ -5,27 +5,46 @@
 #ifndef THREEPP_ATTRIBUTES_H
 #define THREEPP_ATTRIBUTES_H
 
-#include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 #include <threepp/core/BufferAttribute.h>
 #include <threepp/Constants.h>
 #include "Helpers.h"
+#include "BufferArena.h"
 
 namespace three {
 namespace gl {
 
 class Attributes
 {
-  QOpenGLFunctions * const _fn;
+  QOpenGLExtraFunctions * const _fn;
   std::unordered_map<sole::uuid, Buffer> _buffers;
 
+  BufferArena _arena;
+
+  //number of buffers deleted or moved so far. Buffer handles may be reused after deletion
+  size_t _deletions = 0;
+
   void createBuffer(Buffer &buffer, const BufferAttribute &attribute, BufferType bufferType)
   {
-    GLenum usage = attribute.dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+    BufferArena::Allocation allocation;
 
-    _fn->glGenBuffers(1, &buffer.handle);
+    //dynamic buffers are updated in ranges, so they keep their own buffer
+    if(!attribute.dynamic && _arena.allocate(bufferType, attribute.byteCount(), attribute.uuid, allocation)) {
 
-    _fn->glBindBuffer((GLenum)bufferType, buffer.handle);
-    _fn->glBufferData((GLenum)bufferType, attribute.byteCount(), attribute.data(0), usage);
+      assign(buffer, allocation);
+      _arena.upload(allocation.handle, allocation.offset, attribute.data(0), attribute.byteCount());
+    }
+    else {
+      GLenum usage = attribute.dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+
+      _fn->glGenBuffers(1, &buffer.handle);
+
+      _fn->glBindBuffer((GLenum)bufferType, buffer.handle);
+      _fn->glBufferData((GLenum)bufferType, attribute.byteCount(), attribute.data(0), usage);
+
+      buffer.offset = 0;
+      buffer.shared = false;
+    }
 
     const_cast<BufferAttribute &>(attribute).onUpload.emitSignal(attribute);
 
@@ -34,13 +53,57 @@ class Attributes
     buffer.version = attribute.version();
   }
 
+  static void assign(Buffer &buffer, const BufferArena::Allocation &allocation)
+  {
+    buffer.handle = allocation.handle;
+    buffer.offset = allocation.offset;
+    buffer.capacity = allocation.size;
+    buffer.page = allocation.page;
+    buffer.shared = true;
+  }
+
+  void deleteBuffer(const Buffer &buffer)
+  {
+    if(buffer.shared) {
+      BufferArena::Allocation allocation;
+      allocation.handle = buffer.handle;
+      allocation.offset = buffer.offset;
+      allocation.size = buffer.capacity;
+      allocation.page = buffer.page;
+
+      //blocks moved out of sparse pages get a new handle and offset
+      _arena.free(allocation, [this](const sole::uuid &owner, const BufferArena::Allocation &moved) {
+        auto found = _buffers.find(owner);
+        if(found != _buffers.end()) assign(found->second, moved);
+      });
+    }
+    else {
+      _fn->glDeleteBuffers(1, &buffer.handle);
+    }
+    _deletions++;
+  }
+
 public:
-  Attributes(QOpenGLFunctions *fn) : _fn(fn) {}
+  Attributes(QOpenGLExtraFunctions *fn, MemoryInfo &memoryInfo) : _fn(fn), _arena(fn, memoryInfo) {}
 
-  void updateBuffer(const Buffer &buffer, BufferAttribute &attribute, BufferType bufferType)
+  BufferArena &arena() {return _arena;}
+
+  void updateBuffer(Buffer &buffer, BufferAttribute &attribute, BufferType bufferType)
   {
     UpdateRange &updateRange = attribute.updateRange();
 
+    if(buffer.shared) {
+      if(attribute.byteCount() <= buffer.capacity) {
+        _arena.upload(buffer.handle, buffer.offset, attribute.data(0), attribute.byteCount());
+      }
+      else {
+        //outgrew its block
+        deleteBuffer(buffer);
+        createBuffer(buffer, attribute, bufferType);
+      }
+      return;
+    }
+
     _fn->glBindBuffer((GLenum)bufferType, buffer.handle);
 
     if(!attribute.dynamic) {
@@ -64,6 +127,8 @@ public:
     }
   }
 
+  size_t deletions() const {return _deletions;}
+
   bool has(const BufferAttribute &attribute )
   {
     return _buffers.count(attribute.uuid) > 0;
@@ -82,11 +147,10 @@ public:
 
     if (_buffers.find(attribute.uuid) != _buffers.end()) {
 
-      const Buffer &data = _buffers[ attribute.uuid ];
-
-      _fn->glDeleteBuffers(1, &data.handle);
-
+      Buffer data = _buffers[ attribute.uuid ];
       _buffers.erase(attribute.uuid);
+
+      deleteBuffer(data);
     }
   }
 
@@ -0,0 +1,184 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#include "BufferArena.h"
+
+namespace three {
+namespace gl {
+
+using namespace std;
+
+BufferArena::~BufferArena()
+{
+  for(auto &page : _pages) {
+    if(page.handle) _fx->glDeleteBuffers(1, &page.handle);
+  }
+}
+
+void BufferArena::init(bool enable, size_t pageSize, size_t maxAllocation)
+{
+  _enabled = enable;
+  _pageSize = (pageSize + alignment - 1) / alignment * alignment;
+  _maxAllocation = min(maxAllocation, _pageSize);
+}
+
+bool BufferArena::allocate(Page &page, unsigned index, size_t size, const sole::uuid &owner, Allocation &allocation)
+{
+  if(page.size - page.used < size) return false;
+
+  //first fit
+  for(auto it = page.free.begin(); it != page.free.end(); it++) {
+    if(it->second < size) continue;
+
+    size_t offset = it->first;
+    size_t remaining = it->second - size;
+    page.free.erase(it);
+    if(remaining) page.free[offset + size] = remaining;
+
+    page.blocks[offset] = make_pair(size, owner);
+    page.used += size;
+
+    allocation.handle = page.handle;
+    allocation.offset = offset;
+    allocation.size = size;
+    allocation.page = index;
+    return true;
+  }
+  return false;
+}
+
+bool BufferArena::allocate(BufferType type, size_t size, const sole::uuid &owner, Allocation &allocation)
+{
+  if(!_enabled || size == 0 || size > _maxAllocation) return false;
+
+  size = (size + alignment - 1) / alignment * alignment;
+
+  for(unsigned i=0; i<_pages.size(); i++) {
+    Page &page = _pages[i];
+    if(page.handle && page.type == type && allocate(page, i, size, owner, allocation)) {
+      updateMemoryInfo();
+      return true;
+    }
+  }
+
+  //reuse a released slot, if any
+  unsigned index = 0;
+  while(index < _pages.size() && _pages[index].handle) index++;
+  if(index == _pages.size()) _pages.emplace_back();
+
+  Page &page = _pages[index];
+  page = Page();
+  page.type = type;
+  page.size = _pageSize;
+  page.free[0] = _pageSize;
+
+  //the copy target doesn't disturb the vertex array's element array binding
+  _fx->glGenBuffers(1, &page.handle);
+  _fx->glBindBuffer(GL_COPY_WRITE_BUFFER, page.handle);
+  _fx->glBufferData(GL_COPY_WRITE_BUFFER, _pageSize, nullptr, GL_STATIC_DRAW);
+  _fx->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  allocate(page, index, size, owner, allocation);
+  updateMemoryInfo();
+  return true;
+}
+
+void BufferArena::release(Page &page, size_t offset, size_t size)
+{
+  page.blocks.erase(offset);
+  page.used -= size;
+
+  //merge with the adjacent free ranges
+  auto after = page.free.lower_bound(offset);
+  if(after != page.free.end() && after->first == offset + size) {
+    size += after->second;
+    after = page.free.erase(after);
+  }
+  if(after != page.free.begin()) {
+    auto before = prev(after);
+    if(before->first + before->second == offset) {
+      before->second += size;
+      return;
+    }
+  }
+  page.free[offset] = size;
+}
+
+void BufferArena::free(const Allocation &allocation, const Relocated &relocated)
+{
+  if(allocation.page >= _pages.size()) return;
+
+  Page &page = _pages[allocation.page];
+  if(!page.handle) return;
+
+  release(page, allocation.offset, allocation.size);
+
+  if(page.used > 0 && page.used < page.size / 4) evacuate(allocation.page, relocated);
+
+  if(page.used == 0) {
+    _fx->glDeleteBuffers(1, &page.handle);
+    page = Page();
+  }
+  updateMemoryInfo();
+}
+
+void BufferArena::evacuate(unsigned index, const Relocated &relocated)
+{
+  Page &page = _pages[index];
+
+  //blocks move into fuller pages only, so pages don't trade blocks back and forth
+  auto blocks = page.blocks;
+  for(const auto &block : blocks) {
+    size_t offset = block.first;
+    size_t size = block.second.first;
+    const sole::uuid &owner = block.second.second;
+
+    Allocation target;
+    bool moved = false;
+    for(unsigned i=0; i<_pages.size() && !moved; i++) {
+      Page &other = _pages[i];
+      if(i == index || !other.handle || other.type != page.type || other.used <= page.used) continue;
+
+      moved = allocate(other, i, size, owner, target);
+    }
+    if(!moved) return;
+
+    _fx->glBindBuffer(GL_COPY_READ_BUFFER, page.handle);
+    _fx->glBindBuffer(GL_COPY_WRITE_BUFFER, target.handle);
+    _fx->glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, target.offset, size);
+    _fx->glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    _fx->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    release(page, offset, size);
+
+    relocated(owner, target);
+  }
+}
+
+void BufferArena::upload(GLuint handle, size_t offset, const void *data, size_t size)
+{
+  _fx->glBindBuffer(GL_COPY_WRITE_BUFFER, handle);
+  _fx->glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+  _fx->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void BufferArena::updateMemoryInfo()
+{
+  _memory.arenaPages = 0;
+  _memory.arenaBytes = 0;
+  _memory.arenaUsed = 0;
+  _memory.arenaAllocations = 0;
+
+  for(const auto &page : _pages) {
+    if(!page.handle) continue;
+
+    _memory.arenaPages++;
+    _memory.arenaBytes += page.size;
+    _memory.arenaUsed += page.used;
+    _memory.arenaAllocations += page.blocks.size();
+  }
+}
+
+}
+}
@@ -0,0 +1,113 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#ifndef THREEPP_BUFFERARENA_H
+#define THREEPP_BUFFERARENA_H
+
+#include <map>
+#include <vector>
+#include <functional>
+#include <QOpenGLExtraFunctions>
+#include <threepp/Constants.h>
+#include <threepp/util/sole.h>
+#include "Helpers.h"
+
+namespace three {
+namespace gl {
+
+/**
+ * sub-allocates small, static vertex and index buffers from large shared buffer pages, so that
+ * scenes with many small geometries don't end up with one GL buffer object per attribute.
+ *
+ * Each page serves one buffer type. Free ranges are kept in an offset-ordered free list and merged
+ * with their neighbours when a block is returned. Empty pages are deleted. When a page falls below
+ * a quarter of its capacity, its remaining blocks are copied into fuller pages, so that the page
+ * can be released.
+ */
+class BufferArena
+{
+public:
+  struct Allocation
+  {
+    GLuint handle = 0;
+    size_t offset = 0;
+    size_t size = 0;
+    unsigned page = 0;
+  };
+
+  using Relocated = std::function<void(const sole::uuid &owner, const Allocation &allocation)>;
+
+private:
+  //offsets and sizes are multiples of this, which satisfies all attribute and index alignments
+  static const size_t alignment = 16;
+
+  struct Page
+  {
+    GLuint handle = 0;
+    BufferType type;
+    size_t size = 0;
+    size_t used = 0;
+
+    //free ranges, offset -> size
+    std::map<size_t, size_t> free;
+
+    //allocated blocks, offset -> size and owner
+    std::map<size_t, std::pair<size_t, sole::uuid>> blocks;
+  };
+
+  QOpenGLExtraFunctions * const _fx;
+  MemoryInfo &_memory;
+
+  bool _enabled = false;
+  size_t _pageSize = 0;
+  size_t _maxAllocation = 0;
+
+  //released pages keep their slot with handle 0, so page indices stay valid
+  std::vector<Page> _pages;
+
+  bool allocate(Page &page, unsigned index, size_t size, const sole::uuid &owner, Allocation &allocation);
+
+  void release(Page &page, size_t offset, size_t size);
+
+  void evacuate(unsigned index, const Relocated &relocated);
+
+  void updateMemoryInfo();
+
+public:
+  BufferArena(QOpenGLExtraFunctions *fx, MemoryInfo &memory) : _fx(fx), _memory(memory) {}
+
+  ~BufferArena();
+
+  /**
+   * @param enable whether to sub-allocate. Requires glCopyBufferSubData (GL 3.1, GL ES 3.0)
+   * @param pageSize the size of the shared buffers
+   * @param maxAllocation larger buffers get their own buffer object
+   */
+  void init(bool enable, size_t pageSize, size_t maxAllocation);
+
+  bool enabled() const {return _enabled;}
+
+  /**
+   * allocate a block from a page of the given type, creating a new page if needed
+   *
+   * @return false if the arena is disabled or size exceeds the maximum allocation
+   */
+  bool allocate(BufferType type, size_t size, const sole::uuid &owner, Allocation &allocation);
+
+  /**
+   * return a block. If its page becomes sparse, the remaining blocks are moved to other pages
+   * and reported through relocated
+   */
+  void free(const Allocation &allocation, const Relocated &relocated);
+
+  /**
+   * write data to an allocated block
+   */
+  void upload(GLuint handle, size_t offset, const void *data, size_t size);
+};
+
+}
+}
+
+#endif //THREEPP_BUFFERARENA_H
@@ -49,9 +49,21 @@ void DefaultBufferRenderer::renderInstances(InstancedBufferGeometry::Ptr geometr
   else if (_mode == DrawMode::Points) _renderInfo.points += geometry->maxInstancedCount() * count;
 }
 
+void DefaultBufferRenderer::renderInstances(GLint start, GLsizei count, GLsizei instances)
+{
+  _fx->glDrawArraysInstanced((GLenum)_mode, start, count, instances);
+  check_glerror(_fn);
+
+  _renderInfo.calls ++;
+  _renderInfo.vertices += count * instances;
+
+  if (_mode == DrawMode::Triangles) _renderInfo.faces += instances * count / 3;
+  else if (_mode == DrawMode::Points) _renderInfo.points += instances * count;
+}
+
 void IndexedBufferRenderer::render(GLint start, GLsizei count)
 {
-  _fn->glDrawElements((GLenum)_mode, count, _type, (GLvoid *)(start * _bytesPerElement));
+  _fn->glDrawElements((GLenum)_mode, count, _type, (GLvoid *)(_offset + start * _bytesPerElement));
 
   _renderInfo.calls ++;
   _renderInfo.vertices += count;
@@ -70,7 +82,7 @@ void IndexedBufferRenderer::renderInstances(InstancedBufferGeometry::Ptr geometr
        "BufferRenderer: using InstancedBufferGeometry but hardware does not support ANGLE_instanced_arrays");
   }
 
-  _fx->glDrawElementsInstanced((GLenum)_mode, count, _type, (const void *)(start * _bytesPerElement), geometry->maxInstancedCount() );
+  _fx->glDrawElementsInstanced((GLenum)_mode, count, _type, (const void *)(_offset + start * _bytesPerElement), geometry->maxInstancedCount() );
 
   _renderInfo.calls ++;
   _renderInfo.vertices += count * geometry->maxInstancedCount();
@@ -79,5 +91,17 @@ void IndexedBufferRenderer::renderInstances(InstancedBufferGeometry::Ptr geometr
   else if (_mode == DrawMode::Points) _renderInfo.points += geometry->maxInstancedCount() * count;
 }
 
+void IndexedBufferRenderer::renderInstances(GLint start, GLsizei count, GLsizei instances)
+{
+  _fx->glDrawElementsInstanced((GLenum)_mode, count, _type, (const void *)(_offset + start * _bytesPerElement), instances);
+  check_glerror(_fn);
+
+  _renderInfo.calls ++;
+  _renderInfo.vertices += count * instances;
+
+  if (_mode == DrawMode::Triangles) _renderInfo.faces += instances * count / 3;
+  else if (_mode == DrawMode::Points) _renderInfo.points += instances * count;
+}
+
 };
-}
\ No newline at end of file
+}
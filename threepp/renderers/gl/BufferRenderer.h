@@ -35,6 +35,7 @@ public:
 
   virtual void render(GLint start, GLsizei count) = 0;
   virtual void renderInstances(InstancedBufferGeometry::Ptr geometry, GLint start, GLsizei count) = 0;
+  virtual void renderInstances(GLint start, GLsizei count, GLsizei instances) = 0;
 };
 
 class DefaultBufferRenderer : public BufferRenderer
@@ -48,12 +49,15 @@ public:
 
   void render(GLint start, GLsizei count) override;
   void renderInstances(InstancedBufferGeometry::Ptr geometry, GLint start, GLsizei count) override;
+  void renderInstances(GLint start, GLsizei count, GLsizei instances) override;
 };
 
 class IndexedBufferRenderer : public BufferRenderer
 {
   GLenum _type = 0;
   GLsizei _bytesPerElement = 0;
+  //byte offset of the indices inside the element array buffer
+  size_t _offset = 0;
 
 public:
   IndexedBufferRenderer(QOpenGLFunctions *fn, QOpenGLExtraFunctions *fnx,
@@ -62,14 +66,16 @@ public:
   {
   }
 
-  void setIndex(GLenum type, GLsizei bytes)
+  void setIndex(GLenum type, GLsizei bytes, size_t offset=0)
   {
     _type = type;
     _bytesPerElement = bytes;
+    _offset = offset;
   }
 
   void render(GLint start, GLsizei count) override;
   void renderInstances(InstancedBufferGeometry::Ptr geometry, GLint start, GLsizei count) override;
+  void renderInstances(GLint start, GLsizei count, GLsizei instances) override;
 };
 
 }
@@ -14,7 +14,7 @@
 namespace three {
 namespace gl {
 
-enum class Extension : uint16_t
+enum class Extension : uint32_t
 {
   ARB_depth_texture               = 1,
   EXT_frag_depth                  = 1<<1,
@@ -29,12 +29,15 @@ enum class Extension : uint16_t
   OES_standard_derivatives        = 1<<10,
   ANGLE_instanced_arrays          = 1<<11,
   OES_element_index_uint          = 1<<12,
-  GLEXT_draw_buffers              = 1<<13
+  GLEXT_draw_buffers              = 1<<13,
+  ARB_uniform_buffer_object       = 1<<14,
+  ARB_get_program_binary          = 1<<15,
+  ARB_sync                        = 1<<16
 };
 
 class UseExtension
 {
-  uint16_t bits;
+  uint32_t bits;
 
   template<typename Ret> static Ret decl() {return (Ret)0;}
   template<typename Ret, Extension e, Extension... Args> static Ret decl() {
@@ -42,16 +45,16 @@ class UseExtension
   };
 
 public:
-  UseExtension(uint16_t bits=0) : bits(bits) {}
+  UseExtension(uint32_t bits=0) : bits(bits) {}
 
   template <Extension ... extensions>
   static UseExtension use()
   {
-    return UseExtension(decl<uint16_t, extensions...>());
+    return UseExtension(decl<uint32_t, extensions...>());
   }
 
   UseExtension &add(Extension ext) {
-    bits |= (uint16_t)ext;
+    bits |= (uint32_t)ext;
     return *this;
   }
 
@@ -124,6 +127,25 @@ public:
       case Extension::EXT_frag_depth:
         _extensions[extension] = context->hasExtension("EXT_frag_depth");
         break;
+      case Extension::ARB_uniform_buffer_object:
+        //core in OpenGL 3.1 and OpenGL ES 3.0
+        _extensions[extension] = context->hasExtension("GL_ARB_uniform_buffer_object")
+           || context->format().majorVersion() > 3
+           || context->format().majorVersion() == 3 && (context->isOpenGLES() || context->format().minorVersion() >= 1);
+        break;
+      case Extension::ARB_get_program_binary:
+        //core in OpenGL 4.1 and OpenGL ES 3.0
+        _extensions[extension] = context->hasExtension("GL_ARB_get_program_binary")
+           || context->isOpenGLES() && context->format().majorVersion() >= 3
+           || context->format().majorVersion() > 4
+           || context->format().majorVersion() == 4 && context->format().minorVersion() >= 1;
+        break;
+      case Extension::ARB_sync:
+        //core in OpenGL 3.2 and OpenGL ES 3.0
+        _extensions[extension] = context->hasExtension("GL_ARB_sync")
+           || context->format().majorVersion() > 3
+           || context->format().majorVersion() == 3 && (context->isOpenGLES() || context->format().minorVersion() >= 2);
+        break;
     }
     return _extensions[extension];
   }
@@ -22,8 +22,8 @@ class Geometries
     BufferGeometry::Ptr geometry;
     BufferGeometry::OnDispose::ConnectionId connectionId;
   };
-  std::unordered_map<unsigned, GeometryInfo> geometries;
-  std::unordered_map<unsigned, BufferAttributeT<uint32_t>::Ptr> wireframeAttributes;
+  std::unordered_map<uint64_t, GeometryInfo> geometries;
+  std::unordered_map<uint64_t, BufferAttributeT<uint32_t>::Ptr> wireframeAttributes;
 
   unsigned geometryCount = 0;
 
@@ -38,6 +38,7 @@ class Geometries
       _attributes.remove( *buffergeometry->index() );
     }
 
+    if(buffergeometry->packed()) _attributes.remove(*buffergeometry->packed());
     if(buffergeometry->position()) _attributes.remove(*buffergeometry->position());
     if(buffergeometry->normal()) _attributes.remove(*buffergeometry->normal());
     if(buffergeometry->color()) _attributes.remove(*buffergeometry->color());
@@ -94,11 +95,26 @@ public:
       _attributes.update(*buffergeometry->getIndex(), BufferType::ElementArray);
     }
 
-    if(buffergeometry->position()) _attributes.update(*buffergeometry->position(), BufferType::Array);
-    if(buffergeometry->normal()) _attributes.update(*buffergeometry->normal(), BufferType::Array);
-    if(buffergeometry->color()) _attributes.update(*buffergeometry->color(), BufferType::Array);
-    if(buffergeometry->uv()) _attributes.update(*buffergeometry->uv(), BufferType::Array);
-    if(buffergeometry->uv2()) _attributes.update(*buffergeometry->uv2(), BufferType::Array);
+    PackedVertexBuffer::Ptr packed = buffergeometry->packed();
+    if(packed && packed->outdated(*buffergeometry)) {
+
+      //the layout may change, so this needs a new buffer
+      _attributes.remove(*packed);
+      packed = buffergeometry->compile(packed->options()).packed();
+    }
+    if(packed) _attributes.update(*packed, BufferType::Array);
+
+    //attributes in the packed buffer are not uploaded separately
+    auto update = [&](const BufferAttributeT<float>::Ptr &attribute, AttributeName name) {
+      if(attribute && !(packed && packed->layout(name)))
+        _attributes.update(*attribute, BufferType::Array);
+    };
+
+    update(buffergeometry->position(), AttributeName::position);
+    update(buffergeometry->normal(), AttributeName::normal);
+    update(buffergeometry->color(), AttributeName::color);
+    update(buffergeometry->uv(), AttributeName::uv);
+    update(buffergeometry->uv2(), AttributeName::uv2);
 
     // morph targets
 
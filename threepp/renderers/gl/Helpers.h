@@ -15,6 +15,13 @@ namespace gl {
 struct MemoryInfo {
   unsigned geomtries = 0;
   unsigned textures = 0;
+
+  //buffer arena occupancy: shared buffer pages, their total size, the bytes allocated from them
+  //and the number of allocations
+  unsigned arenaPages = 0;
+  size_t arenaBytes = 0;
+  size_t arenaUsed = 0;
+  unsigned arenaAllocations = 0;
 };
 
 struct RenderInfo
@@ -24,6 +31,13 @@ struct RenderInfo
   unsigned  vertices = 0;
   unsigned  faces = 0;
   unsigned  points = 0;
+
+  //world matrices recomputed while updating the scene graph
+  unsigned  matrices = 0;
+
+  //glUniform* calls issued, and skipped because the location already held the value
+  unsigned  uniformCalls = 0;
+  unsigned  uniformsSkipped = 0;
 };
 
 struct Buffer
@@ -32,6 +46,13 @@ struct Buffer
   GLenum type;
   unsigned bytesPerElement;
   unsigned version;
+
+  //byte offset of the data inside the buffer object, which is shared if the buffer was
+  //sub-allocated from the buffer arena
+  size_t offset = 0;
+  bool shared = false;
+  size_t capacity = 0;
+  unsigned page = 0;
 };
 
 inline bool clear_glerror(QOpenGLFunctions *f)
@@ -11,6 +11,8 @@ using namespace std;
 
 void Lights::setup(const vector<Light::Ptr> &lights, unsigned numShadows, Camera::Ptr camera )
 {
+  state.clear();
+
   Color ambient {0, 0, 0};
 
   const math::Matrix4 &viewMatrix = camera->matrixWorldInverse();
@@ -46,6 +48,7 @@ void Lights::setup(const vector<Light::Ptr> &lights, unsigned numShadows, Camera
       if(shadowMap) {
         state.directionalShadowMap.push_back(shadowMap);
         state.directionalShadowMatrix.push_back(light->shadow()->matrix());
+        state.directionalShadowCascades.push_back(dlight->shadow_t()->cascadeMatrix());
       }
       state.directional.push_back(uniforms);
     }
@@ -103,7 +103,7 @@ struct Entry<RectAreaLight> : public EntryBase
 class UniformsCache
 {
 public:
-  std::unordered_map<unsigned, lights::EntryBase::Ptr> lights;
+  std::unordered_map<uint64_t, lights::EntryBase::Ptr> lights;
 
 public:
 
@@ -158,6 +158,7 @@ struct Lights
   struct State {
     std::vector<Texture::Ptr> directionalShadowMap;
     std::vector<math::Matrix4> directionalShadowMatrix;
+    std::vector<math::Matrix4> directionalShadowCascades;
     CachedDirectionalLights directional;
     std::vector<Texture::Ptr> spotShadowMap;
     std::vector<math::Matrix4> spotShadowMatrix;
@@ -183,6 +184,7 @@ struct Lights
       hemi.clear();
       directionalShadowMap.clear();
       directionalShadowMatrix.clear();
+      directionalShadowCascades.clear();
       spotShadowMap.clear();
       spotShadowMatrix.clear();
       pointShadowMap.clear();
@@ -23,7 +23,7 @@ class MorphTargets
   std::array<float, 8> _morphInfluences;
 
   using Influence = std::pair<size_t, float>;
-  std::unordered_map<uint32_t, std::vector<Influence>> _influencesList;
+  std::unordered_map<uint64_t, std::vector<Influence>> _influencesList;
 
 public:
   MorphTargets(QOpenGLFunctions *fn) : _fn(fn) {}
@@ -15,7 +15,7 @@ namespace gl {
 
 class Objects
 {
-  std::unordered_map<unsigned, unsigned> _updateList;
+  std::unordered_map<uint64_t, unsigned> _updateList;
 
   Geometries &_geometries;
   RenderInfo &_infoRender;
@@ -109,6 +109,22 @@ generateExtensions(Extensions &extensions, const ProgramParameters &parameters)
 
 }
 
+/**
+ * declare the per-frame uniform block, see UniformBlocks. Must be identical in both shaders
+ */
+static void generateFrameBlock(ostream &ss)
+{
+  ss << "layout(std140) uniform Frame {" << endl;
+  ss << "  mat4 projectionMatrix;" << endl;
+  ss << "  mat4 viewMatrix;" << endl;
+  ss << "  vec3 cameraPosition;" << endl;
+  ss << "  float fogDensity;" << endl;
+  ss << "  vec3 fogColor;" << endl;
+  ss << "  float fogNear;" << endl;
+  ss << "  float fogFar;" << endl;
+  ss << "};" << endl;
+}
+
 string generateDefines(unordered_map<string, string> defines)
 {
   stringstream ss;
@@ -183,6 +199,12 @@ void Program::fetchAttributeLocations(enum_map<AttributeName, GLint> &attributes
     else if(!strncmp(info.name, "normal", 100)) {
       attributes[AttributeName::normal] = _renderer.glGetAttribLocation(_program, info.name);
     }
+    else if(!strncmp(info.name, "instanceMatrix", 100)) {
+      attributes[AttributeName::instanceMatrix] = _renderer.glGetAttribLocation(_program, info.name);
+    }
+    else if(!strncmp(info.name, "instanceColor", 100)) {
+      attributes[AttributeName::instanceColor] = _renderer.glGetAttribLocation(_program, info.name);
+    }
     else {
       throw std::logic_error("unknown attribute");
     }
@@ -325,7 +347,7 @@ Program::Program(Renderer_impl &renderer,
                  const Material::Ptr &material,
                  Shader &shader,
                  ProgramParameters::Ptr parameters )
-   : parameters(parameters), _renderer(renderer), _cachedAttributes({make_pair(AttributeName::unknown, 0)})
+   : id(++programIdCount), parameters(parameters), _renderer(renderer), _cachedAttributes({make_pair(AttributeName::unknown, 0)})
 {
   using namespace string_out;
 
@@ -425,6 +447,7 @@ Program::Program(Renderer_impl &renderer,
     ss << "#version 300" << endl;
 #else
     ss << "#version 120" << endl;
+    if(*parameters->uniformBlocks) ss << "#extension GL_ARB_uniform_buffer_object : enable" << endl;
 #endif
     ss << "#ifdef GL_ES" << endl;
     ss << "precision " << *parameters->precision << " float;" << endl;
@@ -463,6 +486,12 @@ Program::Program(Renderer_impl &renderer,
 
     if(*parameters->morphTargets) ss << "#define USE_MORPHTARGETS" << endl;
     if(*parameters->morphNormals && !*parameters->flatShading) ss << "#define USE_MORPHNORMALS" << endl;
+    if(*parameters->instancing) ss << "#define USE_INSTANCING" << endl;
+    if(*parameters->instancingColor) ss << "#define USE_INSTANCING_COLOR" << endl;
+    if(*parameters->quantizedPosition) ss << "#define QUANTIZED_POSITION" << endl;
+    if(*parameters->quantizedNormal) ss << "#define QUANTIZED_NORMAL" << endl;
+    if(*parameters->quantizedUV) ss << "#define QUANTIZED_UV" << endl;
+    if(*parameters->quantizedUV2) ss << "#define QUANTIZED_UV2" << endl;
     if(*parameters->doubleSided) ss << "#define DOUBLE_SIDED" << endl;
     if(*parameters->flipSided) ss << "#define FLIP_SIDED" << endl;
 
@@ -479,10 +508,17 @@ Program::Program(Renderer_impl &renderer,
 
     ss << "uniform mat4 modelMatrix;" << endl;
     ss << "uniform mat4 modelViewMatrix;" << endl;
-    ss << "uniform mat4 projectionMatrix;" << endl;
-    ss << "uniform mat4 viewMatrix;" << endl;
     ss << "uniform mat3 normalMatrix;" << endl;
-    ss << "uniform vec3 cameraPosition;" << endl;
+
+    if(*parameters->uniformBlocks) {
+      ss << "#define USE_UNIFORM_BLOCKS" << endl;
+      generateFrameBlock(ss);
+    }
+    else {
+      ss << "uniform mat4 projectionMatrix;" << endl;
+      ss << "uniform mat4 viewMatrix;" << endl;
+      ss << "uniform vec3 cameraPosition;" << endl;
+    }
 
     ss << "attribute vec3 position;" << endl;
     ss << "attribute vec3 normal;" << endl;
@@ -494,6 +530,35 @@ Program::Program(Renderer_impl &renderer,
 
     ss << "#endif" << endl;
 
+    ss << "#ifdef QUANTIZED_POSITION" << endl;
+
+    ss << "	uniform vec3 positionOffset;" << endl;
+    ss << "	uniform vec3 positionScale;" << endl;
+
+    ss << "#endif" << endl;
+
+    ss << "#ifdef QUANTIZED_NORMAL" << endl;
+
+    ss << "	vec3 octDecode( vec2 e ) {" << endl;
+    ss << "		vec3 v = vec3( e, 1.0 - abs( e.x ) - abs( e.y ) );" << endl;
+    ss << "		if ( v.z < 0.0 ) v.xy = ( 1.0 - abs( v.yx ) ) * vec2( v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0 );" << endl;
+    ss << "		return normalize( v );" << endl;
+    ss << "	}" << endl;
+
+    ss << "#endif" << endl;
+
+    ss << "#ifdef QUANTIZED_UV" << endl;
+
+    ss << "	uniform vec4 uvRange;" << endl;
+
+    ss << "#endif" << endl;
+
+    ss << "#ifdef QUANTIZED_UV2" << endl;
+
+    ss << "	uniform vec4 uv2Range;" << endl;
+
+    ss << "#endif" << endl;
+
     ss << "#ifdef USE_MORPHTARGETS" << endl;
 
     ss << "	attribute vec3 morphTarget0;" << endl;
@@ -526,6 +591,18 @@ Program::Program(Renderer_impl &renderer,
 
     ss << "#endif" << endl;
 
+    ss << "#ifdef USE_INSTANCING" << endl;
+
+    ss << "	attribute mat4 instanceMatrix;" << endl;
+
+    ss << "#endif" << endl;
+
+    ss << "#ifdef USE_INSTANCING_COLOR" << endl;
+
+    ss << "	attribute vec3 instanceColor;" << endl;
+
+    ss << "#endif" << endl;
+
     prefixVertex = ss.str();
 
     ss.seekp(stringstream::beg);
@@ -536,6 +613,7 @@ Program::Program(Renderer_impl &renderer,
     ss << "#version 300" << endl;
 #else
     ss << "#version 120" << endl;
+    if(*parameters->uniformBlocks) ss << "#extension GL_ARB_uniform_buffer_object : enable" << endl;
 #endif
     ss << customExtensions;
 
@@ -572,6 +650,7 @@ Program::Program(Renderer_impl &renderer,
     if(*parameters->metalnessMap) ss << "#define USE_METALNESSMAP" << endl;
     if(*parameters->alphaMap) ss << "#define USE_ALPHAMAP" << endl;
     if(*parameters->vertexColors != Colors::None) ss << "#define USE_COLOR" << endl;
+    if(*parameters->instancingColor) ss << "#define USE_INSTANCING_COLOR" << endl;
 
     if(*parameters->gradientMap) ss << "#define USE_GRADIENTMAP" << endl;
 
@@ -596,8 +675,14 @@ Program::Program(Renderer_impl &renderer,
 
     if(*parameters->envMap && extensions.get(Extension::EXT_shader_texture_lod)) ss << "#define TEXTURE_LOD_EXT" << endl;
 
-    ss << "uniform mat4 viewMatrix;" << endl;
-    ss << "uniform vec3 cameraPosition;" << endl;
+    if(*parameters->uniformBlocks) {
+      ss << "#define USE_UNIFORM_BLOCKS" << endl;
+      generateFrameBlock(ss);
+    }
+    else {
+      ss << "uniform mat4 viewMatrix;" << endl;
+      ss << "uniform vec3 cameraPosition;" << endl;
+    }
 
     if(( *parameters->toneMapping != ToneMapping::None)) {
       ss << "#define TONE_MAPPING" << endl;
@@ -647,6 +732,28 @@ Program::Program(Renderer_impl &renderer,
   string vertexGlsl = prefixVertex + vertexShader;
   string fragmentGlsl = prefixFragment + fragmentShader;
 
+  // Force a particular attribute to index 0.
+  // programs with morphTargets displace position out of attribute 0
+  string index0Attribute = !parameters->index0AttributeName.empty() ? parameters->index0AttributeName
+                                                                    : (*parameters->morphTargets ? "position" : "");
+
+  ProgramCache &cache = _renderer._programCache;
+  uint64_t cacheKey = cache.key(vertexGlsl, fragmentGlsl, index0Attribute);
+
+  if(!cache.load(_program, cacheKey)) {
+
+    link(vertexGlsl, fragmentGlsl, index0Attribute);
+    cache.store(_program, cacheKey);
+  }
+
+  if(*parameters->uniformBlocks) UniformBlocks::bindProgram(&_renderer, _program);
+
+  fetchAttributeLocations(_cachedAttributes, _cachedIndexedAttributes);
+  check_glerror(&_renderer);
+}
+
+void Program::link(const string &vertexGlsl, const string &fragmentGlsl, const string &index0Attribute)
+{
   GLuint glVertexShader = createShader(&_renderer, GL_VERTEX_SHADER, vertexGlsl );
   GLuint glFragmentShader = createShader(&_renderer, GL_FRAGMENT_SHADER, fragmentGlsl );
 
@@ -654,19 +761,15 @@ Program::Program(Renderer_impl &renderer,
   _renderer.glAttachShader( _program, glFragmentShader );
   check_glerror(&_renderer);
 
-  // Force a particular attribute to index 0.
-
-  if (!parameters->index0AttributeName.empty()) {
-
-    _renderer.glBindAttribLocation( _program, 0, parameters->index0AttributeName.data());
-  }
-  else if (*parameters->morphTargets) {
+  if (!index0Attribute.empty()) {
 
-    // programs with morphTargets displace position out of attribute 0
-    _renderer.glBindAttribLocation( _program, 0, "position" );
+    _renderer.glBindAttribLocation( _program, 0, index0Attribute.data());
   }
   check_glerror(&_renderer);
 
+  if(_renderer._programCache.enabled())
+    _renderer.glProgramParameteri( _program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+
   _renderer.glLinkProgram( _program );
 
   string programLog = getInfoLog(&_renderer, InfoObject::program, _program );
@@ -697,9 +800,6 @@ Program::Program(Renderer_impl &renderer,
   }
   else if ( !programLog.empty()) cerr << programLog << endl;
 
-  fetchAttributeLocations(_cachedAttributes, _cachedIndexedAttributes);
-  check_glerror(&_renderer);
-
            // clean up
   _renderer.glDeleteShader( glVertexShader );
   _renderer.glDeleteShader( glFragmentShader );
@@ -731,6 +831,7 @@ const std::unordered_map<IndexedAttributeKey, GLint> &Program::getIndexedAttribu
 }
 
 Program::~Program() {
+  _renderer._vertexArrays.releaseProgram(id);
   _renderer.glDeleteProgram(_program);
   _program = 0;
 }
@@ -226,6 +226,13 @@ public:
   ProgramParameterT<bool>            useVertexTexture {all};
   ProgramParameterT<bool>            morphTargets {all};
   ProgramParameterT<bool>            morphNormals {all};
+  ProgramParameterT<bool>            instancing {all};
+  ProgramParameterT<bool>            instancingColor {all};
+  ProgramParameterT<bool>            uniformBlocks {all};
+  ProgramParameterT<bool>            quantizedPosition {all};
+  ProgramParameterT<bool>            quantizedNormal {all};
+  ProgramParameterT<bool>            quantizedUV {all};
+  ProgramParameterT<bool>            quantizedUV2 {all};
   ProgramParameterT<size_t>          maxMorphTargets {all};
   ProgramParameterT<size_t>          maxMorphNormals {all};
   ProgramParameterT<size_t>          numDirLights {all};
@@ -328,6 +335,11 @@ private:
   void fetchAttributeLocations(enum_map<AttributeName, GLint> &attributes,
                                std::unordered_map<IndexedAttributeKey, GLint> &indexedAttributes);
 
+  /**
+   * compile the shaders and link the program
+   */
+  void link(const std::string &vertexGlsl, const std::string &fragmentGlsl, const std::string &index0Attribute);
+
   Program(Renderer_impl &renderer,
           Extensions &extensions,
           const Material::Ptr &material,
@@ -349,8 +361,14 @@ public:
   GLuint handle() const
   { return _program; }
 
+  //unique, unlike the GL handle which may be reused after deletion
+  const unsigned id;
+
   const ProgramParameters::Ptr parameters;
 
+  //set once the program has been checked with glValidateProgram
+  bool validated = false;
+
   Uniforms::Ptr getUniforms();
 
   const enum_map<AttributeName, GLint> &getAttributes();
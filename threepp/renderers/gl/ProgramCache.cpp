@@ -0,0 +1,150 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#include "ProgramCache.h"
+#include <fstream>
+#include <vector>
+#include <cstdio>
+#include <QDir>
+#include <QDebug>
+
+namespace three {
+namespace gl {
+
+using namespace std;
+
+namespace {
+
+//FNV-1a. Stable across runs and platforms, unlike std::hash
+uint64_t fnv1a(uint64_t hash, const char *data, size_t size)
+{
+  for(size_t i=0; i<size; i++) {
+    hash ^= (uint8_t)data[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+uint64_t fnv1a(uint64_t hash, const string &str)
+{
+  //include the terminator so that concatenations don't collide
+  return fnv1a(hash, str.c_str(), str.size() + 1);
+}
+
+const uint64_t fnv1a_basis = 0xcbf29ce484222325ull;
+
+const uint32_t file_magic = 0x42505054; //"TPPB"
+
+struct FileHeader
+{
+  uint32_t magic;
+  uint32_t format;
+  uint32_t length;
+};
+
+}
+
+void ProgramCache::init(const string &directory, bool supported)
+{
+  _directory = directory;
+  _enabled = false;
+
+  if(_directory.empty() || !supported) return;
+
+  GLint numFormats = 0;
+  _fx->glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+  if(numFormats <= 0) return;
+
+  if(!QDir().mkpath(QString::fromStdString(_directory))) {
+    qWarning() << "unable to create program cache directory" << QString::fromStdString(_directory);
+    return;
+  }
+
+  _driverHash = fnv1a_basis;
+  for(GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+    const GLubyte *str = _fx->glGetString(name);
+    if(str) _driverHash = fnv1a(_driverHash, string((const char *)str));
+  }
+  _enabled = true;
+}
+
+uint64_t ProgramCache::key(const string &vertexGlsl, const string &fragmentGlsl, const string &index0Attribute) const
+{
+  uint64_t hash = fnv1a(_driverHash, vertexGlsl);
+  hash = fnv1a(hash, fragmentGlsl);
+  return fnv1a(hash, index0Attribute);
+}
+
+string ProgramCache::path(uint64_t key) const
+{
+  char name[24];
+  snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+  return _directory + "/" + name;
+}
+
+bool ProgramCache::load(GLuint program, uint64_t key)
+{
+  if(!_enabled) return false;
+
+  ifstream in(path(key), ios::binary);
+  FileHeader header;
+
+  if(!in.read((char *)&header, sizeof(header)) || header.magic != file_magic) {
+    _info.misses++;
+    return false;
+  }
+
+  vector<char> binary(header.length);
+  if(!in.read(binary.data(), binary.size())) {
+    _info.misses++;
+    return false;
+  }
+
+  _fx->glProgramBinary(program, header.format, binary.data(), header.length);
+
+  GLint linked = GL_FALSE;
+  _fx->glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+  if(linked != GL_TRUE) {
+    _info.rejected++;
+    _info.misses++;
+    return false;
+  }
+
+  _info.hits++;
+  return true;
+}
+
+void ProgramCache::store(GLuint program, uint64_t key)
+{
+  if(!_enabled) return;
+
+  GLint length = 0;
+  _fx->glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if(length <= 0) return;
+
+  vector<char> binary(length);
+  GLenum format;
+  _fx->glGetProgramBinary(program, length, &length, &format, binary.data());
+
+  FileHeader header {file_magic, format, (uint32_t)length};
+
+  //write to a temporary file first, so that readers never see a partial binary
+  string file = path(key);
+  string temp = file + ".tmp";
+  {
+    ofstream out(temp, ios::binary | ios::trunc);
+    out.write((const char *)&header, sizeof(header));
+    out.write(binary.data(), length);
+    if(!out) {
+      qWarning() << "unable to write program cache file" << QString::fromStdString(temp);
+      return;
+    }
+  }
+  remove(file.c_str());
+  rename(temp.c_str(), file.c_str());
+}
+
+}
+}
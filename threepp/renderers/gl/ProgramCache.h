@@ -0,0 +1,67 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#ifndef THREEPP_PROGRAMCACHE_H
+#define THREEPP_PROGRAMCACHE_H
+
+#include <string>
+#include <QOpenGLExtraFunctions>
+#include <threepp/renderers/OpenGLRenderer.h>
+
+namespace three {
+namespace gl {
+
+/**
+ * keeps linked program binaries on disk, so that programs compiled in an earlier run can be
+ * loaded instead of compiled and linked again.
+ *
+ * Binaries are keyed by a hash of the complete shader sources, the attribute bound to location 0
+ * and the GL vendor, renderer and version strings. A binary the driver does not accept (e.g.
+ * after a driver update with unchanged version string) is replaced once the program is compiled.
+ */
+class ProgramCache
+{
+  QOpenGLExtraFunctions * const _fx;
+
+  std::string _directory;
+  bool _enabled = false;
+
+  uint64_t _driverHash = 0;
+
+  ProgramCacheInfo _info;
+
+  std::string path(uint64_t key) const;
+
+public:
+  explicit ProgramCache(QOpenGLExtraFunctions *fx) : _fx(fx) {}
+
+  /**
+   * @param directory the cache directory, created if missing. Empty to disable the cache
+   * @param supported whether the context supports program binaries
+   */
+  void init(const std::string &directory, bool supported);
+
+  bool enabled() const {return _enabled;}
+
+  uint64_t key(const std::string &vertexGlsl, const std::string &fragmentGlsl, const std::string &index0Attribute) const;
+
+  /**
+   * load the binary stored for key into program
+   *
+   * @return true if the program is now linked
+   */
+  bool load(GLuint program, uint64_t key);
+
+  /**
+   * store the binary of a linked program
+   */
+  void store(GLuint program, uint64_t key);
+
+  const ProgramCacheInfo &info() const {return _info;}
+};
+
+}
+}
+
+#endif //THREEPP_PROGRAMCACHE_H
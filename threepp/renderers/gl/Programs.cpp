@@ -184,6 +184,18 @@ ProgramParameters::Ptr Programs::getParameters(const Renderer_impl &renderer,
   parameters->maxMorphTargets = renderer._maxMorphTargets;
   parameters->maxMorphNormals = renderer._maxMorphNormals;
 
+  InstancedMesh *instanced = object->typer;
+  parameters->instancing = instanced != nullptr;
+  parameters->instancingColor = instanced && instanced->hasColors();
+
+  parameters->uniformBlocks = renderer._uniformBlocks.enabled();
+
+  unsigned quantized = Programs::quantized(*object);
+  parameters->quantizedPosition = (quantized & PackedVertexBuffer::Position) != 0;
+  parameters->quantizedNormal = (quantized & PackedVertexBuffer::Normal) != 0;
+  parameters->quantizedUV = (quantized & PackedVertexBuffer::UV) != 0;
+  parameters->quantizedUV2 = (quantized & PackedVertexBuffer::UV2) != 0;
+
   parameters->numDirLights = lights.directional.size();
   parameters->numPointLights = lights.point.size();
   parameters->numSpotLights = lights.spot.size();
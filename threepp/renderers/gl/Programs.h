@@ -59,6 +59,26 @@ public:
     }
   }
 
+  /**
+   * @return the packed vertex buffer of the object's geometry, if it was compiled
+   */
+  static PackedVertexBuffer *packedVertices(const Object3D &object)
+  {
+    if(!object.geometry()) return nullptr;
+
+    BufferGeometry *geometry = object.geometry()->typer;
+    return geometry ? geometry->packed().get() : nullptr;
+  }
+
+  /**
+   * @return the quantization bits of the object's packed vertices, 0 if not packed
+   */
+  static unsigned quantized(const Object3D &object)
+  {
+    PackedVertexBuffer *packed = packedVertices(object);
+    return packed ? packed->quantized() : 0;
+  }
+
   ProgramParameters::Ptr getParameters(const Renderer_impl &renderer,
                                        Material::Ptr material,
                                        Lights::State &lights,
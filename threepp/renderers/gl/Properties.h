@@ -34,16 +34,28 @@ struct MaterialProperties
   LightsHash lightsHash;
   size_t numClippingPlanes = 0;
   size_t numIntersection = 0;
+  bool instancing = false;
+  bool instancingColor = false;
+  unsigned quantized = 0;
+  //material.needsUpdate was consumed by another variant
+  bool needsUpdate = false;
   ShaderID shaderID = ShaderID::undefined;
   three::Shader shader;
   std::vector<Uniform::Ptr> uniformsList;
 };
 
+/**
+ * the properties of a material, keyed by the quantization bits of the geometries it is drawn with
+ * (see PackedVertexBuffer::quantized), so each vertex format keeps its own program
+ */
+using MaterialVariants = std::unordered_map<unsigned, MaterialProperties>;
+
 class Properties
 {
   std::unordered_map<sole::uuid, GlProperties> glProperties;
 
-  std::unordered_map<sole::uuid, MaterialProperties> materialProperties;
+  //materials get one set of properties per vertex format, see MaterialVariants
+  std::unordered_map<sole::uuid, MaterialVariants> materialProperties;
 
 public:
   GlProperties &getGlProperties(const sole::uuid &uuid)
@@ -51,9 +63,9 @@ public:
     return glProperties[uuid];
   }
 
-  MaterialProperties &getMaterialProperties(const sole::uuid &uuid)
+  MaterialProperties &getMaterialProperties(const sole::uuid &uuid, unsigned variant)
   {
-    return materialProperties[uuid];
+    return materialProperties[uuid][variant];
   }
 
   template<typename T, typename std::enable_if<!std::is_base_of<Material, T>{}, int>::type = 0>
@@ -81,15 +93,21 @@ public:
   }
 
   template<typename T, typename std::enable_if<std::is_base_of<Material, T>{}, int>::type = 0>
-  MaterialProperties &get(const T &material)
+  MaterialProperties &get(const T &material, unsigned variant)
+  {
+    return getMaterialProperties(material.uuid, variant);
+  }
+
+  template<typename T, typename std::enable_if<std::is_base_of<Material, T>{}, int>::type = 0>
+  MaterialProperties &get(const std::shared_ptr<T> material, unsigned variant)
   {
-    return getMaterialProperties(material.uuid);
+    return getMaterialProperties(material->uuid, variant);
   }
 
   template<typename T, typename std::enable_if<std::is_base_of<Material, T>{}, int>::type = 0>
-  MaterialProperties &get(const std::shared_ptr<T> material)
+  MaterialVariants &variants(const T &material)
   {
-    return getMaterialProperties(material->uuid);
+    return materialProperties[material.uuid];
   }
 
   template<typename T, typename std::enable_if<std::is_base_of<Material, T>{}, int>::type = 0>
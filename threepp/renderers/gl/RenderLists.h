@@ -5,6 +5,9 @@
 #ifndef THREEPP_GLRENDERERLISTS_H
 #define THREEPP_GLRENDERERLISTS_H
 
+#include <cstring>
+#include <map>
+#include <limits>
 #include <threepp/core/Object3D.h>
 #include <threepp/core/Geometry.h>
 #include <threepp/scene/Scene.h>
@@ -25,17 +28,56 @@ struct RenderItem
   float z;
   const Group *group;
 
-  RenderItem(Object3D::Ptr object, BufferGeometry::Ptr geometry, Material::Ptr material, float z, const Group *group,
-             Program::Ptr program=nullptr)
-     : object(object), geometry(geometry), material(material), program(program), renderOrder(object->renderOrder()),
-       z(z), group(group)
+  RenderItem(unsigned id, Object3D::Ptr object, BufferGeometry::Ptr geometry, Material::Ptr material, float z,
+             const Group *group, Program::Ptr program=nullptr)
+     : id(id), object(object), geometry(geometry), material(material), program(program),
+       renderOrder(object->renderOrder()), z(z), group(group)
   {}
 };
 
+/**
+ * returns a shared pointer that references, but does not own the object. Copying such a pointer
+ * does not touch any reference count. Only valid while the real owner keeps the object alive
+ */
+template <typename T>
+inline std::shared_ptr<T> unowned(T *t)
+{
+  return std::shared_ptr<T>(std::shared_ptr<T>(), t);
+}
+
+/**
+ * per-frame list of render items. In item mode (the default), each entry holds shared pointers
+ * to the participating objects. In flat mode, the list keeps raw handles in separate, contiguous
+ * arrays and orders them through a packed 64-bit key and a radix sort. Both modes produce the
+ * same opaque/transparent ordering
+ */
 class RenderList
 {
+  const bool _flat;
+
+  //item mode
   std::vector<RenderItem> _renderItems;
 
+  //flat mode, one entry per item in each array
+  std::vector<Object3D *> _objects;
+  std::vector<BufferGeometry *> _geometries;
+  std::vector<Material *> _materials;
+  std::vector<const Group *> _groups;
+  std::vector<int> _renderOrders;
+  std::vector<GLuint> _programs;
+  std::vector<uint64_t> _materialIds;
+  std::vector<uint32_t> _depths;
+
+  //value ranges seen since init(), used for packing the sort keys
+  int _minRenderOrder, _maxRenderOrder;
+  GLuint _minProgram, _maxProgram;
+  bool _missingProgram;
+  uint64_t _minMaterialId, _maxMaterialId;
+
+  //sort scratch space
+  std::vector<uint64_t> _keys, _keysTmp;
+  std::vector<size_t> _indexTmp;
+
   std::vector<size_t> _opaque;
   std::vector<size_t> _transparent;
 
@@ -85,25 +127,194 @@ class RenderList
     }
   }
 
+  /**
+   * map a float to an unsigned integer with the same ordering
+   */
+  static uint32_t depthKey(float z)
+  {
+    if(z == 0.0f) z = 0.0f; //fold -0 into +0
+
+    uint32_t bits;
+    std::memcpy(&bits, &z, sizeof(bits));
+    return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+  }
+
+  /**
+   * opaque key: renderOrder (8) | program (8) | material id offset (16) | depth (32), ascending
+   */
+  uint64_t opaqueKey(size_t i) const
+  {
+    uint64_t program = _programs[i] ? _programs[i] - _minProgram + 1 : 0;
+
+    return (uint64_t)(_renderOrders[i] - _minRenderOrder) << 56
+           | program << 48
+           | (_materialIds[i] - _minMaterialId) << 32
+           | _depths[i];
+  }
+
+  /**
+   * transparent key: inverted renderOrder (8) | unused (24) | depth (32), ascending
+   */
+  uint64_t transparentKey(size_t i) const
+  {
+    return (uint64_t)(_maxRenderOrder - _renderOrders[i]) << 56 | _depths[i];
+  }
+
+  /**
+   * whether all values seen since init() fit into the key fields. If not, sort() falls back
+   * to comparison sorting on the flat arrays. This is also the case if only some items have a
+   * program, since items without a program are not ordered by program at all
+   */
+  bool keysFit() const
+  {
+    bool noPrograms = _maxProgram < _minProgram;
+
+    return (int64_t)_maxRenderOrder - _minRenderOrder < 0x100
+           && (noPrograms || (!_missingProgram && _maxProgram - _minProgram < 0xFF))
+           && (_maxMaterialId < _minMaterialId || _maxMaterialId - _minMaterialId < 0x10000);
+  }
+
+  bool flatSortStable(size_t a, size_t b) const
+  {
+    if (_renderOrders[a] != _renderOrders[b])
+      return _renderOrders[a] < _renderOrders[b];
+    if (_programs[a] && _programs[b] && _programs[a] != _programs[b])
+      return _programs[a] < _programs[b];
+    if (_materialIds[a] != _materialIds[b])
+      return _materialIds[a] < _materialIds[b];
+    if (_depths[a] != _depths[b])
+      return _depths[a] < _depths[b];
+    return a < b;
+  }
+
+  bool flatReverseSortStable(size_t a, size_t b) const
+  {
+    if (_renderOrders[a] != _renderOrders[b])
+      return _renderOrders[a] > _renderOrders[b];
+    if (_depths[a] != _depths[b])
+      return _depths[a] < _depths[b];
+    return a > b;
+  }
+
+  /**
+   * stable LSD radix sort of indices by key, 8 bits per pass. Passes where all keys share the
+   * same digit are skipped
+   */
+  void radixSort(std::vector<size_t> &indices, std::vector<uint64_t> &keys)
+  {
+    size_t count = indices.size();
+
+    unsigned histogram[8][256];
+    std::memset(histogram, 0, sizeof(histogram));
+
+    for(size_t i=0; i<count; i++) {
+      uint64_t key = keys[i];
+      for(unsigned pass=0; pass<8; pass++)
+        histogram[pass][(key >> (pass * 8)) & 0xFF]++;
+    }
+
+    _keysTmp.resize(count);
+    _indexTmp.resize(count);
+
+    for(unsigned pass=0; pass<8; pass++) {
+
+      unsigned *h = histogram[pass];
+      unsigned shift = pass * 8;
+
+      if(h[(keys[0] >> shift) & 0xFF] == count) continue;
+
+      unsigned offset = 0;
+      for(unsigned b=0; b<256; b++) {
+        unsigned c = h[b];
+        h[b] = offset;
+        offset += c;
+      }
+
+      for(size_t i=0; i<count; i++) {
+        unsigned pos = h[(keys[i] >> shift) & 0xFF]++;
+        _keysTmp[pos] = keys[i];
+        _indexTmp[pos] = indices[i];
+      }
+      keys.swap(_keysTmp);
+      indices.swap(_indexTmp);
+    }
+  }
+
+  void sortFlat()
+  {
+    if(keysFit()) {
+      if(_opaque.size() > 1) {
+        _keys.resize(_opaque.size());
+        for(size_t i=0, l=_opaque.size(); i<l; i++) _keys[i] = opaqueKey(_opaque[i]);
+
+        radixSort(_opaque, _keys);
+      }
+      if(_transparent.size() > 1) {
+        //reverse first so that equal keys end up in descending insertion order
+        std::reverse(_transparent.begin(), _transparent.end());
+
+        _keys.resize(_transparent.size());
+        for(size_t i=0, l=_transparent.size(); i<l; i++) _keys[i] = transparentKey(_transparent[i]);
+
+        radixSort(_transparent, _keys);
+      }
+    }
+    else {
+      std::sort(_opaque.begin(), _opaque.end(), [this](size_t a, size_t b) {return flatSortStable(a, b);});
+      std::sort(_transparent.begin(), _transparent.end(),
+                [this](size_t a, size_t b) {return flatReverseSortStable(a, b);});
+    }
+  }
+
+  size_t add(const Object3D::Ptr &object, const BufferGeometry::Ptr &geometry, const Material::Ptr &material,
+             float z, const Group *group, const Program::Ptr &program)
+  {
+    if(!_flat) {
+      _renderItems.emplace_back((unsigned)_renderItems.size(), object, geometry, material, z, group, program);
+      return _renderItems.size() - 1;
+    }
+
+    int renderOrder = object->renderOrder();
+    GLuint handle = program ? program->handle() : 0;
+
+    _objects.push_back(object.get());
+    _geometries.push_back(geometry.get());
+    _materials.push_back(material.get());
+    _groups.push_back(group);
+    _renderOrders.push_back(renderOrder);
+    _programs.push_back(handle);
+    _materialIds.push_back(material->id);
+    _depths.push_back(depthKey(z));
+
+    if(renderOrder < _minRenderOrder) _minRenderOrder = renderOrder;
+    if(renderOrder > _maxRenderOrder) _maxRenderOrder = renderOrder;
+    if(material->id < _minMaterialId) _minMaterialId = material->id;
+    if(material->id > _maxMaterialId) _maxMaterialId = material->id;
+    if(handle) {
+      if(handle < _minProgram) _minProgram = handle;
+      if(handle > _maxProgram) _maxProgram = handle;
+    }
+    else
+      _missingProgram = true;
+    return _objects.size() - 1;
+  }
+
 public:
+  explicit RenderList(bool flat=false) : _flat(flat) {}
+
   class iterator
   {
     size_t _index;
     const std::vector<size_t> &_indizes;
-    const std::vector<RenderItem> &_renderItems;
+    const RenderList &_list;
 
   public:
     typedef iterator self_type;
-    typedef const RenderItem value_type;
-    typedef const RenderItem &reference;
-    typedef const RenderItem *pointer;
     typedef int difference_type;
     typedef std::forward_iterator_tag iterator_category;
 
-    iterator(const std::vector<size_t> &indizes,
-                const std::vector<RenderItem> &renderItems,
-                size_t index=0)
-       : _indizes(indizes), _renderItems(renderItems), _index(index)
+    iterator(const std::vector<size_t> &indizes, const RenderList &list, size_t index=0)
+       : _indizes(indizes), _list(list), _index(index)
     {}
 
     self_type operator++()
@@ -119,11 +330,36 @@ public:
       return *this;
     }
 
-    const reference operator*()
-    { return _renderItems[_indizes[_index]]; }
+    //in flat mode, the returned pointers do not own their objects
+    Object3D::Ptr object() const
+    {
+      size_t i = _indizes[_index];
+      return _list._flat ? unowned(_list._objects[i]) : _list._renderItems[i].object;
+    }
 
-    const pointer operator->()
-    { return &_renderItems[_indizes[_index]]; }
+    BufferGeometry::Ptr geometry() const
+    {
+      size_t i = _indizes[_index];
+      return _list._flat ? unowned(_list._geometries[i]) : _list._renderItems[i].geometry;
+    }
+
+    Material::Ptr material() const
+    {
+      size_t i = _indizes[_index];
+      return _list._flat ? unowned(_list._materials[i]) : _list._renderItems[i].material;
+    }
+
+    const Layers &layers() const
+    {
+      size_t i = _indizes[_index];
+      return _list._flat ? _list._objects[i]->layers() : _list._renderItems[i].object->layers();
+    }
+
+    const Group *group() const
+    {
+      size_t i = _indizes[_index];
+      return _list._flat ? _list._groups[i] : _list._renderItems[i].group;
+    }
 
     bool operator==(const self_type &rhs)
     { return _index == rhs._index; }
@@ -134,61 +370,96 @@ public:
     operator bool () {return _index < _indizes.size();}
   };
 
+  bool flat() const {return _flat;}
+
   void init()
   {
     _renderItems.clear();
+
+    _objects.clear();
+    _geometries.clear();
+    _materials.clear();
+    _groups.clear();
+    _renderOrders.clear();
+    _programs.clear();
+    _materialIds.clear();
+    _depths.clear();
+
+    _minRenderOrder = std::numeric_limits<int>::max();
+    _maxRenderOrder = std::numeric_limits<int>::min();
+    _minProgram = std::numeric_limits<GLuint>::max();
+    _maxProgram = 0;
+    _missingProgram = false;
+    _minMaterialId = std::numeric_limits<uint64_t>::max();
+    _maxMaterialId = 0;
+
     _opaque.clear();
     _transparent.clear();
   }
 
-  RenderList &push_back(Object3D::Ptr object, BufferGeometry::Ptr geometry, Material::Ptr material, unsigned z, const Group *group)
+  /**
+   * add an item. In flat mode, the caller must keep the objects alive until rendering is complete
+   */
+  RenderList &push_back(const Object3D::Ptr &object, const BufferGeometry::Ptr &geometry, const Material::Ptr &material,
+                        float z, const Group *group, const Program::Ptr &program=nullptr)
   {
-    _renderItems.emplace_back(object, geometry, material, z, group);
+    size_t index = add(object, geometry, material, z, group, program);
 
     if(material->transparent())
-      _transparent.push_back(_renderItems.size() - 1);
+      _transparent.push_back(index);
     else
-      _opaque.push_back(_renderItems.size() - 1);
+      _opaque.push_back(index);
     return *this;
   }
 
-  RenderList &push_front(Object3D::Ptr object, BufferGeometry::Ptr geometry, Material::Ptr material, unsigned z, const Group *group)
+  RenderList &push_front(const Object3D::Ptr &object, const BufferGeometry::Ptr &geometry, const Material::Ptr &material,
+                         float z, const Group *group, const Program::Ptr &program=nullptr)
   {
-    _renderItems.emplace_back(object, geometry, material, z, group);
+    size_t index = add(object, geometry, material, z, group, program);
 
     if(material->transparent())
-      _transparent.insert(_transparent.begin(), _renderItems.size() - 1);
+      _transparent.insert(_transparent.begin(), index);
     else
-      _opaque.insert(_opaque.begin(), _renderItems.size() - 1);
+      _opaque.insert(_opaque.begin(), index);
     return *this;
   }
 
-  iterator opaque() const {return iterator(_opaque, _renderItems);}
+  iterator opaque() const {return iterator(_opaque, *this);}
 
-  iterator transparent() const {return iterator(_transparent, _renderItems);}
+  iterator transparent() const {return iterator(_transparent, *this);}
 
   RenderList &sort()
   {
-    std::sort(_opaque.begin(), _opaque.end(), [this](size_t a, size_t b) {return painterSortStable(a, b);});
-    std::sort(_transparent.begin(), _transparent.end(),
-              [this](size_t a, size_t b) {return reversePainterSortStable(a, b);});
+    if(_flat) {
+      sortFlat();
+    }
+    else {
+      std::sort(_opaque.begin(), _opaque.end(), [this](size_t a, size_t b) {return painterSortStable(a, b);});
+      std::sort(_transparent.begin(), _transparent.end(),
+                [this](size_t a, size_t b) {return reversePainterSortStable(a, b);});
+    }
     return *this;
   }
 };
 
 class RenderLists
 {
-  std::unordered_map<uint32_t, RenderList> _lists;
+  std::map<std::pair<uint64_t, uint64_t>, RenderList> _lists;
+
+  const bool _flat;
 
 public:
+  explicit RenderLists(bool flat=false) : _flat(flat) {}
+
   RenderList *get(Scene::Ptr scene, Camera::Ptr camera)
   {
-    uint32_t key = (uint32_t)scene->id() << 16 | camera->id();
+    std::pair<uint64_t, uint64_t> key(scene->id(), camera->id());
 
-    if(_lists.count(key) == 0) {
-      _lists.emplace(key, RenderList());
+    auto found = _lists.find(key);
+    if(found == _lists.end()) {
+      found = _lists.emplace(key, RenderList(_flat)).first;
     }
-    return &_lists[key];
+    return &found->second;
   }
 
   void dispose()
@@ -23,7 +23,7 @@ using namespace std;
 
 OpenGLRenderer::Ptr OpenGLRenderer::make(size_t width, size_t height, float pixelRatio, const OpenGLRendererOptions &options)
 {
-  gl::Renderer_impl::Ptr p(new gl::Renderer_impl(width, height, pixelRatio));
+  gl::Renderer_impl::Ptr p(new gl::Renderer_impl(width, height, pixelRatio, options));
 
   return p;
 }
@@ -44,7 +44,7 @@ Renderer::Target::Ptr OpenGLRenderer::makeInternalTarget(
 
 namespace gl {
 
-const std::tuple<size_t, GLuint, bool> Renderer_impl::no_program {0, 0, false};
+const std::tuple<uint64_t, GLuint, bool> Renderer_impl::no_program {0, 0, false};
 
 class DeferredCalls
 {
@@ -79,24 +79,29 @@ public:
   void defer() {_active = true;}
 };
 
-Renderer_impl::Renderer_impl(size_t width, size_t height, float pixelRatio, bool premultipliedAlpha)
-   : _state(this),
+Renderer_impl::Renderer_impl(size_t width, size_t height, float pixelRatio, const OpenGLRendererOptions &options)
+   : OpenGLRenderer(options),
+     _state(this),
      _width(width),
      _height(height),
-     _attributes(this),
+     _attributes(this, _infoMemory),
+     _vertexArrays(this, _state, _attributes),
+     _uniformBlocks(this),
+     _programCache(this),
      _objects(_geometries, _infoRender),
      _geometries(_attributes),
      _capabilities(this, _extensions, _parameters ),
      _morphTargets(this),
      _shadowMap(*this, _objects, _capabilities),
      _programs(*this, _extensions, _capabilities),
-     _premultipliedAlpha(premultipliedAlpha),
-     _background(*this, _state, _geometries, premultipliedAlpha),
+     _premultipliedAlpha(options.premultipliedAlpha),
+     _background(*this, _state, _geometries, options.premultipliedAlpha),
      _textures(this, _extensions, _state, _properties, _capabilities, _infoMemory),
      _bufferRenderer(this, this, _extensions, _infoRender),
      _indexedBufferRenderer(this, this, _extensions, _infoRender),
      _spriteRenderer(*this, _state, _textures, _capabilities),
      _flareRenderer(this, _state, _textures, _capabilities),
+     _renderLists(options.flatRenderLists),
      _pixelRatio(pixelRatio)
 {
   _deferredCalls = new DeferredCalls(this);
@@ -104,6 +109,8 @@ Renderer_impl::Renderer_impl(size_t width, size_t height, float pixelRatio, bool
 
 Renderer_impl::~Renderer_impl()
 {
+  for(GLsync fence : _frameFences) glDeleteSync(fence);
+
   delete _deferredCalls;
 }
 
@@ -125,6 +132,20 @@ void Renderer_impl::initContext()
                    Extension::ANGLE_instanced_arrays});
 
   _capabilities.init();
+
+  _uniformBlocks.init(uniformBuffers && _extensions.get(Extension::ARB_uniform_buffer_object));
+  _programCache.init(programCacheDir, _extensions.get(Extension::ARB_get_program_binary));
+
+  // pixel unpack buffers and buffer mapping are core in GL 3.0 and GL ES 3.0
+  _textures.uploads().init(asyncTextureUploads, textureUploadBudget,
+                           QOpenGLContext::currentContext()->format().majorVersion() >= 3);
+
+  // the arena moves blocks using glCopyBufferSubData, core in GL 3.1 and GL ES 3.0
+  QSurfaceFormat format = QOpenGLContext::currentContext()->format();
+  bool copyBuffers = QOpenGLContext::currentContext()->isOpenGLES() ?
+                     format.majorVersion() >= 3 :
+                     format.majorVersion() > 3 || (format.majorVersion() == 3 && format.minorVersion() >= 1);
+  _attributes.arena().init(bufferArena && copyBuffers, bufferArenaPageSize, bufferArenaMaxAllocation);
 }
 
 void Renderer_impl::clear(bool color, bool depth, bool stencil)
@@ -171,19 +192,27 @@ void Renderer_impl::doRender(const Scene::Ptr &scene, const Camera::Ptr &camera,
 
   _deferredCalls->exec();
 
+  _textures.updateUploads();
+
   RenderTarget::Ptr target = dynamic_pointer_cast<RenderTarget>(renderTarget);
 
   // reset caching for this frame
   _currentGeometryProgram = no_program;
-  _currentMaterialId = -1;
+  _currentMaterialId = 0;
   _currentCamera = nullptr;
 
+  _uniformBlocks.bind();
+
+  size_t matrixUpdates = Object3D::matrixWorldUpdates();
+
   // update scene graph
   if (scene->autoUpdate()) scene->updateMatrixWorld(false);
 
   // update camera matrices and frustum
   if (!camera->parent()) camera->updateMatrixWorld(false);
 
+  _infoRender.matrices = (unsigned)(Object3D::matrixWorldUpdates() - matrixUpdates);
+
   _projScreenMatrix.multiply(camera->projectionMatrix(), camera->matrixWorldInverse());
   _frustum.set(_projScreenMatrix);
 
@@ -198,7 +227,10 @@ void Renderer_impl::doRender(const Scene::Ptr &scene, const Camera::Ptr &camera,
   _currentRenderList = _renderLists.get(scene, camera);
   _currentRenderList->init();
 
-  projectObject(scene, camera, _sortObjects);
+  if(SceneIndex *index = scene->spatialIndex())
+    projectIndexed(*index, camera, _sortObjects);
+  else
+    projectObject(scene, camera, _sortObjects);
 
   if (_sortObjects) {
     _currentRenderList->sort();
@@ -209,6 +241,7 @@ void Renderer_impl::doRender(const Scene::Ptr &scene, const Camera::Ptr &camera,
   _shadowMap.render(_shadowsArray, scene, camera);
 
   _lights.setup(_lightsArray, _shadowsArray.size(), camera);
+  _uniformBlocks.updateLights(_lights.state);
 
   if (_clippingEnabled) _clipping.endShadows();
 
@@ -217,6 +250,8 @@ void Renderer_impl::doRender(const Scene::Ptr &scene, const Camera::Ptr &camera,
   _infoRender.vertices = 0;
   _infoRender.faces = 0;
   _infoRender.points = 0;
+  _infoRender.uniformCalls = 0;
+  _infoRender.uniformsSkipped = 0;
 
   setRenderTarget(target);
 
@@ -235,6 +270,7 @@ void Renderer_impl::doRender(const Scene::Ptr &scene, const Camera::Ptr &camera,
     renderObjects(transparentObjects, scene, camera, scene->overrideMaterial);
 
   // custom renderers
+  _vertexArrays.unbind();
   _spriteRenderer.render(_spritesArray, scene, camera);
   _flareRenderer.render(_flaresArray, scene, camera, _currentViewport);
 
@@ -246,11 +282,78 @@ void Renderer_impl::doRender(const Scene::Ptr &scene, const Camera::Ptr &camera,
   _state.depthBuffer.setMask(true);
   _state.colorBuffer.setMask(true);
 
+  _vertexArrays.unbind();
   state().reset();
 
   _deferredCalls->defer();
 
+  paceFrame();
+}
+
+void Renderer_impl::paceFrame()
+{
+  if(framePacing == FramePacing::Finish || !_extensions.get(Extension::ARB_sync)) {
+    glFinish();
+    return;
+  }
+
+  _frameFences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+  check_glerror(this);
+
+  while(_frameFences.size() > maxFramesInFlight) {
+    GLsync fence = _frameFences.front();
+    _frameFences.pop_front();
+
+    GLenum result;
+    do {
+      result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    } while(result == GL_TIMEOUT_EXPIRED);
+
+    glDeleteSync(fence);
+    if(result == GL_WAIT_FAILED) check_glerror(this);
+  }
+  glFlush();
+}
+
+void Renderer_impl::finish()
+{
   glFinish();
+
+  for(GLsync fence : _frameFences) glDeleteSync(fence);
+  _frameFences.clear();
+}
+
+void Renderer_impl::compile(const Scene::Ptr &scene, const Camera::Ptr &camera)
+{
+  _lightsArray.clear();
+  _shadowsArray.clear();
+
+  // the program parameters depend on the lights, so set them up as for rendering
+  std::function<void(const Object3D::Ptr &)> collectLights = [&](const Object3D::Ptr &object) {
+    if(!object->visible()) return;
+
+    if(Light *light = object->typer) {
+      _lightsArray.push_back(CAST2(object, Light));
+      if(light->castShadow) _shadowsArray.push_back(CAST2(object, Light));
+    }
+    for(const auto &child : object->children()) collectLights(child);
+  };
+  collectLights(scene);
+
+  _lights.setup(_lightsArray, _shadowsArray.size(), camera);
+
+  std::function<void(const Object3D::Ptr &)> compileMaterials = [&](const Object3D::Ptr &object) {
+
+    if(object->is<Mesh>() || object->is<Line>() || object->is<Points>()) {
+
+      for(size_t i=0, n=object->materialCount(); i<n; i++) {
+        Material::Ptr material = object->material(i);
+        if(material) initMaterial(material, scene->fog(), object);
+      }
+    }
+    for(const auto &child : object->children()) compileMaterials(child);
+  };
+  compileMaterials(scene);
 }
 
 unsigned Renderer_impl::allocTextureUnit()
@@ -345,8 +448,7 @@ void Renderer_impl::renderObjects(RenderList::iterator renderIterator, Scene::Pt
 {
   while(renderIterator) {
 
-    const RenderItem &renderItem = *renderIterator;
-    Material::Ptr material = overrideMaterial ? overrideMaterial : renderItem.material;
+    Material::Ptr material = overrideMaterial ? overrideMaterial : renderIterator.material();
 
     if(ArrayCamera *acamera = camera->typer) {
 
@@ -356,7 +458,7 @@ void Renderer_impl::renderObjects(RenderList::iterator renderIterator, Scene::Pt
 
         PerspectiveCamera::Ptr camera2 = (*acamera)[ j ];
 
-        if ( renderItem.object->layers().test( camera2->layers() ) ) {
+        if ( renderIterator.layers().test( camera2->layers() ) ) {
 
           /*var bounds = camera2->bounds;
 
@@ -367,13 +469,13 @@ void Renderer_impl::renderObjects(RenderList::iterator renderIterator, Scene::Pt
 
           state.viewport( _currentViewport.set( x, y, width, height ).multiplyScalar( _pixelRatio ) );*/
 
-          renderObject( renderItem.object, scene, camera2, renderItem.geometry, material, renderItem.group );
+          renderObject( renderIterator.object(), scene, camera2, renderIterator.geometry(), material, renderIterator.group() );
         }
       }
     }
     else {
       _currentArrayCamera = nullptr;
-      renderObject( renderItem.object, scene, camera, renderItem.geometry, material, renderItem.group );
+      renderObject( renderIterator.object(), scene, camera, renderIterator.geometry(), material, renderIterator.group() );
     }
     renderIterator++;
   }
@@ -395,6 +497,7 @@ void Renderer_impl::renderObject(Object3D::Ptr object, Scene::Ptr scene, Camera:
 
     _currentGeometryProgram = no_program;
 
+    _vertexArrays.unbind();
     renderObjectImmediate( *iro, program, material );
   }
   else {
@@ -411,71 +514,90 @@ void Renderer_impl::projectObject(Object3D::Ptr object, Camera::Ptr camera, bool
   bool visible = object->layers().test(camera->layers());
   if (visible ) {
 
-    if(Light *light = object->typer) {
+    projectSingle(object, sortObjects, false);
+  }
 
-      _lightsArray.push_back(CAST2(object, Light));
+  for (Object3D::Ptr child : object->children()) {
 
-      if ( light->castShadow ) {
-        _shadowsArray.push_back( CAST2(object, Light) );
-      }
-    }
-    else if(Sprite *sprite = object->typer) {
+    projectObject( child, camera, sortObjects );
+  }
+}
 
-      if ( ! sprite->frustumCulled || _frustum.intersectsSprite(*sprite) ) {
-        _spritesArray.push_back( CAST2(object, Sprite));
-      }
+void Renderer_impl::projectIndexed(SceneIndex &index, Camera::Ptr camera, bool sortObjects)
+{
+  auto project = [&](const Object3D::Ptr &object, bool culled) {
+    if(object->layers().test(camera->layers()) && SceneIndex::visibleInScene(*object))
+      projectSingle(object, sortObjects, culled);
+  };
+
+  index.cull(_frustum, [&](const Object3D::Ptr &object) {project(object, true);});
+
+  for(const Object3D::Ptr &object : index.unculled()) project(object, false);
+}
+
+void Renderer_impl::projectSingle(const Object3D::Ptr &object, bool sortObjects, bool culled)
+{
+  if(Light *light = object->typer) {
+
+    _lightsArray.push_back(CAST2(object, Light));
+
+    if ( light->castShadow ) {
+      _shadowsArray.push_back( CAST2(object, Light) );
     }
-    else if(LensFlare *lflare = object->typer) {
+  }
+  else if(Sprite *sprite = object->typer) {
 
-      _flaresArray.push_back(CAST2(object, LensFlare));
+    if ( ! sprite->frustumCulled || _frustum.intersectsSprite(*sprite) ) {
+      _spritesArray.push_back( CAST2(object, Sprite));
     }
-    else if(ImmediateRenderObject *iro = object->typer) {
+  }
+  else if(LensFlare *lflare = object->typer) {
 
-      if ( sortObjects ) {
+    _flaresArray.push_back(CAST2(object, LensFlare));
+  }
+  else if(ImmediateRenderObject *iro = object->typer) {
 
-        _vector3 = object->matrixWorld().getPosition().apply( _projScreenMatrix );
-      }
-      _currentRenderList->push_back(object, nullptr, object->material(), _vector3.z(), nullptr );
+    if ( sortObjects ) {
+
+      _vector3 = object->matrixWorld().getPosition().apply( _projScreenMatrix );
     }
-    else if(object->is<Mesh>() || object->is<Line>() || object->is<Points>()) {
+    _currentRenderList->push_back(object, nullptr, object->material(), _vector3.z(), nullptr );
+  }
+  else if(object->is<Mesh>() || object->is<Line>() || object->is<Points>()) {
 
-      if(SkinnedMesh *skmesh = object->typer) {
-        skmesh->skeleton()->update();
-      }
-      if ( ! object->frustumCulled || _frustum.intersectsObject( *object ) ) {
+    if(SkinnedMesh *skmesh = object->typer) {
+      skmesh->skeleton()->update();
+    }
+    if ( culled || ! object->frustumCulled || _frustum.intersectsObject( *object ) ) {
 
-        if ( sortObjects ) {
-          _vector3 = object->matrixWorld().getPosition().apply( _projScreenMatrix );
-        }
+      if ( sortObjects ) {
+        _vector3 = object->matrixWorld().getPosition().apply( _projScreenMatrix );
+      }
 
-        BufferGeometry::Ptr geometry = _objects.update( object );
+      BufferGeometry::Ptr geometry = _objects.update( object );
 
-        if ( object->materialCount() > 1) {
+      if ( object->materialCount() > 1) {
 
-          const vector<Group> &groups = geometry->groups();
+        const vector<Group> &groups = geometry->groups();
 
-          for (const Group &group : groups) {
+        for (const Group &group : groups) {
 
-            Material::Ptr groupMaterial = object->material(group.materialIndex);
+          Material::Ptr groupMaterial = object->material(group.materialIndex);
 
-            if ( groupMaterial && groupMaterial->visible ) {
+          if ( groupMaterial && groupMaterial->visible ) {
 
-              _currentRenderList->push_back( object, geometry, groupMaterial, _vector3.z(), &group );
-            }
+            _currentRenderList->push_back( object, geometry, groupMaterial, _vector3.z(), &group,
+                                           _properties.get( groupMaterial, Programs::quantized(*object) ).program );
           }
-        } else {
-          Material::Ptr material = object->material();
-          if ( material->visible )
-            _currentRenderList->push_back( object, geometry, material, _vector3.z(), nullptr);
         }
+      } else {
+        Material::Ptr material = object->material();
+        if ( material->visible )
+          _currentRenderList->push_back( object, geometry, material, _vector3.z(), nullptr,
+                                         _properties.get( material, Programs::quantized(*object) ).program );
       }
     }
   }
-
-  for (Object3D::Ptr child : object->children()) {
-
-    projectObject( child, camera, sortObjects );
-  }
 }
 
 void Renderer_impl::renderObjectImmediate(ImmediateRenderObject &object, Program::Ptr program, Material::Ptr material)
@@ -588,7 +710,7 @@ void Renderer_impl::renderBufferDirect(Camera::Ptr camera,
 
   Program::Ptr program = setProgram( camera, fog, material, object );
 
-  tuple<size_t, GLuint, bool> geometryProgram {geometry->id, program->handle(), material->wireframe};
+  tuple<uint64_t, GLuint, bool> geometryProgram {geometry->id, program->handle(), material->wireframe};
 
   bool updateBuffers = false;
 
@@ -606,6 +728,21 @@ void Renderer_impl::renderBufferDirect(Camera::Ptr camera,
     updateBuffers = true;
   }
 
+  InstancedMesh *instanced = object->typer;
+  unsigned instanceCount = 0;
+  if ( instanced ) {
+
+    //no per-light culling in shadow passes, which would discard the camera pass result each frame
+    instanceCount = instanced->prepare( camera->projectionMatrix() * camera->matrixWorldInverse(), !_shadowMap.rendering() );
+    if ( instanceCount == 0 ) return;
+
+    _attributes.update( *instanced->instanceMatrices(), BufferType::Array );
+    if ( instanced->instanceColors() ) _attributes.update( *instanced->instanceColors(), BufferType::Array );
+
+    //instance attributes are not part of the geometry
+    updateBuffers = true;
+  }
+
   BufferAttributeT<uint32_t>::Ptr index;
   unsigned rangeFactor = 1;
   BufferRenderer *renderer;
@@ -618,8 +755,22 @@ void Renderer_impl::renderBufferDirect(Camera::Ptr camera,
     index = geometry->index();
   }
 
-  if ( updateBuffers )
-    setupVertexAttributes( material, program, geometry );
+  if ( updateBuffers ) {
+
+    //morph target attributes are switched per object
+    bool morphed = mesh && !mesh->morphTargetInfluences().empty();
+
+    if ( vertexArrayObjects && !morphed ) {
+
+      if ( !_vertexArrays.bind( *geometry, *object->geometry(), *program, material->wireframe, instanced ) )
+        setupVertexAttributes( material, program, geometry, 0, instanced );
+    }
+    else {
+
+      _vertexArrays.unbind();
+      setupVertexAttributes( material, program, geometry, 0, instanced );
+    }
+  }
 
   if (index) {
 
@@ -628,7 +779,7 @@ void Renderer_impl::renderBufferDirect(Camera::Ptr camera,
     if ( updateBuffers )
       glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, attribute.handle);
 
-    _indexedBufferRenderer.setIndex(attribute.type, attribute.bytesPerElement);
+    _indexedBufferRenderer.setIndex(attribute.type, attribute.bytesPerElement, attribute.offset);
     renderer = &_indexedBufferRenderer;
   }
   else {
@@ -696,30 +847,44 @@ void Renderer_impl::renderBufferDirect(Camera::Ptr camera,
   }
 
   InstancedBufferGeometry::Ptr ibg = dynamic_pointer_cast<InstancedBufferGeometry>(geometry);
-  if (ibg) {
+  if (instanced) {
+    renderer->renderInstances( drawStart, drawCount, instanceCount );
+  }
+  else if (ibg) {
     if ( ibg->maxInstancedCount() > 0 ) {
       renderer->renderInstances( ibg, drawStart, drawCount );
     }
   }
   else {
-    glValidateProgram(program->handle());
-    GLint status;
-    glGetProgramiv(program->handle(), GL_VALIDATE_STATUS, &status);
-    if(status != GL_TRUE) {
-      char buf[500];
-      int len;
-      glGetProgramInfoLog(program->handle(), 500, &len, buf);
-      qCritical() << buf;
+    if(programValidation == ProgramValidation::EveryDraw
+       || (programValidation == ProgramValidation::Once && !program->validated)) {
+
+      validateProgram(*program);
     }
 
     renderer->render( drawStart, drawCount );
   }
 }
 
+void Renderer_impl::validateProgram(Program &program)
+{
+  glValidateProgram(program.handle());
+  GLint status;
+  glGetProgramiv(program.handle(), GL_VALIDATE_STATUS, &status);
+  if(status != GL_TRUE) {
+    char buf[500];
+    int len;
+    glGetProgramInfoLog(program.handle(), 500, &len, buf);
+    qCritical() << buf;
+  }
+  program.validated = true;
+}
+
 void Renderer_impl::setupVertexAttributes(Material::Ptr material,
                                           Program::Ptr program,
                                           BufferGeometry::Ptr geometry,
-                                          unsigned startIndex)
+                                          unsigned startIndex,
+                                          InstancedMesh *instanced)
 {
   /*if ( geometry && geometry.isInstancedBufferGeometry ) {
     if ( extensions.get( 'ANGLE_instanced_arrays' ) === null ) {
@@ -739,6 +904,31 @@ void Renderer_impl::setupVertexAttributes(Material::Ptr material,
 
     if (programAttribute >= 0) {
 
+      if (name == AttributeName::instanceMatrix || name == AttributeName::instanceColor) {
+        if(instanced) setupInstanceAttribute(name, programAttribute, *instanced);
+        continue;
+      }
+
+      const PackedVertexBuffer::Ptr &packed = geometry->packed();
+      const PackedVertexBuffer::Layout *layout = packed ? packed->layout(name) : nullptr;
+
+      if (layout) {
+
+        if (!_attributes.has(*packed)) continue;
+
+        GLsizei stride = (GLsizei) packed->stride();
+
+        _state.enableAttribute(programAttribute);
+
+        const Buffer &buffer = _attributes.get(*packed);
+
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.handle);
+        glVertexAttribPointer(programAttribute, layout->size, layout->type, (GLboolean) layout->normalized, stride,
+                              (void *) (buffer.offset + startIndex * stride + layout->offset));
+        check_glerror(this);
+        continue;
+      }
+
       const BufferAttribute::Ptr &geometryAttribute = geometry->getAttribute(name);
 
       if (geometryAttribute) {
@@ -780,7 +970,7 @@ void Renderer_impl::setupVertexAttributes(Material::Ptr material,
 
           glBindBuffer(GL_ARRAY_BUFFER, buffer);
           glVertexAttribPointer(programAttribute, size, type, normalized, stride * bytesPerElement,
-                                (void *) ((startIndex * stride + offset) * bytesPerElement));
+                                (void *) (attribute.offset + (startIndex * stride + offset) * bytesPerElement));
           check_glerror(this);
         }
         else {
@@ -801,7 +991,8 @@ void Renderer_impl::setupVertexAttributes(Material::Ptr material,
           //}
 
           glBindBuffer(GL_ARRAY_BUFFER, buffer);
-          glVertexAttribPointer(programAttribute, size, type, normalized, 0, (void *) (startIndex * size * bytesPerElement));
+          glVertexAttribPointer(programAttribute, size, type, normalized, 0,
+                                (void *) (attribute.offset + startIndex * size * bytesPerElement));
           check_glerror(this);
         }
       }
@@ -832,9 +1023,39 @@ void Renderer_impl::setupVertexAttributes(Material::Ptr material,
   _state.disableUnusedAttributes();
 }
 
-void Renderer_impl::releaseMaterialProgramReference(Material &material)
+void Renderer_impl::setupInstanceAttribute(AttributeName name, GLuint programAttribute, InstancedMesh &instanced)
 {
-  auto programInfo = _properties.get( material ).program;
+  if (name == AttributeName::instanceMatrix) {
+
+    const Buffer &attribute = _attributes.get(*instanced.instanceMatrices());
+
+    glBindBuffer(GL_ARRAY_BUFFER, attribute.handle);
+
+    //a mat4 attribute occupies 4 consecutive locations, one per column
+    GLsizei stride = 16 * attribute.bytesPerElement;
+    for (unsigned column = 0; column < 4; column++) {
+
+      _state.enableAttributeAndDivisor(programAttribute + column, 1);
+      glVertexAttribPointer(programAttribute + column, 4, attribute.type, GL_FALSE, stride,
+                            (void *) (attribute.offset + column * 4 * attribute.bytesPerElement));
+    }
+    check_glerror(this);
+  }
+  else if (instanced.instanceColors()) {
+
+    const Buffer &attribute = _attributes.get(*instanced.instanceColors());
+
+    glBindBuffer(GL_ARRAY_BUFFER, attribute.handle);
+
+    _state.enableAttributeAndDivisor(programAttribute, 1);
+    glVertexAttribPointer(programAttribute, 3, attribute.type, GL_FALSE, 0, (void *) attribute.offset);
+    check_glerror(this);
+  }
+}
+
+void Renderer_impl::releaseMaterialProgramReference(MaterialProperties &materialProperties)
+{
+  auto programInfo = materialProperties.program;
 
   if (programInfo) {
     _programs.releaseProgram( programInfo );
@@ -843,7 +1064,8 @@ void Renderer_impl::releaseMaterialProgramReference(Material &material)
 
 void Renderer_impl::initMaterial(Material::Ptr material, Fog::Ptr fog, Object3D::Ptr object)
 {
-  MaterialProperties &materialProperties = _properties.get( *material );
+  unsigned quantized = Programs::quantized(*object);
+  MaterialProperties &materialProperties = _properties.get( *material, quantized );
 
   ProgramParameters::Ptr parameters = _programs.getParameters(*this,
      material, _lights.state, _shadowsArray, fog, _clipping.numPlanes(), _clipping.numIntersection(), object );
@@ -852,15 +1074,18 @@ void Renderer_impl::initMaterial(Material::Ptr material, Fog::Ptr fog, Object3D:
   bool programChange = true;
 
   if (!program) {
-    // new material
-    material->onDispose.connect([this](Material *material) {
-      releaseMaterialProgramReference(*material);
-      _properties.remove(*material);
-    });
+    // new material, or a new vertex format for it
+    if (_properties.variants(*material).size() == 1) {
+      material->onDispose.connect([this](Material *material) {
+        for(auto &variant : _properties.variants(*material))
+          releaseMaterialProgramReference(variant.second);
+        _properties.remove(*material);
+      });
+    }
   }
   else if(*program->parameters != *parameters) {
     // changed glsl or parameters
-    releaseMaterialProgramReference(*material );
+    releaseMaterialProgramReference( materialProperties );
   }
   else if (materialProperties.shaderID != ShaderID::undefined ) {
     // same glsl and uniform list
@@ -931,6 +1156,10 @@ void Renderer_impl::initMaterial(Material::Ptr material, Fog::Ptr fog, Object3D:
   }
 
   materialProperties.fog = fog;
+  materialProperties.instancing = *parameters->instancing;
+  materialProperties.instancingColor = *parameters->instancingColor;
+
+  materialProperties.quantized = quantized;
 
   // store the light setup it was created for
 
@@ -939,26 +1168,7 @@ void Renderer_impl::initMaterial(Material::Ptr material, Fog::Ptr fog, Object3D:
   if ( material->lights ) {
 
     // wire up the material to this renderer's lighting state
-    uniforms.set(UniformName::spotLights, _lights.state.spot);
-
-    if(material->ambientColor)
-      //in case a material carries ambient color (Assimp)
-      uniforms.set(UniformName::ambientLightColor, material->ambientColor);
-    else if(_lights.state.ambient)
-      uniforms.set(UniformName::ambientLightColor, _lights.state.ambient);
-
-    uniforms.set(UniformName::directionalLights, _lights.state.directional);
-    uniforms.set(UniformName::hemisphereLights, _lights.state.hemi);
-    uniforms.set(UniformName::rectAreaLights, _lights.state.rectArea);
-    uniforms.set(UniformName::pointLights, _lights.state.point);
-
-    uniforms.set(UniformName::directionalShadowMap, _lights.state.directionalShadowMap);
-    uniforms.set(UniformName::directionalShadowMatrix, _lights.state.directionalShadowMatrix);
-    uniforms.set(UniformName::spotShadowMap, _lights.state.spotShadowMap);
-    uniforms.set(UniformName::spotShadowMatrix, _lights.state.spotShadowMatrix);
-    uniforms.set(UniformName::pointShadowMap, _lights.state.pointShadowMap);
-    uniforms.set(UniformName::pointShadowMatrix, _lights.state.pointShadowMatrix);
-    // TODO (abelnation): add area lights shadow info to uniforms
+    setLightUniforms(uniforms, *material);
   }
 
   auto progUniforms = materialProperties.program->getUniforms();
@@ -966,6 +1176,34 @@ void Renderer_impl::initMaterial(Material::Ptr material, Fog::Ptr fog, Object3D:
 }
 
 
+void Renderer_impl::setLightUniforms(UniformValues &uniforms, Material &material)
+{
+  if(material.ambientColor)
+    //in case a material carries ambient color (Assimp)
+    uniforms.set(UniformName::ambientLightColor, material.ambientColor);
+  else if(_lights.state.ambient)
+    uniforms.set(UniformName::ambientLightColor, _lights.state.ambient);
+
+  uniforms.set(UniformName::directionalShadowMap, _lights.state.directionalShadowMap);
+  uniforms.set(UniformName::directionalShadowCascades, _lights.state.directionalShadowCascades);
+  uniforms.set(UniformName::spotShadowMap, _lights.state.spotShadowMap);
+  uniforms.set(UniformName::pointShadowMap, _lights.state.pointShadowMap);
+
+  // with uniform blocks, the light arrays and shadow matrices are in the shared buffers
+  if(_uniformBlocks.enabled()) return;
+
+  uniforms.set(UniformName::spotLights, _lights.state.spot);
+  uniforms.set(UniformName::directionalLights, _lights.state.directional);
+  uniforms.set(UniformName::hemisphereLights, _lights.state.hemi);
+  uniforms.set(UniformName::rectAreaLights, _lights.state.rectArea);
+  uniforms.set(UniformName::pointLights, _lights.state.point);
+
+  uniforms.set(UniformName::directionalShadowMatrix, _lights.state.directionalShadowMatrix);
+  uniforms.set(UniformName::spotShadowMatrix, _lights.state.spotShadowMatrix);
+  uniforms.set(UniformName::pointShadowMatrix, _lights.state.pointShadowMatrix);
+  // TODO (abelnation): add area lights shadow info to uniforms
+}
+
 void refreshUniforms(UniformValues &uniforms, Fog &fog)
 {
   uniforms.set(UniformName::fogColor, fog.color());
@@ -1009,7 +1247,7 @@ Program::Ptr Renderer_impl::setProgram(Camera::Ptr camera, Fog::Ptr fog, Materia
 {
   _usedTextureUnits = 0;
 
-  MaterialProperties &materialProperties = _properties.get( material );
+  MaterialProperties &materialProperties = _properties.get( material, Programs::quantized(*object) );
 
   if ( _clippingEnabled ) {
 
@@ -1026,9 +1264,14 @@ Program::Ptr Renderer_impl::setProgram(Camera::Ptr camera, Fog::Ptr fog, Materia
     }
   }
 
-  if (!material->needsUpdate) {
+  if ( material->needsUpdate ) {
 
-    if (!materialProperties.program) {
+    // the variants for other vertex formats are updated when they are drawn next
+    for(auto &variant : _properties.variants(*material)) variant.second.needsUpdate = true;
+
+  } else {
+
+    if (!materialProperties.program || materialProperties.needsUpdate) {
 
       material->needsUpdate = true;
 
@@ -1045,6 +1288,16 @@ Program::Ptr Renderer_impl::setProgram(Camera::Ptr camera, Fog::Ptr fog, Materia
           materialProperties.numIntersection != _clipping.numIntersection() ) ) {
 
       material->needsUpdate = true;
+
+    } else {
+
+      InstancedMesh *instanced = object->typer;
+
+      if ( materialProperties.instancing != (instanced != nullptr) ||
+           materialProperties.instancingColor != (instanced && instanced->hasColors()) ) {
+
+        material->needsUpdate = true;
+      }
     }
   }
 
@@ -1052,6 +1305,7 @@ Program::Ptr Renderer_impl::setProgram(Camera::Ptr camera, Fog::Ptr fog, Materia
 
     initMaterial( material, fog, object );
     material->needsUpdate = false;
+    materialProperties.needsUpdate = false;
   }
 
   bool refreshProgram = false;
@@ -1077,6 +1331,8 @@ Program::Ptr Renderer_impl::setProgram(Camera::Ptr camera, Fog::Ptr fog, Materia
 
   if ( refreshProgram || camera != _currentCamera ) {
 
+    _uniformBlocks.updateFrame(*camera, fog);
+
     prg_uniforms->set(UniformName::projectionMatrix, camera->projectionMatrix());
 
     if (_capabilities.logarithmicDepthBuffer) {
@@ -1190,6 +1446,9 @@ Program::Ptr Renderer_impl::setProgram(Camera::Ptr camera, Fog::Ptr fog, Materia
       // use the current material's .needsUpdate flags to set
       // the GL state when required
 
+      // values which are copied into the material uniforms are brought up to date here
+      if ( refreshLights ) setLightUniforms( mat_uniforms, *material );
+
       markUniformsLightsNeedsUpdate( mat_uniforms, refreshLights );
     }
 
@@ -1277,6 +1536,16 @@ Program::Ptr Renderer_impl::setProgram(Camera::Ptr camera, Fog::Ptr fog, Materia
   prg_uniforms->set(UniformName::normalMatrix, object->normalMatrix );
   prg_uniforms->set(UniformName::modelMatrix, object->matrixWorld() );
 
+  // decoding of quantized vertex attributes
+  if ( materialProperties.quantized ) {
+
+    PackedVertexBuffer *packed = Programs::packedVertices(*object);
+    prg_uniforms->set(UniformName::positionOffset, packed->positionOffset() );
+    prg_uniforms->set(UniformName::positionScale, packed->positionScale() );
+    prg_uniforms->set(UniformName::uvRange, packed->uvRange() );
+    prg_uniforms->set(UniformName::uv2Range, packed->uv2Range() );
+  }
+
   check_glerror(this);
   return program;
 }
@@ -6,11 +6,13 @@
 #define THREEPP_RENDERERIMPL
 
 #include <cstdio>
+#include <deque>
 #include <threepp/renderers/OpenGLRenderer.h>
 #include <threepp/light/Light.h>
 #include <threepp/math/Frustum.h>
 #include <threepp/objects/Sprite.h>
 #include <threepp/objects/LensFlare.h>
+#include <threepp/objects/InstancedMesh.h>
 #include <threepp/camera/ArrayCamera.h>
 #include "RenderTarget.h"
 #include "BufferRenderer.h"
@@ -28,6 +30,9 @@
 #include "MorphTargets.h"
 #include "Programs.h"
 #include "Background.h"
+#include "VertexArrays.h"
+#include "UniformBlocks.h"
+#include "ProgramCache.h"
 
 #include <QOpenGLShaderProgram>
 
@@ -45,6 +50,7 @@ class Renderer_impl : public OpenGLRenderer, public QOpenGLExtraFunctions
   friend class Program;
   friend class RenderTargetExternal;
   friend class DeferredCalls;
+  friend class Uniform;
 
   DeferredCalls *_deferredCalls;
 
@@ -84,10 +90,10 @@ protected:
   // internal state cache
   Renderer::Target::Ptr _currentRenderTarget = nullptr;
   GLuint _currentFramebuffer = UINT_MAX;
-  int _currentMaterialId = -1;
+  uint64_t _currentMaterialId = 0;
 
-  static const std::tuple<size_t, GLuint, bool> no_program;
-  std::tuple<size_t, GLuint, bool> _currentGeometryProgram = no_program;
+  static const std::tuple<uint64_t, GLuint, bool> no_program;
+  std::tuple<uint64_t, GLuint, bool> _currentGeometryProgram = no_program;
 
   Camera::Ptr _currentCamera;
   ArrayCamera::Ptr _currentArrayCamera;
@@ -99,6 +105,9 @@ protected:
   Capabilities::Parameters _parameters;
   Extensions _extensions;
   Capabilities _capabilities;
+  VertexArrays _vertexArrays;
+  UniformBlocks _uniformBlocks;
+  ProgramCache _programCache;
   Properties _properties;
 
   Programs _programs;
@@ -157,6 +166,9 @@ protected:
   RenderLists _renderLists;
   RenderList *_currentRenderList = nullptr;
 
+  // fences for submissions that may still be executing, oldest first
+  std::deque<GLsync> _frameFences;
+
   float getTargetPixelRatio()
   {
     return _currentRenderTarget ? _pixelRatio : 1;
@@ -168,8 +180,19 @@ protected:
 
   void initMaterial(Material::Ptr material, Fog::Ptr fog, Object3D::Ptr object);
 
+  void setLightUniforms(UniformValues &uniforms, Material &material);
+
   void projectObject(Object3D::Ptr object, Camera::Ptr camera, bool sortObjects );
 
+  void projectIndexed(SceneIndex &index, Camera::Ptr camera, bool sortObjects);
+
+  /**
+   * add a single object to the render state
+   *
+   * @param culled true if the object already passed frustum culling
+   */
+  void projectSingle(const Object3D::Ptr &object, bool sortObjects, bool culled);
+
   void doRender(const Scene::Ptr &scene,
                 const Camera::Ptr &camera,
                 const Renderer::Target::Ptr &renderTarget,
@@ -185,18 +208,26 @@ protected:
 
   Program::Ptr setProgram(Camera::Ptr camera, Fog::Ptr fog, Material::Ptr material, Object3D::Ptr object );
 
-  void releaseMaterialProgramReference(Material &material);
+  void releaseMaterialProgramReference(MaterialProperties &materialProperties);
 
   void renderObjectImmediate(ImmediateRenderObject &object, Program::Ptr program, Material::Ptr material);
 
   void renderBufferImmediate(ImmediateRenderObject &object, Program::Ptr program, Material::Ptr material);
 
-  void setupVertexAttributes(Material::Ptr material, Program::Ptr program, BufferGeometry::Ptr geometry, unsigned startIndex=0);
+  void setupVertexAttributes(Material::Ptr material, Program::Ptr program, BufferGeometry::Ptr geometry,
+                             unsigned startIndex=0, InstancedMesh *instanced=nullptr);
+
+  void setupInstanceAttribute(AttributeName name, GLuint programAttribute, InstancedMesh &instanced);
+
+  void validateProgram(Program &program);
+
+  void paceFrame();
 
 public:
   using Ptr = std::shared_ptr<Renderer_impl>;
 
-  Renderer_impl(size_t width, size_t height, float pixelRatio, bool premultipliedAlpha=true);
+  Renderer_impl(size_t width, size_t height, float pixelRatio,
+                const OpenGLRendererOptions &options=OpenGLRendererOptions());
   ~Renderer_impl();
 
   gl::State &state() {return _state;}
@@ -225,6 +256,21 @@ public:
 
   ShadowMap &shadowMap() {return _shadowMap;}
 
+  /**
+   * the current camera's projection or view was changed in place. The camera uniforms are
+   * uploaded again with the next draw
+   */
+  void cameraChanged() {
+    _currentCamera = nullptr;
+    _uniformBlocks.cameraChanged();
+  }
+
+  const UniformBlocks &uniformBlocks() const {return _uniformBlocks;}
+
+  const RenderInfo &renderInfo() const {return _infoRender;}
+
+  const MemoryInfo &memoryInfo() const {return _infoMemory;}
+
   const Renderer::Target::Ptr &currentRenderTarget() {
     return _currentRenderTarget;
   }
@@ -255,6 +301,12 @@ public:
 
   void clear() override;
 
+  void finish() override;
+
+  void compile(const Scene::Ptr &scene, const Camera::Ptr &camera) override;
+
+  const ProgramCacheInfo &programCacheInfo() const override {return _programCache.info();}
+
   Renderer_impl &setSize(size_t width, size_t height, bool setViewport) override;
 
   Renderer_impl &setViewport(size_t x, size_t y, size_t width, size_t height) override;
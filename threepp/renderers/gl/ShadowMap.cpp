@@ -4,10 +4,113 @@
 
 #include "ShadowMap.h"
 #include "Renderer_impl.h"
+#include <limits>
+#include <cmath>
 
 namespace three {
 namespace gl {
 
+namespace {
+
+template <typename Attribute>
+void hashAttribute(size_t &hash, const Attribute &attribute)
+{
+  if(attribute) {
+    hash_combine(hash, attribute->uuid);
+    hash_combine(hash, attribute->version());
+  }
+  else hash_combine(hash, 0);
+}
+
+}
+
+void ShadowMap::Caster::setGeometry(const Object3D &object, const BufferGeometry &geometry)
+{
+  drawOffset = geometry.drawRange().offset;
+  drawCount = geometry.drawRange().count;
+  positionVersion = geometry.position() ? geometry.position()->version() : 0;
+  indexVersion = geometry.index() ? geometry.index()->version() : 0;
+
+  InstancedMesh *mesh = object.typer;
+  instancesVersion = mesh ? mesh->version() : 0;
+
+  size_t hash = 0;
+  hashAttribute(hash, geometry.position());
+  hashAttribute(hash, geometry.index());
+  for(const auto &morph : geometry.morphPositions()) hashAttribute(hash, morph);
+  attributes = hash;
+}
+
+void ShadowMap::Caster::setMaterial(const Object3D &object, const Material &material)
+{
+  this->material = material.id;
+  customDepthMaterial = object.customDepthMaterial ? object.customDepthMaterial->id : 0;
+  customDistanceMaterial = object.customDistanceMaterial ? object.customDistanceMaterial->id : 0;
+
+  side = material.side;
+  skinning = material.skinning;
+  morphTargets = material.morphTargets;
+  wireframe = material.wireframe;
+  wireframeLineWidth = material.wireframeLineWidth;
+  alphaTest = material.alphaTest;
+  clipShadows = material.clipShadows;
+  clipIntersection = material.clipIntersection;
+
+  size_t hash = 0;
+  for(const math::Plane &plane : material.clippingPlanes) {
+    hash_combine(hash, plane.normal().x());
+    hash_combine(hash, plane.normal().y());
+    hash_combine(hash, plane.normal().z());
+    hash_combine(hash, plane.constant());
+  }
+  clippingPlanes = hash;
+}
+
+bool ShadowMap::Caster::operator == (const Caster &other) const
+{
+  return object == other.object && geometry == other.geometry
+         && drawOffset == other.drawOffset && drawCount == other.drawCount
+         && positionVersion == other.positionVersion && indexVersion == other.indexVersion
+         && instancesVersion == other.instancesVersion && attributes == other.attributes
+         && material == other.material && customDepthMaterial == other.customDepthMaterial
+         && customDistanceMaterial == other.customDistanceMaterial
+         && side == other.side && skinning == other.skinning && morphTargets == other.morphTargets
+         && wireframe == other.wireframe && wireframeLineWidth == other.wireframeLineWidth
+         && alphaTest == other.alphaTest && clipShadows == other.clipShadows
+         && clipIntersection == other.clipIntersection && clippingPlanes == other.clippingPlanes
+         && groupStart == other.groupStart && groupCount == other.groupCount
+         && matrixWorld == other.matrixWorld;
+}
+
+bool ShadowMap::update(Face &face, const math::Matrix4 &viewProjection)
+{
+  _casters.clear();
+  bool animated = false;
+
+  for(const Draw &draw : _draws) {
+    Caster caster;
+    caster.object = draw.object->id();
+    caster.geometry = draw.geometry->id;
+    caster.setGeometry(*draw.object, *draw.geometry);
+    caster.setMaterial(*draw.object, *draw.material);
+    caster.groupStart = draw.group ? draw.group->start : 0;
+    caster.groupCount = draw.group ? draw.group->count : 0;
+    caster.matrixWorld = draw.object->matrixWorld();
+    _casters.push_back(caster);
+
+    //bone and morph target animation is not reflected in the versions
+    animated |= draw.object->skinned() || (draw.material->morphTargets && draw.geometry->useMorphing());
+  }
+
+  bool changed = animated || !face.valid || !(face.viewProjection == viewProjection) || face.casters != _casters;
+
+  face.valid = true;
+  face.viewProjection = viewProjection;
+  if(changed) face.casters.swap(_casters);
+
+  return changed;
+}
+
 void ShadowMap::render(std::vector<Light::Ptr> lights, Scene::Ptr scene, Camera::Ptr camera)
 {
   if (!_enabled) return;
@@ -27,6 +130,9 @@ void ShadowMap::render(std::vector<Light::Ptr> lights, Scene::Ptr scene, Camera:
   // render depth map
   unsigned faceCount;
 
+  _frame++;
+  bool incremental = _renderer.incrementalShadows && !_needsUpdate;
+
   for (Light::Ptr light : lights) {
 
     auto shadow = light->shadow();
@@ -40,6 +146,10 @@ void ShadowMap::render(std::vector<Light::Ptr> lights, Scene::Ptr scene, Camera:
     math::Vector2 shadowMapSize = math::min(shadow->mapSize(), maxShadowMapSize);
 
     PointLight *pointLight = light->typer;
+    DirectionalLight *directionalLight = light->typer;
+    DirectionalLightShadow *cascaded =
+       directionalLight && directionalLight->shadow_t()->cascades() > 1 ? directionalLight->shadow_t().get() : nullptr;
+
     if (pointLight) {
 
       float vpWidth = shadowMapSize.x();
@@ -74,6 +184,19 @@ void ShadowMap::render(std::vector<Light::Ptr> lights, Scene::Ptr scene, Camera:
       shadowMapSize.x() *= 4.0;
       shadowMapSize.y() *= 2.0;
     }
+    else if (cascaded) {
+
+      // one tile per cascade, laid out left to right, bottom to top
+      float vpWidth = shadowMapSize.x();
+      float vpHeight = shadowMapSize.y();
+
+      for (unsigned c = 0; c < cascaded->cascades(); c++) {
+        _cube2DViewPorts[c].set(vpWidth * (c % cascaded->columns()), vpHeight * (c / cascaded->columns()), vpWidth, vpHeight);
+      }
+
+      shadowMapSize.x() *= cascaded->columns();
+      shadowMapSize.y() *= cascaded->rows();
+    }
 
     const Camera::Ptr shadowCamera = shadow->camera();
     if (!shadow->map()) {
@@ -111,6 +234,12 @@ void ShadowMap::render(std::vector<Light::Ptr> lights, Scene::Ptr scene, Camera:
       shadowCamera->lookAt(_lookTarget);
       shadowCamera->updateMatrixWorld(true);
 
+      if (cascaded) {
+
+        faceCount = cascaded->cascades();
+        setupCascades(*cascaded, *camera);
+      }
+
       // compute shadow matrix
 
       shadow->matrix() = math::Matrix4(
@@ -124,8 +253,16 @@ void ShadowMap::render(std::vector<Light::Ptr> lights, Scene::Ptr scene, Camera:
       shadow->matrix() *= shadowCamera->matrixWorldInverse();
     }
 
-    _renderer.setRenderTarget(shadow->map());
-    _renderer.clear(true, true, true);
+    // faces are only re-rendered if their casters changed. A new map is cleared entirely
+    Cached &cached = _cache[light->id()];
+    bool complete = !incremental || cached.map != shadow->map().get();
+    if(complete) {
+      cached = Cached();
+      cached.map = shadow->map().get();
+    }
+    cached.frame = _frame;
+
+    bool bound = false;
 
     // render shadow map for each cube face (if omni-directional) or
     // run a single pass if not
@@ -133,28 +270,169 @@ void ShadowMap::render(std::vector<Light::Ptr> lights, Scene::Ptr scene, Camera:
 
       if (pointLight) {
 
-        _lookTarget = shadowCamera->position();
+        _lookTarget = shadowCamera->cposition();
         _lookTarget += _cubeDirections[face];
         shadowCamera->up() = _cubeUps[face];
         shadowCamera->lookAt(_lookTarget);
         shadowCamera->updateMatrixWorld(false);
+      }
+      else if (cascaded) {
 
-        math::Vector4 &vpDimensions = _cube2DViewPorts[face];
-        _renderer.state().viewport(vpDimensions);
+        const math::Vector4 &bounds = _cascadeBounds[face];
+        cascaded->camera_t()->set(bounds.x(), bounds.z(), bounds.w(), bounds.y());
       }
 
       // update camera matrices and frustum
-      _frustum.set(shadowCamera->projectionMatrix() * shadowCamera->matrixWorldInverse());
+      math::Matrix4 viewProjection = shadowCamera->projectionMatrix() * shadowCamera->matrixWorldInverse();
+      _frustum.set(viewProjection);
 
       // set object matrices & frustum culling
-      renderObject(scene, camera, shadowCamera, (bool)pointLight);
+      _draws.clear();
+      if(SceneIndex *index = scene->spatialIndex())
+        renderIndexed(*index, camera, shadowCamera, (bool)pointLight);
+      else
+        renderObject(scene, camera, shadowCamera, (bool)pointLight);
+
+      bool changed = incremental ? update(cached.faces[face], viewProjection) : true;
+      if(!changed && !complete) continue;
+
+      if(!bound) {
+        _renderer.setRenderTarget(shadow->map());
+        if(complete) _renderer.clear(true, true, true);
+        bound = true;
+      }
+
+      if (pointLight || cascaded) {
+
+        //the same camera is used for all faces, with different matrices
+        _renderer.cameraChanged();
+
+        math::Vector4 &vpDimensions = _cube2DViewPorts[face];
+
+        if(!complete) {
+          state.setScissorTest(true);
+          state.scissor(vpDimensions);
+          _renderer.clear(true, true, true);
+          state.setScissorTest(false);
+        }
+        state.viewport(vpDimensions);
+      }
+      else if(!complete) {
+        _renderer.clear(true, true, true);
+      }
+
+      renderDraws(shadowCamera, (bool)pointLight);
       check_glerror(&_renderer);
     }
+
+    // leave the camera at the union, which the shadow matrix was computed for
+    if (cascaded)
+      cascaded->camera_t()->set(_cascadeUnion.x(), _cascadeUnion.z(), _cascadeUnion.w(), _cascadeUnion.y());
+  }
+
+  // forget lights that no longer cast shadows
+  for(auto it = _cache.begin(); it != _cache.end(); ) {
+    if(it->second.frame != _frame) it = _cache.erase(it);
+    else it++;
   }
 
   _needsUpdate = false;
 }
 
+void ShadowMap::setupCascades(DirectionalLightShadow &shadow, const Camera &camera)
+{
+  const Camera::Ptr shadowCamera = shadow.camera();
+  unsigned cascades = shadow.cascades();
+
+  // view frustum corners in view space. Depth varies linearly along the edges, for perspective
+  // and orthographic projections alike
+  math::Matrix4 unproject = camera.projectionMatrix().inverted();
+
+  math::Vector3 nearCorners[4], farCorners[4];
+  for (unsigned i = 0; i < 4; i++) {
+    float x = (i & 1) ? 1.0f : -1.0f, y = (i & 2) ? 1.0f : -1.0f;
+
+    nearCorners[i] = math::Vector3(x, y, -1.0f).apply(unproject);
+    farCorners[i] = math::Vector3(x, y, 1.0f).apply(unproject);
+  }
+  float nearDepth = -nearCorners[0].z(), farDepth = -farCorners[0].z();
+
+  float far = farDepth;
+  if (shadow.cascadeDistance() > nearDepth) far = std::min(far, shadow.cascadeDistance());
+
+  // practical split scheme: blend logarithmic and uniform split distances
+  float splits[DirectionalLightShadow::maxCascades + 1];
+  for (unsigned c = 0; c <= cascades; c++) {
+    float f = (float)c / cascades;
+    float logarithmic = nearDepth * std::pow(far / nearDepth, f);
+    float uniform = nearDepth + (far - nearDepth) * f;
+
+    splits[c] = shadow.cascadeSplitLambda() * logarithmic + (1.0f - shadow.cascadeSplitLambda()) * uniform;
+  }
+
+  // view space to light space
+  math::Matrix4 toLight = shadowCamera->matrixWorldInverse() * camera.matrixWorld();
+
+  float tileSize = shadow.mapSize().x();
+
+  float left = std::numeric_limits<float>::infinity(), bottom = left;
+  float right = -left, top = -left;
+
+  for (unsigned c = 0; c < cascades; c++) {
+
+    math::Vector3 corners[8];
+    math::Vector3 center;
+
+    for (unsigned i = 0; i < 4; i++) {
+      for (unsigned s = 0; s < 2; s++) {
+        float t = (splits[c + s] - nearDepth) / (farDepth - nearDepth);
+
+        math::Vector3 corner = nearCorners[i] + (farCorners[i] - nearCorners[i]) * t;
+        corners[i * 2 + s] = corner.apply(toLight);
+        center += corners[i * 2 + s];
+      }
+    }
+    center /= 8.0f;
+
+    // fit a square around the bounding sphere, which doesn't change size as the camera rotates.
+    // Snapping it to whole texels keeps the shadow edges from shimmering as the camera moves
+    float radius = 0;
+    for (const math::Vector3 &corner : corners) radius = std::max(radius, corner.distanceTo(center));
+    radius = std::ceil(radius * 16.0f) / 16.0f;
+
+    float texel = 2.0f * radius / tileSize;
+    float x = std::floor(center.x() / texel) * texel;
+    float y = std::floor(center.y() / texel) * texel;
+
+    math::Vector4 &bounds = _cascadeBounds[c];
+    bounds.set(x - radius, y - radius, x + radius, y + radius);
+
+    left = std::min(left, bounds.x());
+    bottom = std::min(bottom, bounds.y());
+    right = std::max(right, bounds.z());
+    top = std::max(top, bounds.w());
+  }
+  _cascadeUnion.set(left, bottom, right, top);
+
+  // shadow coordinates are computed for the union. The shader maps them to each cascade's tile
+  float *e = shadow.cascadeMatrix().elements();
+  std::fill(e, e + 16, 0.0f);
+
+  float unionWidth = right - left;
+  float unionHeight = top - bottom;
+
+  for (unsigned c = 0; c < cascades; c++) {
+    const math::Vector4 &bounds = _cascadeBounds[c];
+
+    e[c * 4] = (bounds.x() - left) / unionWidth;
+    e[c * 4 + 1] = (bounds.y() - bottom) / unionHeight;
+    e[c * 4 + 2] = unionWidth / (bounds.z() - bounds.x());
+    e[c * 4 + 3] = unionHeight / (bounds.w() - bounds.y());
+  }
+
+  shadow.camera_t()->set(left, right, top, bottom);
+}
+
 Material::Ptr ShadowMap::getDepthMaterial(Object3D::Ptr object,
                                Material::Ptr material,
                                bool isPointLight,
@@ -179,6 +457,12 @@ Material::Ptr ShadowMap::getDepthMaterial(Object3D::Ptr object,
     if ( useMorphing ) variantIndex |= Flag::Morphing;
     if ( useSkinning ) variantIndex |= Flag::Skinning;
 
+    //instanced objects get their own material, so the programs are not switched back and forth
+    if ( object->is<InstancedMesh>() ) variantIndex |= Flag::Instancing;
+
+    //likewise for geometries with packed vertices, which use decoding programs
+    if ( Programs::packedVertices(*object) ) variantIndex |= Flag::Packed;
+
     result = materialVariants[ variantIndex ];
   }
   else {
@@ -249,45 +533,75 @@ void ShadowMap::renderObject(Object3D::Ptr object, Camera::Ptr camera, Camera::P
 
   if ( visible && object->isShadowRenderable()) {
 
-    if ( object->castShadow && ( ! object->frustumCulled || _frustum.intersectsObject( *object ) ) ) {
+    renderSingle(object, shadowCamera, isPointLight, false);
+  }
+
+  std::vector<Object3D::Ptr> children = object->children();
+
+  for (auto child : object->children()) {
+
+    renderObject( child, camera, shadowCamera, isPointLight);
+  }
+}
+
+void ShadowMap::renderIndexed(SceneIndex &index, Camera::Ptr camera, Camera::Ptr shadowCamera, bool isPointLight)
+{
+  auto render = [&](const Object3D::Ptr &object, bool culled) {
+    if(object->isShadowRenderable() && object->layers().test(camera->layers()) && SceneIndex::visibleInScene(*object))
+      renderSingle(object, shadowCamera, isPointLight, culled);
+  };
+
+  index.cull(_frustum, [&](const Object3D::Ptr &object) {render(object, true);});
+
+  for(const Object3D::Ptr &object : index.unculled()) render(object, false);
+}
+
+void ShadowMap::renderSingle(const Object3D::Ptr &object, Camera::Ptr shadowCamera, bool isPointLight, bool culled)
+{
+  if ( object->castShadow && ( culled || ! object->frustumCulled || _frustum.intersectsObject( *object ) ) ) {
 
-      object->modelViewMatrix.multiply(shadowCamera->matrixWorldInverse(), object->matrixWorld());
-      BufferGeometry::Ptr geometry = _objects.update( object );
+    BufferGeometry::Ptr geometry = _objects.update( object );
 
-      if ( object->materialCount() > 1 ) {
+    if ( object->materialCount() > 1 ) {
 
-        const std::vector<Group> &groups = geometry->groups();
+      const std::vector<Group> &groups = geometry->groups();
 
-        for (const Group &group : groups) {
+      for (const Group &group : groups) {
 
-          Material::Ptr groupMaterial = object->material(group.materialIndex);
+        Material::Ptr groupMaterial = object->material(group.materialIndex);
 
-          if ( groupMaterial && groupMaterial->visible ) {
+        if ( groupMaterial && groupMaterial->visible ) {
 
-            Material::Ptr depthMaterial = getDepthMaterial(object, groupMaterial, isPointLight, _lightPositionWorld,
-                                                 shadowCamera->near(), shadowCamera->far() );
-            _renderer.renderBufferDirect( shadowCamera, nullptr, geometry, depthMaterial, object, &group );
-          }
+          _draws.push_back({object, geometry, groupMaterial, &group});
         }
       }
-      else {
-        Material::Ptr material = object->material();
-        if (material->visible) {
-          Material::Ptr depthMaterial = getDepthMaterial(object, material, isPointLight, _lightPositionWorld,
-                                                         shadowCamera->near(), shadowCamera->far());
+    }
+    else {
+      Material::Ptr material = object->material();
+      if (material->visible) {
 
-          _renderer.renderBufferDirect(shadowCamera, nullptr, geometry, depthMaterial, object, nullptr);
-        }
+        _draws.push_back({object, geometry, material, nullptr});
       }
     }
   }
+}
 
-  std::vector<Object3D::Ptr> children = object->children();
+void ShadowMap::renderDraws(Camera::Ptr shadowCamera, bool isPointLight)
+{
+  _rendering = true;
 
-  for (auto child : object->children()) {
+  for(const Draw &draw : _draws) {
 
-    renderObject( child, camera, shadowCamera, isPointLight);
+    draw.object->modelViewMatrix.multiply(shadowCamera->matrixWorldInverse(), draw.object->matrixWorld());
+
+    Material::Ptr depthMaterial = getDepthMaterial(draw.object, draw.material, isPointLight, _lightPositionWorld,
+                                                   shadowCamera->near(), shadowCamera->far());
+
+    _renderer.renderBufferDirect(shadowCamera, nullptr, draw.geometry, depthMaterial, draw.object, draw.group);
   }
+  _draws.clear();
+
+  _rendering = false;
 }
 
 }
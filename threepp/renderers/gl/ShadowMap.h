@@ -13,6 +13,7 @@
 #include <threepp/material/MeshDepthMaterial.h>
 #include <threepp/material/MeshDistanceMaterial.h>
 #include <threepp/light/Light.h>
+#include <threepp/light/DirectionalLight.h>
 #include <threepp/scene/Scene.h>
 #include <threepp/camera/PerspectiveCamera.h>
 
@@ -32,9 +33,9 @@ class ShadowMap
   math::Vector3 _lookTarget;
   math::Vector3 _lightPositionWorld;
 
-  enum Flag : uint16_t {Morphing = 1, Skinning= 2};
+  enum Flag : uint16_t {Morphing = 1, Skinning= 2, Instancing = 4, Packed = 8};
 
-  uint16_t _NumberOfMaterialVariants = (Flag::Morphing | Flag::Skinning) + 1;
+  uint16_t _NumberOfMaterialVariants = (Flag::Morphing | Flag::Skinning | Flag::Instancing | Flag::Packed) + 1;
 
   std::vector<Material::Ptr> _depthMaterials;
   std::vector<Material::Ptr> _distanceMaterials;
@@ -53,8 +54,88 @@ class ShadowMap
 
   math::Vector4 _cube2DViewPorts[6];
 
+  //light space left, bottom, right, top of each cascade and their union
+  math::Vector4 _cascadeBounds[DirectionalLightShadow::maxCascades];
+  math::Vector4 _cascadeUnion;
+
+  /**
+   * split the camera's view frustum and fit the cascades around the parts. Sets the shadow camera
+   * to the union of the cascades
+   */
+  void setupCascades(DirectionalLightShadow &shadow, const Camera &camera);
+
+  //a caster as drawn into a shadow map face
+  struct Draw
+  {
+    Object3D::Ptr object;
+    BufferGeometry::Ptr geometry;
+    Material::Ptr material;
+    const Group *group;
+  };
+  std::vector<Draw> _draws;
+
+  //the state a draw depended on, compared across frames to detect changes
+  struct Caster
+  {
+    uint64_t object;
+    uint64_t geometry;
+    size_t drawOffset;
+    int drawCount;
+    unsigned positionVersion, indexVersion, instancesVersion;
+    //identities of the position and index attributes, morph attribute identities and versions
+    size_t attributes;
+
+    //material state used by the depth pass
+    uint64_t material, customDepthMaterial, customDistanceMaterial;
+    Side side;
+    bool skinning, morphTargets, wireframe, clipShadows, clipIntersection;
+    float alphaTest;
+    unsigned wireframeLineWidth;
+    size_t clippingPlanes;
+
+    uint32_t groupStart, groupCount;
+    math::Matrix4 matrixWorld;
+
+    //record everything affecting the shape of the caster
+    void setGeometry(const Object3D &object, const BufferGeometry &geometry);
+
+    //record the material state which getDepthMaterial transfers to the depth material
+    void setMaterial(const Object3D &object, const Material &material);
+
+    bool operator == (const Caster &other) const;
+  };
+
+  struct Face
+  {
+    bool valid = false;
+    math::Matrix4 viewProjection;
+    std::vector<Caster> casters;
+  };
+
+  struct Cached
+  {
+    const Renderer::Target *map = nullptr;
+    Face faces[6];
+    unsigned frame = 0;
+  };
+  std::unordered_map<uint64_t, Cached> _cache;
+  std::vector<Caster> _casters;
+  unsigned _frame = 0;
+
+  /**
+   * record the draws collected for a face
+   *
+   * @return true if the face needs to be re-rendered
+   */
+  bool update(Face &face, const math::Matrix4 &viewProjection);
+
+  void renderDraws(Camera::Ptr shadowCamera, bool isPointLight);
+
   bool _enabled = false;
 
+  //shadow casters are being drawn
+  bool _rendering = false;
+
   bool _autoUpdate = true;
   bool _needsUpdate = false;
 
@@ -93,8 +174,27 @@ public:
 
   void renderObject(Object3D::Ptr object, Camera::Ptr camera, Camera::Ptr shadowCamera, bool isPointLight);
 
+  void renderIndexed(SceneIndex &index, Camera::Ptr camera, Camera::Ptr shadowCamera, bool isPointLight);
+
+  void renderSingle(const Object3D::Ptr &object, Camera::Ptr shadowCamera, bool isPointLight, bool culled);
+
+  /**
+   * re-render all shadow maps on the next call to render(), even if autoUpdate is off or
+   * incremental updates detect no change
+   */
+  void setNeedsUpdate() {_needsUpdate = true;}
+
+  bool autoUpdate() const {return _autoUpdate;}
+
+  void setAutoUpdate(bool autoUpdate) {_autoUpdate = autoUpdate;}
+
   bool enabled() const {return _enabled;}
 
+  /**
+   * @return true while shadow casters are drawn
+   */
+  bool rendering() const {return _rendering;}
+
   void setEnabled(bool enabled) {_enabled = enabled;}
 
   ShadowMapType type() const {return _type;}
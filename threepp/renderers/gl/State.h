@@ -393,6 +393,25 @@ public:
     return *this;
   }
 
+  /**
+   * exchange the tracked vertex attribute state with the given one. Used when binding a
+   * vertex array object, which carries its own attribute state
+   */
+  void swapAttributes(std::vector<GLuint> &enabled, std::vector<GLuint> &divisors)
+  {
+    enabledAttributes.swap(enabled);
+    attributeDivisors.swap(divisors);
+  }
+
+  /**
+   * reset the tracked vertex attribute state to that of a new vertex array object
+   */
+  void clearAttributes()
+  {
+    enabledAttributes.assign(newAttributes.size(), 0);
+    attributeDivisors.assign(newAttributes.size(), 0);
+  }
+
   State &disableUnusedAttributes()
   {
     for (size_t i = 0, l = enabledAttributes.size(); i != l; ++i) {
@@ -801,7 +820,8 @@ public:
 
     currentBlending = Blending::None;
 
-    currentFaceDirection = FrontFaceDirection::CW;
+    //the GL front face is left as the last draw set it, so the next setFaceDirection must apply it
+    currentFaceDirection = FrontFaceDirection::Undefined;
     currentCullFace = CullFace::None;
 
     colorBuffer.reset();
@@ -0,0 +1,114 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#include "TextureUploads.h"
+#include "Textures.h"
+#include <cstring>
+#include <threepp/util/ThreadPool.h>
+
+namespace three {
+namespace gl {
+
+using namespace std;
+
+TextureUploads::~TextureUploads()
+{
+  if(_pixelBuffers) _fx->glDeleteBuffers(num_buffers, _buffers);
+}
+
+void TextureUploads::init(bool enable, size_t budget, bool pixelBuffers)
+{
+  _enabled = enable;
+  _budget = budget;
+  _pixelBuffers = enable && pixelBuffers;
+
+  if(_pixelBuffers) _fx->glGenBuffers(num_buffers, _buffers);
+}
+
+void TextureUploads::prepare(const ImageTexture::Ptr &texture, int maxSize, bool powerOfTwo)
+{
+  auto prepared = make_shared<Prepared>();
+  prepared->texture = texture;
+  prepared->version = texture->version();
+
+  _queue.push_back(prepared);
+
+  //QImage is implicitly shared with thread-safe reference counting, so the copy is cheap
+  QImage source = texture->image();
+  bool premultiply = texture->premultiplyAlpha();
+
+  ThreadPool::instance().submit([prepared, source, maxSize, premultiply, powerOfTwo]() {
+
+    QImage image = Textures::clampToMaxSize(source, maxSize, false);
+
+    if(premultiply) image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    if(powerOfTwo) image = Textures::makePowerOfTwo(image);
+
+    prepared->image = image;
+    prepared->done.store(true, memory_order_release);
+  });
+}
+
+void TextureUploads::update(const UploadFunc &upload)
+{
+  size_t bytes = 0;
+
+  for(auto it = _queue.begin(); it != _queue.end() && (bytes == 0 || bytes < _budget); ) {
+    if((*it)->done.load(memory_order_acquire)) {
+      shared_ptr<Prepared> prepared = *it;
+      it = _queue.erase(it);
+
+      ImageTexture::Ptr texture = prepared->texture.lock();
+
+      //outdated if the texture was deleted or updated since
+      if(texture && texture->version() == prepared->version) {
+        upload(texture, prepared->image);
+        bytes += prepared->image.byteCount();
+      }
+    }
+    else it++;
+  }
+}
+
+void TextureUploads::texImage2D(TextureFormat format, TextureType type, const QImage &image)
+{
+  if(!_pixelBuffers) {
+    _fx->glTexImage2D(GL_TEXTURE_2D, 0, (GLint)format, image.width(), image.height(), 0,
+                      (GLenum)format, (GLenum)type, image.bits());
+    return;
+  }
+
+  GLsizeiptr size = image.byteCount();
+
+  _fx->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffers[_nextBuffer]);
+  _nextBuffer = (_nextBuffer + 1) % num_buffers;
+
+  //orphan the previous storage, so we don't wait for a transfer still reading from it
+  _fx->glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+
+  void *mapped = _fx->glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                       GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  if(mapped) {
+    memcpy(mapped, image.bits(), size);
+    _fx->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    _fx->glTexImage2D(GL_TEXTURE_2D, 0, (GLint)format, image.width(), image.height(), 0,
+                      (GLenum)format, (GLenum)type, nullptr);
+    _fx->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  }
+  else {
+    _fx->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    _fx->glTexImage2D(GL_TEXTURE_2D, 0, (GLint)format, image.width(), image.height(), 0,
+                      (GLenum)format, (GLenum)type, image.bits());
+  }
+  check_glerror(_fx);
+}
+
+size_t TextureUploads::pending() const
+{
+  return _queue.size();
+}
+
+}
+}
@@ -0,0 +1,97 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#ifndef THREEPP_TEXTUREUPLOADS_H
+#define THREEPP_TEXTUREUPLOADS_H
+
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <QImage>
+#include <QOpenGLExtraFunctions>
+#include <threepp/textures/ImageTexture.h>
+#include <threepp/Constants.h>
+
+namespace three {
+namespace gl {
+
+/**
+ * prepares image textures on worker threads and uploads the results incrementally.
+ *
+ * Clamping to the maximum size, alpha premultiplication and power of two resizing run on the
+ * process-wide ThreadPool. Finished images are uploaded at the beginning of a frame, up to
+ * a byte budget per frame. Where buffer mapping is available (GL 3.0, GL ES 3.0), the pixels
+ * are streamed through a ring of pixel unpack buffers.
+ */
+class TextureUploads
+{
+public:
+  struct Prepared
+  {
+    std::weak_ptr<ImageTexture> texture;
+    unsigned version;
+    QImage image;
+
+    //set by the worker once image is prepared
+    std::atomic<bool> done {false};
+  };
+
+  using UploadFunc = std::function<void(const ImageTexture::Ptr &texture, const QImage &image)>;
+
+private:
+  static const unsigned num_buffers = 3;
+
+  QOpenGLExtraFunctions * const _fx;
+
+  bool _enabled = false;
+  size_t _budget = 0;
+
+  bool _pixelBuffers = false;
+  GLuint _buffers[num_buffers] = {0, 0, 0};
+  unsigned _nextBuffer = 0;
+
+  //accessed on the render thread only
+  std::deque<std::shared_ptr<Prepared>> _queue;
+
+public:
+  explicit TextureUploads(QOpenGLExtraFunctions *fx) : _fx(fx) {}
+
+  ~TextureUploads();
+
+  /**
+   * @param enable false to upload textures synchronously
+   * @param budget the number of bytes uploaded per frame. At least one texture is uploaded
+   * @param pixelBuffers whether pixel unpack buffers and glMapBufferRange are available
+   */
+  void init(bool enable, size_t budget, bool pixelBuffers);
+
+  bool enabled() const {return _enabled;}
+
+  /**
+   * prepare the texture's image in the background
+   */
+  void prepare(const ImageTexture::Ptr &texture, int maxSize, bool powerOfTwo);
+
+  /**
+   * hand finished images to upload(), within the frame budget. The texture is bound by upload(),
+   * which then calls texImage2D()
+   */
+  void update(const UploadFunc &upload);
+
+  /**
+   * specify the bound 2D texture's level 0 from image
+   */
+  void texImage2D(TextureFormat format, TextureType type, const QImage &image);
+
+  /**
+   * @return the number of textures being prepared or waiting for upload
+   */
+  size_t pending() const;
+};
+
+}
+}
+
+#endif //THREEPP_TEXTUREUPLOADS_H
@@ -250,6 +250,8 @@ void Textures::setTextureParameters(TextureTarget textureTarget, Texture &textur
 
 void Textures::uploadTexture(GlProperties &textureProperties, Texture::Ptr texture, unsigned slot )
 {
+  bool allocated = textureProperties.webglInit;
+
   if (!textureProperties.webglInit) {
 
     textureProperties.webglInit = true;
@@ -368,6 +370,23 @@ void Textures::uploadTexture(GlProperties &textureProperties, Texture::Ptr textu
     }
   }
   else if(ImageTexture *itex = texture->typer) {
+
+    if(_uploads.enabled() && itex->mipmaps().empty()) {
+
+      // prepare and upload in the background. Until then, the previous image remains, or a
+      // placeholder is shown
+      if(!allocated) {
+        static const unsigned char placeholder[4] = {255, 255, 255, 255};
+        _state.texImage2D(TextureTarget::twoD, 0, TextureFormat::RGBA, 1, 1, TextureFormat::RGBA,
+                          TextureType::UnsignedByte, placeholder);
+      }
+      _uploads.prepare(std::static_pointer_cast<ImageTexture>(texture), _capabilities.maxTextureSize,
+                       !(itex->needsPowerOfTwo() && itex->isPowerOfTwo()));
+
+      textureProperties.version = texture->version();
+      return;
+    }
+
     // regular Texture (image, video, canvas)
     QImage image = clampToMaxSize( itex->image(), _capabilities.maxTextureSize, false);
 
@@ -407,6 +426,33 @@ void Textures::uploadTexture(GlProperties &textureProperties, Texture::Ptr textu
   texture->onUpdate.emitSignal(*texture);
 }
 
+void Textures::uploadPrepared(const ImageTexture::Ptr &texture, const QImage &image)
+{
+  // deallocated meanwhile
+  if(!_properties.has(*texture)) return;
+
+  auto &textureProperties = _properties.get(texture);
+
+  _state.activeTexture( GL_TEXTURE0 );
+  _state.bindTexture( TextureTarget::twoD, textureProperties.texture);
+
+  _fn->glPixelStorei(GL_UNPACK_ALIGNMENT, texture->unpackAlignment() );
+
+  //the image was premultiplied while preparing. Blending is set up per material, not here
+  _uploads.texImage2D(texture->format(), texture->type(), image);
+
+  if ( needsGenerateMipmaps(*texture) ) _fn->glGenerateMipmap(GL_TEXTURE_2D );
+
+  texture->onUpdate.emitSignal(*texture);
+}
+
+void Textures::updateUploads()
+{
+  _uploads.update([this](const ImageTexture::Ptr &texture, const QImage &image) {
+    uploadPrepared(texture, image);
+  });
+}
+
 // Render targets
 
 // Setup storage for target texture and bind it to correct framebuffer
@@ -5,7 +5,7 @@
 #ifndef THREEPP_TEXTURES_H
 #define THREEPP_TEXTURES_H
 
-#include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 #include <QImage>
 #include <threepp/math/Math.h>
 #include "RenderTarget.h"
@@ -14,6 +14,7 @@
 #include "Properties.h"
 #include "Capabilities.h"
 #include "Helpers.h"
+#include "TextureUploads.h"
 
 namespace three {
 namespace gl {
@@ -29,9 +30,12 @@ class Textures
 
   GLuint _defaultFBO = 0;
 
+  TextureUploads _uploads;
+
   void setTextureCubeDynamic( Texture::Ptr texture, unsigned slot );
   void setTextureParameters(TextureTarget textureTarget, Texture &texture);
   void uploadTexture(GlProperties &textureProperties, Texture::Ptr texture, unsigned slot );
+  void uploadPrepared(const ImageTexture::Ptr &texture, const QImage &image);
   void setupFrameBufferTexture(GLuint framebuffer, const Renderer::Target &renderTarget, GLenum attachment, TextureTarget textureTarget);
   void setupRenderBufferStorage(GLuint renderbuffer, const RenderTarget &renderTarget );
   void setupDepthTexture(GLuint framebuffer, RenderTargetInternal &renderTarget);
@@ -39,13 +43,13 @@ class Textures
   void setupDepthRenderbuffer(RenderTargetCube &renderTarget);
 
 public:
-  Textures(QOpenGLFunctions * fn, Extensions &extensions, State &state, Properties &properties,
+  Textures(QOpenGLExtraFunctions * fn, Extensions &extensions, State &state, Properties &properties,
      Capabilities &capabilities, MemoryInfo &infoMemory)
   : _fn(fn), _extensions(extensions), _state(state), _properties(properties), _capabilities(capabilities),
-    _infoMemory(infoMemory)
+    _infoMemory(infoMemory), _uploads(fn)
   {}
 
-  QImage clampToMaxSize(const QImage &image, int maxSize, bool flipY )
+  static QImage clampToMaxSize(const QImage &image, int maxSize, bool flipY )
   {
     QImage img = flipY ? image.mirrored() : image;
 
@@ -55,7 +59,7 @@ public:
     return img;
   }
 
-  QImage makePowerOfTwo(const QImage &image)
+  static QImage makePowerOfTwo(const QImage &image)
   {
     int width = math::nearestPowerOfTwo(image.width() );
     int height = math::nearestPowerOfTwo(image.height());
@@ -83,6 +87,13 @@ public:
   void onRenderTargetDispose(RenderTargetCube &renderTarget);
   void onTextureDispose(Texture &texture);
 
+  TextureUploads &uploads() {return _uploads;}
+
+  /**
+   * upload textures prepared in the background. Called at the beginning of a frame
+   */
+  void updateUploads();
+
   void setDefaultFramebuffer(GLuint fbo) {
     _defaultFBO = fbo;
   }
@@ -0,0 +1,207 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#include "UniformBlocks.h"
+
+namespace three {
+namespace gl {
+
+namespace {
+
+//std140 writers. vec3 and vec4 align to 16 bytes, vec2 to 8, scalars to 4
+
+void align(std::vector<float> &data, size_t floats)
+{
+  while(data.size() % floats) data.push_back(0);
+}
+
+void put(std::vector<float> &data, float value)
+{
+  data.push_back(value);
+}
+
+void put(std::vector<float> &data, int value)
+{
+  union {int i; float f;} u;
+  u.i = value;
+  data.push_back(u.f);
+}
+
+void put(std::vector<float> &data, const math::Vector2 &v)
+{
+  align(data, 2);
+  data.insert(data.end(), v.elements(), v.elements() + 2);
+}
+
+void put(std::vector<float> &data, const math::Vector3 &v)
+{
+  align(data, 4);
+  data.insert(data.end(), v.elements(), v.elements() + 3);
+}
+
+void put(std::vector<float> &data, const Color &c)
+{
+  align(data, 4);
+  data.insert(data.end(), c.elements, c.elements + 3);
+}
+
+void put(std::vector<float> &data, const math::Matrix4 &m)
+{
+  align(data, 4);
+  data.insert(data.end(), m.elements(), m.elements() + 16);
+}
+
+}
+
+UniformBlocks::~UniformBlocks()
+{
+  if(_enabled) _fx->glDeleteBuffers(3, _buffers);
+}
+
+void UniformBlocks::init(bool enable)
+{
+  _enabled = enable;
+  if(_enabled) _fx->glGenBuffers(3, _buffers);
+}
+
+void UniformBlocks::bind()
+{
+  if(!_enabled) return;
+
+  for(GLuint binding=FrameBlock; binding <= ShadowsBlock; binding++)
+    _fx->glBindBufferBase(GL_UNIFORM_BUFFER, binding, _buffers[binding]);
+
+  _camera = nullptr;
+  _fog = nullptr;
+}
+
+void UniformBlocks::write(Binding binding)
+{
+  //structs and arrays are padded to 16 bytes, and so is the buffer. Empty blocks are never
+  //declared, but keep the buffer non-empty anyway
+  align(_data, 4);
+  if(_data.empty()) _data.resize(4, 0);
+
+  if(_data == _written[binding]) return;
+
+  _fx->glBindBuffer(GL_UNIFORM_BUFFER, _buffers[binding]);
+  _fx->glBufferData(GL_UNIFORM_BUFFER, _data.size() * sizeof(float), _data.data(), GL_DYNAMIC_DRAW);
+  _fx->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+  _written[binding] = _data;
+}
+
+void UniformBlocks::updateFrame(const Camera &camera, const Fog::Ptr &fog)
+{
+  if(!_enabled || (&camera == _camera && fog.get() == _fog)) return;
+
+  _camera = &camera;
+  _fog = fog.get();
+
+  _data.clear();
+  put(_data, camera.projectionMatrix());
+  put(_data, camera.matrixWorldInverse());
+  put(_data, math::Vector3::fromMatrixPosition(camera.matrixWorld()));
+
+  float density = 0, near = 0, far = 0;
+  if(const FogExp2 *f = dynamic_cast<const FogExp2 *>(_fog)) {
+    density = f->density();
+  }
+  else if(const DefaultFog *f = dynamic_cast<const DefaultFog *>(_fog)) {
+    near = f->near();
+    far = f->far();
+  }
+  put(_data, density);
+  put(_data, _fog ? _fog->color() : Color(0, 0, 0));
+  put(_data, near);
+  put(_data, far);
+
+  write(FrameBlock);
+}
+
+void UniformBlocks::updateLights(const Lights::State &state)
+{
+  if(!_enabled) return;
+
+  _data.clear();
+
+  for(const auto &light : state.directional) {
+    put(_data, light->direction);
+    put(_data, light->color);
+    put(_data, (int)light->shadow);
+    put(_data, light->shadowBias);
+    put(_data, light->shadowRadius);
+    put(_data, light->shadowMapSize);
+    align(_data, 4);
+  }
+  for(const auto &light : state.point) {
+    put(_data, light->position);
+    put(_data, light->color);
+    put(_data, light->distance);
+    put(_data, light->decay);
+    put(_data, (int)light->shadow);
+    put(_data, light->shadowBias);
+    put(_data, light->shadowRadius);
+    put(_data, light->shadowMapSize);
+    put(_data, light->shadowCameraNear);
+    put(_data, light->shadowCameraFar);
+    align(_data, 4);
+  }
+  for(const auto &light : state.spot) {
+    put(_data, light->position);
+    put(_data, light->direction);
+    put(_data, light->color);
+    put(_data, light->distance);
+    put(_data, light->decay);
+    put(_data, light->coneCos);
+    put(_data, light->penumbraCos);
+    put(_data, (int)light->shadow);
+    put(_data, light->shadowBias);
+    put(_data, light->shadowRadius);
+    put(_data, light->shadowMapSize);
+    align(_data, 4);
+  }
+  for(const auto &light : state.rectArea) {
+    put(_data, light->color);
+    put(_data, light->position);
+    put(_data, light->halfWidth);
+    put(_data, light->halfHeight);
+    align(_data, 4);
+  }
+  for(const auto &light : state.hemi) {
+    put(_data, light->direction);
+    put(_data, light->skyColor);
+    put(_data, light->groundColor);
+    align(_data, 4);
+  }
+  write(LightsBlock);
+
+  //the shader declares one shadow matrix per light. Directional lights only have one if
+  //they have a shadow map
+  _data.clear();
+
+  for(size_t i=0; i < state.directional.size(); i++) {
+    if(i < state.directionalShadowMatrix.size())
+      put(_data, state.directionalShadowMatrix[i]);
+    else
+      _data.resize(_data.size() + 16, 0);
+  }
+  for(const auto &matrix : state.spotShadowMatrix) put(_data, matrix);
+  for(const auto &matrix : state.pointShadowMatrix) put(_data, matrix);
+
+  write(ShadowsBlock);
+}
+
+void UniformBlocks::bindProgram(QOpenGLExtraFunctions *fx, GLuint program)
+{
+  static const char * const names[] = {"Frame", "Lights", "Shadows"};
+
+  for(GLuint binding=FrameBlock; binding <= ShadowsBlock; binding++) {
+    GLuint index = fx->glGetUniformBlockIndex(program, names[binding]);
+    if(index != GL_INVALID_INDEX) fx->glUniformBlockBinding(program, index, binding);
+  }
+}
+
+}
+}
@@ -0,0 +1,94 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#ifndef THREEPP_UNIFORMBLOCKS_H
+#define THREEPP_UNIFORMBLOCKS_H
+
+#include <vector>
+#include <QOpenGLExtraFunctions>
+#include <threepp/camera/Camera.h>
+#include <threepp/scene/Fog.h>
+#include "Lights.h"
+
+namespace three {
+namespace gl {
+
+/**
+ * uniform buffer objects shared by all programs. The camera, fog and light data are written
+ * once per change instead of being uploaded into each program separately.
+ *
+ * The blocks are declared with std140 layout (see Program.cpp, lights_pars.glsl and
+ * shadowmap_pars_vertex.glsl) and bound to fixed binding points:
+ *
+ * - Frame: camera matrices, camera position and fog parameters. Rewritten whenever the camera
+ *   changes, since the shadow passes render with the shadow cameras
+ * - Lights: the light arrays of the current light setup
+ * - Shadows: the shadow matrices of the current light setup
+ */
+class UniformBlocks
+{
+public:
+  enum Binding : GLuint {FrameBlock=0, LightsBlock=1, ShadowsBlock=2};
+
+private:
+  QOpenGLExtraFunctions * const _fx;
+
+  bool _enabled = false;
+
+  GLuint _buffers[3] = {0, 0, 0};
+
+  //the last data written to each buffer
+  std::vector<float> _written[3];
+
+  std::vector<float> _data;
+
+  const Camera *_camera = nullptr;
+  const Fog *_fog = nullptr;
+
+  void write(Binding binding);
+
+public:
+  explicit UniformBlocks(QOpenGLExtraFunctions *fx) : _fx(fx) {}
+
+  ~UniformBlocks();
+
+  /**
+   * create the buffers. Must be called with a current context
+   *
+   * @param enable false if uniform buffers are not to be used
+   */
+  void init(bool enable);
+
+  bool enabled() const {return _enabled;}
+
+  /**
+   * bind the buffers to their binding points and forget the last camera
+   */
+  void bind();
+
+  /**
+   * forget the last camera. Needed when a camera's matrices were changed in place
+   */
+  void cameraChanged() {_camera = nullptr;}
+
+  /**
+   * write the frame block, unless it already holds the data for this camera
+   */
+  void updateFrame(const Camera &camera, const Fog::Ptr &fog);
+
+  /**
+   * write the lights and shadows blocks
+   */
+  void updateLights(const Lights::State &state);
+
+  /**
+   * connect the program's uniform blocks to the binding points
+   */
+  static void bindProgram(QOpenGLExtraFunctions *fx, GLuint program);
+};
+
+}
+}
+
+#endif //THREEPP_UNIFORMBLOCKS_H
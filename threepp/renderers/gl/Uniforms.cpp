@@ -6,6 +6,7 @@
 #include "shader/UniformsLib.h"
 #include "Renderer_impl.h"
 #include <regex>
+#include <cstring>
 
 namespace three {
 namespace gl {
@@ -17,8 +18,17 @@ Uniforms::Uniforms(Renderer_impl &renderer, GLuint program) : _renderer(renderer
   GLint numUniforms;
   renderer.glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &numUniforms);
 
+  //members of uniform blocks are backed by buffers, not set individually
+  std::vector<GLint> blockIndices(numUniforms, -1);
+  if(renderer.uniformBlocks().enabled() && numUniforms > 0) {
+    std::vector<GLuint> indices(numUniforms);
+    for (unsigned i = 0; i < numUniforms; ++i) indices[i] = i;
+
+    renderer.glGetActiveUniformsiv(program, numUniforms, indices.data(), GL_UNIFORM_BLOCK_INDEX, blockIndices.data());
+  }
+
   for (unsigned i = 0; i < numUniforms; ++i) {
-    parseUniform(program, i, this);
+    if(blockIndices[i] == -1) parseUniform(program, i, this);
   }
 }
 
@@ -139,6 +149,7 @@ UniformName get(string name, bool isIndex)
      MATCH_NAME(hemisphereLights),
      MATCH_NAME(directionalShadowMap),
      MATCH_NAME(directionalShadowMatrix),
+     MATCH_NAME(directionalShadowCascades),
      MATCH_NAME(spotShadowMap),
      MATCH_NAME(spotShadowMatrix),
      MATCH_NAME(pointShadowMap),
@@ -151,7 +162,11 @@ UniformName get(string name, bool isIndex)
      MATCH_NAME(groundColor),
      MATCH_NAME(coneCos),
      MATCH_NAME(penumbraCos),
-     MATCH_NAME(decay)
+     MATCH_NAME(decay),
+     MATCH_NAME(positionOffset),
+     MATCH_NAME(positionScale),
+     MATCH_NAME(uvRange),
+     MATCH_NAME(uv2Range)
   };
   if (isIndex) {
     unsigned index = atoi(name.c_str());
@@ -212,12 +227,31 @@ void Uniforms::parseUniform(GLuint program, unsigned index, UniformContainer *co
   }
 }
 
+bool Uniform::changed(const void *data, size_t size)
+{
+  vector<uint8_t> &shadow = *_shadow;
+
+  if(shadow.size() == size && memcmp(shadow.data(), data, size) == 0) {
+    _renderer._infoRender.uniformsSkipped++;
+    return false;
+  }
+  shadow.resize(size);
+  memcpy(shadow.data(), data, size);
+
+  _renderer._infoRender.uniformCalls++;
+  return true;
+}
+
 void Uniform::setValue(GLfloat v) {
+  if(!changed(&v, sizeof(v))) return;
+
   _renderer.glUniform1f( _addr, v );
   check_glerror(&_renderer);
 }
 
 void Uniform::setValue(GLint v) {
+  if(!changed(&v, sizeof(v))) return;
+
   switch(_type) {
     case UniformType::Float:
       _renderer.glUniform1f( _addr, (float)v );
@@ -230,6 +264,8 @@ void Uniform::setValue(GLint v) {
 }
 
 void Uniform::setValue(GLuint v) {
+  if(!changed(&v, sizeof(v))) return;
+
   switch(_type) {
     case UniformType::Float:
       _renderer.glUniform1f( _addr, (float)v );
@@ -242,48 +278,67 @@ void Uniform::setValue(GLuint v) {
 }
 
 void Uniform::setValue(const three::Color &c) {
+  GLfloat rgb[] = {c.r, c.g, c.b};
+  if(!changed(rgb, sizeof(rgb))) return;
+
   _renderer.glUniform3f(_addr, c.r, c.g, c.b);
   check_glerror(&_renderer);
 }
 
 void Uniform::setValue(const math::Vector2 &v) {
+  if(!changed(v.elements(), 2 * sizeof(GLfloat))) return;
+
   _renderer.glUniform2fv(_addr, 1, v.elements());
   check_glerror(&_renderer);
 }
 
 void Uniform::setValue(const math::Vector3 &v) {
+  if(!changed(v.elements(), 3 * sizeof(GLfloat))) return;
+
   _renderer.glUniform3fv(_addr, 1, v.elements());
   check_glerror(&_renderer);
 }
 
 void Uniform::setValue(const math::Vector4 &v) {
+  if(!changed(v.elements(), 4 * sizeof(GLfloat))) return;
+
   _renderer.glUniform4fv(_addr, 1, v.elements());
   check_glerror(&_renderer);
 }
 
 void Uniform::setValue(const math::Matrix3 &v) {
+  if(!changed(v.elements(), 9 * sizeof(GLfloat))) return;
+
   _renderer.glUniformMatrix3fv( _addr, 1, GL_FALSE, v.elements());
   check_glerror(&_renderer);
 }
 
 void Uniform::setValue(const math::Matrix4 &v) {
+  if(!changed(v.elements(), 16 * sizeof(GLfloat))) return;
+
   _renderer.glUniformMatrix4fv( _addr, 1, GL_FALSE, v.elements());
   check_glerror(&_renderer);
 }
 
 void Uniform::setValue(const GLint * array, size_t size) {
+  if(!changed(array, 2 * size * sizeof(GLint))) return;
+
   _renderer.glUniform2iv(_addr, size, array);
   check_glerror(&_renderer);
 }
 
 void Uniform::setValue(const std::vector<math::Matrix4> &matrices)
 {
+  if(!changed(matrices.data(), matrices.size() * sizeof(math::Matrix4))) return;
+
   _renderer.glUniformMatrix4fv( _addr, matrices.size(), GL_FALSE, reinterpret_cast<const GLfloat *>(matrices.data()));
   check_glerror(&_renderer);
 }
 
 void Uniform::setValue(const std::vector<float> &vector)
 {
+  if(!changed(vector.data(), vector.size() * sizeof(float))) return;
+
   _renderer.glUniform1fv(_addr, vector.size(), vector.data());
   check_glerror(&_renderer);
 }
@@ -292,7 +347,8 @@ void Uniform::setValue(const std::vector<Texture::Ptr> &textures)
 {
   vector<GLint> units = _renderer.allocTextureUnits(textures.size());
 
-  _renderer.glUniform1iv(_addr, textures.size(), units.data());
+  if(changed(units.data(), units.size() * sizeof(GLint)))
+    _renderer.glUniform1iv(_addr, textures.size(), units.data());
 
   for (size_t i = 0; i < textures.size(); ++ i ) {
 
@@ -303,16 +359,16 @@ void Uniform::setValue(const std::vector<Texture::Ptr> &textures)
 
 void Uniform::setValue(const Texture::Ptr &texture)
 {
-  unsigned unit = _renderer.allocTextureUnit();
-  _renderer.glUniform1i( _addr, unit );
+  GLint unit = _renderer.allocTextureUnit();
+  if(changed(&unit, sizeof(unit))) _renderer.glUniform1i( _addr, unit );
   _renderer.setTexture2D(texture, unit );
   check_glerror(&_renderer);
 }
 
 void Uniform::setValue(const CubeTexture::Ptr &texture)
 {
-  unsigned unit = _renderer.allocTextureUnit();
-  _renderer.glUniform1i( _addr, unit );
+  GLint unit = _renderer.allocTextureUnit();
+  if(changed(&unit, sizeof(unit))) _renderer.glUniform1i( _addr, unit );
   _renderer.setTextureCube(texture, unit );
   check_glerror(&_renderer);
 }
@@ -137,6 +137,7 @@ enum class UniformName : unsigned
   hemisphereLights,
   directionalShadowMap,
   directionalShadowMatrix,
+  directionalShadowCascades,
   spotShadowMap,
   spotShadowMatrix,
   pointShadowMap,
@@ -147,7 +148,11 @@ enum class UniformName : unsigned
   halfWidth,
   coneCos,
   penumbraCos,
-  decay
+  decay,
+  positionOffset,
+  positionScale,
+  uvRange,
+  uv2Range
 };
 
 namespace uniformname {
@@ -179,8 +184,20 @@ protected:
   const UniformType _type;
   Renderer_impl &_renderer;
 
-  Uniform(Renderer_impl &renderer, UniformName id, UniformType type, const GLint addr)
-     : _id(id), _addr(addr), _type(type), _renderer(renderer) {}
+  //the value last uploaded to the location. Shared with clones, which use the same location
+  using Shadow = std::shared_ptr<std::vector<uint8_t>>;
+  Shadow _shadow;
+
+  Uniform(Renderer_impl &renderer, UniformName id, UniformType type, const GLint addr, const Shadow &shadow=nullptr)
+     : _id(id), _addr(addr), _type(type), _renderer(renderer),
+       _shadow(shadow ? shadow : std::make_shared<std::vector<uint8_t>>()) {}
+
+  /**
+   * record a value about to be uploaded
+   *
+   * @return false if the location already holds the value, so the upload can be skipped
+   */
+  bool changed(const void *data, size_t size);
 
 public:
   using Ptr = std::shared_ptr<Uniform>;
@@ -189,7 +206,7 @@ public:
   }
 
   virtual Ptr clone(UniformName id) {
-    return Ptr(new Uniform(_renderer, id, _type, _addr));
+    return Ptr(new Uniform(_renderer, id, _type, _addr, _shadow));
   }
 
   virtual ~Uniform() {}
@@ -235,8 +252,8 @@ class ArrayUniform : public Uniform
   const GLint _index;
 
 protected:
-  ArrayUniform(Renderer_impl &renderer, UniformName id, UniformType type, const GLint addr)
-  : Uniform(renderer, id, type, addr), _index(0) {}
+  ArrayUniform(Renderer_impl &renderer, UniformName id, UniformType type, const GLint addr, const Shadow &shadow=nullptr)
+  : Uniform(renderer, id, type, addr, shadow), _index(0) {}
 
 public:
   using Ptr = std::shared_ptr<ArrayUniform>;
@@ -245,7 +262,7 @@ public:
   }
 
   Uniform::Ptr clone(UniformName id) override {
-    return Ptr(new ArrayUniform(_renderer, id, _type, _addr));
+    return Ptr(new ArrayUniform(_renderer, id, _type, _addr, _shadow));
   }
 };
 
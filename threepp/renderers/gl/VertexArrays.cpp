@@ -0,0 +1,146 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#include "VertexArrays.h"
+#include "Program.h"
+#include <threepp/objects/InstancedMesh.h>
+
+namespace three {
+namespace gl {
+
+void VertexArrays::collect(BufferGeometry &geometry, Program &program, InstancedMesh *instanced)
+{
+  _used.clear();
+
+  for (const auto &att : program.getAttributes()) {
+
+    switch(att.first) {
+      case AttributeName::instanceMatrix:
+        _used.push_back(instanced ? instanced->instanceMatrices().get() : nullptr);
+        break;
+      case AttributeName::instanceColor:
+        _used.push_back(instanced ? instanced->instanceColors().get() : nullptr);
+        break;
+      default: {
+        const PackedVertexBuffer::Ptr &packed = geometry.packed();
+        if(packed && packed->layout(att.first))
+          _used.push_back(packed.get());
+        else
+          _used.push_back(geometry.getAttribute(att.first).get());
+        break;
+      }
+    }
+  }
+}
+
+void VertexArrays::bind(GLuint handle)
+{
+  if(_current == 0 && handle != 0) {
+    _state.swapAttributes(_defaultEnabled, _defaultDivisors);
+    _state.clearAttributes();
+  }
+  else if(_current != 0 && handle == 0) {
+    _state.swapAttributes(_defaultEnabled, _defaultDivisors);
+  }
+
+  _fx->glBindVertexArray(handle);
+  _current = handle;
+}
+
+bool VertexArrays::bind(BufferGeometry &geometry, Geometry &source, Program &program, bool wireframe, InstancedMesh *instanced)
+{
+  uint64_t objectId = instanced ? instanced->id() : 0;
+
+  collect(geometry, program, instanced);
+
+  auto found = _bindings.find(geometry.id);
+  if(found == _bindings.end()) {
+    found = _bindings.emplace(geometry.id, std::vector<Binding>()).first;
+
+    uint64_t geometryId = geometry.id;
+    source.onDispose.connect([this, geometryId](Geometry *) {
+      releaseGeometry(geometryId);
+    });
+  }
+
+  Binding *binding = nullptr;
+  for(auto &b : found->second) {
+    if(b.programId == program.id && b.wireframe == wireframe && b.objectId == objectId) {
+      binding = &b;
+      break;
+    }
+  }
+
+  if(binding) {
+    if(binding->attributes == _used && binding->deletions == _attributes.deletions()) {
+
+      if(binding->handle != _current) bind(binding->handle);
+      return true;
+    }
+    if(binding->handle == _current) bind(0);
+    _fx->glDeleteVertexArrays(1, &binding->handle);
+  }
+  else {
+    found->second.emplace_back();
+    binding = &found->second.back();
+    binding->programId = program.id;
+    binding->wireframe = wireframe;
+    binding->objectId = objectId;
+  }
+
+  //attributes not uploaded yet are left out by the setup. Record them as missing, so the
+  //vertex array is set up again once they are
+  for(auto &attribute : _used) {
+    if(attribute && !_attributes.has(*attribute)) attribute = nullptr;
+  }
+  binding->attributes = _used;
+  binding->deletions = _attributes.deletions();
+
+  _fx->glGenVertexArrays(1, &binding->handle);
+  bind(binding->handle);
+
+  //the tracked attribute state may still be that of the previously bound vertex array, which
+  //would make the setup skip enabling attributes in the new one
+  _state.clearAttributes();
+
+  return false;
+}
+
+void VertexArrays::releaseGeometry(uint64_t geometryId)
+{
+  auto found = _bindings.find(geometryId);
+  if(found == _bindings.end()) return;
+
+  for(auto &binding : found->second) {
+    if(binding.handle == _current) bind(0);
+    _fx->glDeleteVertexArrays(1, &binding.handle);
+  }
+  _bindings.erase(found);
+}
+
+void VertexArrays::releaseProgram(unsigned programId)
+{
+  for(auto &entry : _bindings) {
+    auto &bindings = entry.second;
+
+    for(auto it = bindings.begin(); it != bindings.end(); ) {
+      if(it->programId == programId) {
+        if(it->handle == _current) bind(0);
+        _fx->glDeleteVertexArrays(1, &it->handle);
+        it = bindings.erase(it);
+      }
+      else it++;
+    }
+  }
+}
+
+size_t VertexArrays::size() const
+{
+  size_t count = 0;
+  for(const auto &entry : _bindings) count += entry.second.size();
+  return count;
+}
+
+}
+}
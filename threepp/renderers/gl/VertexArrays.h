@@ -0,0 +1,103 @@
+//
+// Created by byter on 23.10.26.
+//
+
+#ifndef THREEPP_VERTEXARRAYS_H
+#define THREEPP_VERTEXARRAYS_H
+
+#include <vector>
+#include <unordered_map>
+#include <QOpenGLExtraFunctions>
+#include <threepp/core/BufferGeometry.h>
+#include "Attributes.h"
+#include "State.h"
+
+namespace three {
+
+class InstancedMesh;
+
+namespace gl {
+
+class Program;
+
+/**
+ * caches one vertex array object per geometry and program, so that drawing a geometry again
+ * only needs to bind its vertex array instead of setting up each attribute.
+ *
+ * A vertex array stays valid as long as the geometry references the same attributes and none
+ * of the attribute buffers was deleted. Content updates keep the buffer, so they don't affect it.
+ * The element array binding is part of the vertex array but is refreshed by the renderer
+ * whenever a vertex array is bound, since index uploads may happen while another one is bound.
+ *
+ * The vertex attribute state tracked by State belongs to the default vertex array. It is put
+ * aside while a cached vertex array is bound, and restored by unbind().
+ */
+class VertexArrays
+{
+  struct Binding
+  {
+    GLuint handle;
+    unsigned programId;
+    bool wireframe;
+
+    //instanced meshes bring their own attributes, so they don't share vertex arrays
+    uint64_t objectId;
+
+    //the attributes recorded in the vertex array, in the order of the program's attributes
+    std::vector<const BufferAttribute *> attributes;
+    size_t deletions;
+  };
+
+  QOpenGLExtraFunctions * const _fx;
+  State &_state;
+  Attributes &_attributes;
+
+  std::unordered_map<uint64_t, std::vector<Binding>> _bindings;
+
+  GLuint _current = 0;
+
+  //tracked attribute state of the default vertex array, while a cached one is bound
+  std::vector<GLuint> _defaultEnabled, _defaultDivisors;
+
+  std::vector<const BufferAttribute *> _used;
+
+  void collect(BufferGeometry &geometry, Program &program, InstancedMesh *instanced);
+
+  void bind(GLuint handle);
+
+public:
+  VertexArrays(QOpenGLExtraFunctions *fx, State &state, Attributes &attributes)
+     : _fx(fx), _state(state), _attributes(attributes) {}
+
+  /**
+   * bind the vertex array for a geometry drawn with a program
+   *
+   * @param geometry the buffer geometry
+   * @param source the geometry set on the object, which geometry was created from
+   * @return true if the vertex array is complete. Otherwise, a new vertex array was bound
+   * and the attributes must be set up
+   */
+  bool bind(BufferGeometry &geometry, Geometry &source, Program &program, bool wireframe, InstancedMesh *instanced);
+
+  /**
+   * bind the default vertex array
+   */
+  void unbind()
+  {
+    if(_current) bind(0);
+  }
+
+  void releaseGeometry(uint64_t geometryId);
+
+  void releaseProgram(unsigned programId);
+
+  /**
+   * @return the number of cached vertex arrays
+   */
+  size_t size() const;
+};
+
+}
+}
+
+#endif //THREEPP_VERTEXARRAYS_H
@@ -1,2 +1,8 @@
 
 vec3 transformed = vec3( position );
+
+#ifdef QUANTIZED_POSITION
+
+	transformed = positionOffset + positionScale * transformed;
+
+#endif
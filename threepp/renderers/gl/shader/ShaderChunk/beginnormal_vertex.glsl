@@ -1,2 +1,10 @@
 
-vec3 objectNormal = vec3( normal );
+#ifdef QUANTIZED_NORMAL
+
+	vec3 objectNormal = octDecode( normal.xy );
+
+#else
+
+	vec3 objectNormal = vec3( normal );
+
+#endif
@@ -1,3 +1,16 @@
+#ifdef USE_INSTANCING
+
+	// this is in lieu of a per-instance normal-matrix
+	// shear transforms in the instance matrix are not supported
+
+	mat3 m = mat3( instanceMatrix );
+
+	objectNormal /= vec3( dot( m[ 0 ], m[ 0 ] ), dot( m[ 1 ], m[ 1 ] ), dot( m[ 2 ], m[ 2 ] ) );
+
+	objectNormal = m * objectNormal;
+
+#endif
+
 vec3 transformedNormal = normalMatrix * objectNormal;
 
 #ifdef FLIP_SIDED
@@ -1,5 +1,15 @@
 #ifdef USE_DISPLACEMENTMAP
 
-	transformed += normalize( objectNormal ) * ( texture2D( displacementMap, uv ).x * displacementScale + displacementBias );
+	#ifdef QUANTIZED_UV
+
+		vec2 displacementUv = uvRange.xy + uvRange.zw * uv;
+
+	#else
+
+		vec2 displacementUv = uv;
+
+	#endif
+
+	transformed += normalize( objectNormal ) * ( texture2D( displacementMap, displacementUv ).x * displacementScale + displacementBias );
 
 #endif
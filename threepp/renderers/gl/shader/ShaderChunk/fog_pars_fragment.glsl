@@ -1,16 +1,21 @@
 #ifdef USE_FOG
 
-	uniform vec3 fogColor;
 	varying float fogDepth;
 
-	#ifdef FOG_EXP2
+	#ifndef USE_UNIFORM_BLOCKS
 
-		uniform float fogDensity;
+		uniform vec3 fogColor;
 
-	#else
+		#ifdef FOG_EXP2
 
-		uniform float fogNear;
-		uniform float fogFar;
+			uniform float fogDensity;
+
+		#else
+
+			uniform float fogNear;
+			uniform float fogFar;
+
+		#endif
 
 	#endif
 
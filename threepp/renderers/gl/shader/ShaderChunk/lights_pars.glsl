@@ -26,7 +26,9 @@ vec3 getAmbientLightIrradiance( const in vec3 ambientLightColor ) {
 		vec2 shadowMapSize;
 	};
 
-	uniform DirectionalLight directionalLights[ NUM_DIR_LIGHTS ];
+	#ifndef USE_UNIFORM_BLOCKS
+		uniform DirectionalLight directionalLights[ NUM_DIR_LIGHTS ];
+	#endif
 
 	void getDirectionalDirectLightIrradiance( const in DirectionalLight directionalLight, const in GeometricContext geometry, out IncidentLight directLight ) {
 
@@ -55,7 +57,9 @@ vec3 getAmbientLightIrradiance( const in vec3 ambientLightColor ) {
 		float shadowCameraFar;
 	};
 
-	uniform PointLight pointLights[ NUM_POINT_LIGHTS ];
+	#ifndef USE_UNIFORM_BLOCKS
+		uniform PointLight pointLights[ NUM_POINT_LIGHTS ];
+	#endif
 
 	// directLight is an out parameter as having it as a return value caused compiler errors on some devices
 	void getPointDirectLightIrradiance( const in PointLight pointLight, const in GeometricContext geometry, out IncidentLight directLight ) {
@@ -91,7 +95,9 @@ vec3 getAmbientLightIrradiance( const in vec3 ambientLightColor ) {
 		vec2 shadowMapSize;
 	};
 
-	uniform SpotLight spotLights[ NUM_SPOT_LIGHTS ];
+	#ifndef USE_UNIFORM_BLOCKS
+		uniform SpotLight spotLights[ NUM_SPOT_LIGHTS ];
+	#endif
 
 	// directLight is an out parameter as having it as a return value caused compiler errors on some devices
 	void getSpotDirectLightIrradiance( const in SpotLight spotLight, const in GeometricContext geometry, out IncidentLight directLight  ) {
@@ -135,7 +141,9 @@ vec3 getAmbientLightIrradiance( const in vec3 ambientLightColor ) {
 	uniform sampler2D ltcMat; // RGBA Float
 	uniform sampler2D ltcMag; // Alpha Float (only has w component)
 
-	uniform RectAreaLight rectAreaLights[ NUM_RECT_AREA_LIGHTS ];
+	#ifndef USE_UNIFORM_BLOCKS
+		uniform RectAreaLight rectAreaLights[ NUM_RECT_AREA_LIGHTS ];
+	#endif
 
 #endif
 
@@ -148,7 +156,9 @@ vec3 getAmbientLightIrradiance( const in vec3 ambientLightColor ) {
 		vec3 groundColor;
 	};
 
-	uniform HemisphereLight hemisphereLights[ NUM_HEMI_LIGHTS ];
+	#ifndef USE_UNIFORM_BLOCKS
+		uniform HemisphereLight hemisphereLights[ NUM_HEMI_LIGHTS ];
+	#endif
 
 	vec3 getHemisphereLightIrradiance( const in HemisphereLight hemiLight, const in GeometricContext geometry ) {
 
@@ -170,6 +180,36 @@ vec3 getAmbientLightIrradiance( const in vec3 ambientLightColor ) {
 #endif
 
 
+#if defined( USE_UNIFORM_BLOCKS ) && ( NUM_DIR_LIGHTS > 0 || NUM_POINT_LIGHTS > 0 || NUM_SPOT_LIGHTS > 0 || NUM_RECT_AREA_LIGHTS > 0 || NUM_HEMI_LIGHTS > 0 )
+
+	// shared by all programs, see UniformBlocks.cpp for the buffer layout
+	layout(std140) uniform Lights {
+
+		#if NUM_DIR_LIGHTS > 0
+			DirectionalLight directionalLights[ NUM_DIR_LIGHTS ];
+		#endif
+
+		#if NUM_POINT_LIGHTS > 0
+			PointLight pointLights[ NUM_POINT_LIGHTS ];
+		#endif
+
+		#if NUM_SPOT_LIGHTS > 0
+			SpotLight spotLights[ NUM_SPOT_LIGHTS ];
+		#endif
+
+		#if NUM_RECT_AREA_LIGHTS > 0
+			RectAreaLight rectAreaLights[ NUM_RECT_AREA_LIGHTS ];
+		#endif
+
+		#if NUM_HEMI_LIGHTS > 0
+			HemisphereLight hemisphereLights[ NUM_HEMI_LIGHTS ];
+		#endif
+
+	};
+
+#endif
+
+
 #if defined( USE_ENVMAP ) && defined( PHYSICAL )
 
 	vec3 getLightProbeIndirectIrradiance( /*const in SpecularLightProbe specularLightProbe,*/ const in GeometricContext geometry, const in int maxMIPLevel ) {
@@ -5,6 +5,9 @@
 		uniform sampler2D directionalShadowMap[ NUM_DIR_LIGHTS ];
 		varying vec4 vDirectionalShadowCoord[ NUM_DIR_LIGHTS ];
 
+		// per cascade offset.xy and scale.zw from the shadow coordinate to the cascade's tile
+		uniform mat4 directionalShadowCascades[ NUM_DIR_LIGHTS ];
+
 	#endif
 
 	#if NUM_SPOT_LIGHTS > 0
@@ -130,6 +133,38 @@
 
 	}
 
+	// getCascadedShadow() looks up directional light shadows, which may be split into cascades.
+	// The shadow map holds one tile per cascade, laid out left to right, bottom to top. Each
+	// fragment uses the first (smallest) cascade which contains it, keeping a margin for filtering
+
+	float getCascadedShadow( sampler2D shadowMap, vec2 shadowMapSize, float shadowBias, float shadowRadius, vec4 shadowCoord, mat4 cascades ) {
+
+		shadowCoord.xyz /= shadowCoord.w;
+
+		float count = dot( vec4( greaterThan( vec4( cascades[ 0 ].z, cascades[ 1 ].z, cascades[ 2 ].z, cascades[ 3 ].z ), vec4( 0.0 ) ) ), vec4( 1.0 ) );
+		vec2 tiles = vec2( count > 1.0 ? 2.0 : 1.0, count > 2.0 ? 2.0 : 1.0 );
+		vec2 margin = count > 1.0 ? ( shadowRadius + 1.5 ) / shadowMapSize : vec2( 0.0 );
+
+		for ( int i = 0; i < 4; i ++ ) {
+
+			vec4 cascade = cascades[ i ];
+			if ( cascade.z <= 0.0 ) break;
+
+			vec2 uv = ( shadowCoord.xy - cascade.xy ) * cascade.zw;
+
+			if ( all( greaterThanEqual( uv, margin ) ) && all( lessThanEqual( uv, vec2( 1.0 ) - margin ) ) ) {
+
+				vec2 tile = vec2( mod( float( i ), tiles.x ), floor( float( i ) / tiles.x ) );
+				return getShadow( shadowMap, shadowMapSize * tiles, shadowBias, shadowRadius, vec4( ( tile + uv ) / tiles, shadowCoord.z, 1.0 ) );
+
+			}
+
+		}
+
+		return 1.0;
+
+	}
+
 	// cubeToUV() maps a 3D direction vector suitable for cube texture mapping to a 2D
 	// vector suitable for 2D texture mapping. This code uses the following layout for the
 	// 2D texture:
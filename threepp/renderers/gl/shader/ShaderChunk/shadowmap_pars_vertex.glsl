@@ -2,25 +2,52 @@
 
 	#if NUM_DIR_LIGHTS > 0
 
-		uniform mat4 directionalShadowMatrix[ NUM_DIR_LIGHTS ];
+		#ifndef USE_UNIFORM_BLOCKS
+			uniform mat4 directionalShadowMatrix[ NUM_DIR_LIGHTS ];
+		#endif
 		varying vec4 vDirectionalShadowCoord[ NUM_DIR_LIGHTS ];
 
 	#endif
 
 	#if NUM_SPOT_LIGHTS > 0
 
-		uniform mat4 spotShadowMatrix[ NUM_SPOT_LIGHTS ];
+		#ifndef USE_UNIFORM_BLOCKS
+			uniform mat4 spotShadowMatrix[ NUM_SPOT_LIGHTS ];
+		#endif
 		varying vec4 vSpotShadowCoord[ NUM_SPOT_LIGHTS ];
 
 	#endif
 
 	#if NUM_POINT_LIGHTS > 0
 
-		uniform mat4 pointShadowMatrix[ NUM_POINT_LIGHTS ];
+		#ifndef USE_UNIFORM_BLOCKS
+			uniform mat4 pointShadowMatrix[ NUM_POINT_LIGHTS ];
+		#endif
 		varying vec4 vPointShadowCoord[ NUM_POINT_LIGHTS ];
 
 	#endif
 
+	#if defined( USE_UNIFORM_BLOCKS ) && ( NUM_DIR_LIGHTS > 0 || NUM_SPOT_LIGHTS > 0 || NUM_POINT_LIGHTS > 0 )
+
+		// shared by all programs, see UniformBlocks.cpp for the buffer layout
+		layout(std140) uniform Shadows {
+
+			#if NUM_DIR_LIGHTS > 0
+				mat4 directionalShadowMatrix[ NUM_DIR_LIGHTS ];
+			#endif
+
+			#if NUM_SPOT_LIGHTS > 0
+				mat4 spotShadowMatrix[ NUM_SPOT_LIGHTS ];
+			#endif
+
+			#if NUM_POINT_LIGHTS > 0
+				mat4 pointShadowMatrix[ NUM_POINT_LIGHTS ];
+			#endif
+
+		};
+
+	#endif
+
 	/*
 	#if NUM_RECT_AREA_LIGHTS > 0
 
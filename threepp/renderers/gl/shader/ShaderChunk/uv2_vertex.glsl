@@ -1,5 +1,13 @@
 #if defined( USE_LIGHTMAP ) || defined( USE_AOMAP )
 
-	vUv2 = uv2;
+	#ifdef QUANTIZED_UV2
+
+		vUv2 = uv2Range.xy + uv2Range.zw * uv2;
+
+	#else
+
+		vUv2 = uv2;
+
+	#endif
 
 #endif
\ No newline at end of file
@@ -1,5 +1,13 @@
 #if defined( USE_MAP ) || defined( USE_BUMPMAP ) || defined( USE_NORMALMAP ) || defined( USE_SPECULARMAP ) || defined( USE_ALPHAMAP ) || defined( USE_EMISSIVEMAP ) || defined( USE_ROUGHNESSMAP ) || defined( USE_METALNESSMAP )
 
-	vUv = ( uvTransform * vec3( uv, 1 ) ).xy;
+	#ifdef QUANTIZED_UV
+
+		vUv = ( uvTransform * vec3( uvRange.xy + uvRange.zw * uv, 1 ) ).xy;
+
+	#else
+
+		vUv = ( uvTransform * vec3( uv, 1 ) ).xy;
+
+	#endif
 
 #endif
\ No newline at end of file
@@ -15,8 +15,8 @@ void main() {
 
 	vLineDistance = scale * lineDistance;
 
-	vec4 mvPosition = modelViewMatrix * vec4( position, 1.0 );
-	gl_Position = projectionMatrix * mvPosition;
+	#include <begin_vertex>
+	#include <project_vertex>
 
 	#include <logdepthbuf_vertex>
 	#include <clipping_planes_vertex>
@@ -186,6 +186,7 @@ public:
 
                          value<std::vector<Texture::Ptr>>(UniformName::directionalShadowMap, std::vector<Texture::Ptr>()),
                          value<std::vector<math::Matrix4>>(UniformName::directionalShadowMatrix, std::vector<math::Matrix4>()),
+                         value<std::vector<math::Matrix4>>(UniformName::directionalShadowCascades, std::vector<math::Matrix4>()),
 
                          value<CachedSpotLights>(UniformName::spotLights, CachedSpotLights(), {
                             value<Color>(UniformName::color, Color::null()),
@@ -6,4 +6,40 @@
 
 namespace three {
 
+void Scene::setSpatialIndex(bool enable)
+{
+  if(enable == (bool)_spatialIndex) return;
+
+  if(enable) {
+    _spatialIndex = std::make_shared<SceneIndex>();
+    _sceneIndex = _spatialIndex.get();
+
+    for(const auto &child : _children) _spatialIndex->add(child);
+  }
+  else {
+    for(const auto &child : _children) _spatialIndex->remove(*child);
+
+    _sceneIndex = nullptr;
+    _spatialIndex.reset();
+  }
+}
+
+void Scene::setTransformSystem(bool enable)
+{
+  if(enable == (bool)_transformSystem) return;
+
+  if(enable)
+    _transformSystem = std::make_shared<TransformSystem>(*this);
+  else
+    _transformSystem.reset();
+}
+
+void Scene::updateMatrixWorld(bool force)
+{
+  if(_transformSystem)
+    _transformSystem->update(force);
+  else
+    Object3D::updateMatrixWorld(force);
+}
+
 }
\ No newline at end of file
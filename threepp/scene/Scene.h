@@ -9,6 +9,8 @@
 #include <threepp/core/Color.h>
 #include <threepp/util/Resolver.h>
 #include "Fog.h"
+#include "SceneIndex.h"
+#include "TransformSystem.h"
 
 namespace three {
 
@@ -20,6 +22,9 @@ class Scene : public Object3D
   Fog::Ptr _fog;
   bool _autoUpdate;
 
+  SceneIndex::Ptr _spatialIndex;
+  TransformSystem::Ptr _transformSystem;
+
 protected:
   Scene(const Fog::Ptr fog)
      : Object3D(), _fog(fog), _autoUpdate(true) {}
@@ -57,6 +62,25 @@ public:
   Fog::Ptr &fog() {return _fog;}
 
   bool autoUpdate() const {return _autoUpdate;}
+
+  /**
+   * enable or disable the spatial index. If enabled, the renderer and the shadow map use the index for
+   * frustum culling instead of traversing the scene graph. This pays off for large scenes where
+   * only a fraction of the objects is visible at a time
+   */
+  void setSpatialIndex(bool enable);
+
+  SceneIndex *spatialIndex() const {return _spatialIndex.get();}
+
+  /**
+   * enable or disable the transform system. If enabled, updateMatrixWorld() computes the world matrices
+   * from contiguous arrays, in parallel per hierarchy level. This pays off for graphs with many thousand nodes
+   */
+  void setTransformSystem(bool enable);
+
+  TransformSystem *transformSystem() const {return _transformSystem.get();}
+
+  void updateMatrixWorld(bool force) override;
 };
 
 /**
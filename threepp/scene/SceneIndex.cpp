@@ -0,0 +1,305 @@
+//
+// Created by byter on 20.10.26.
+//
+
+#include "SceneIndex.h"
+#include <threepp/objects/Mesh.h>
+#include <threepp/objects/Line.h>
+#include <threepp/objects/Points.h>
+#include <threepp/objects/Sprite.h>
+#include <threepp/objects/LensFlare.h>
+#include <threepp/objects/ImmediateRenderObject.h>
+#include <threepp/light/Light.h>
+
+namespace three {
+
+using namespace math;
+
+namespace {
+
+//leaf boxes are enlarged by this fraction of the bounding sphere radius
+const float FAT_FACTOR = 0.25f;
+
+float area(const Box3 &box)
+{
+  Vector3 size = box.getSize();
+  return 2.0f * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
+}
+
+Box3 combine(const Box3 &a, const Box3 &b)
+{
+  Box3 box(a);
+  return box.unify(b);
+}
+
+Sphere worldSphere(Object3D &object)
+{
+  if (object.geometry()->boundingSphere().isEmpty())
+    object.geometry()->computeBoundingSphere();
+
+  Sphere sphere = object.geometry()->boundingSphere();
+  sphere.apply(object.matrixWorld());
+
+  return sphere;
+}
+
+Box3 sphereBox(const Sphere &sphere, float margin)
+{
+  float r = sphere.radius() + margin;
+  return Box3(sphere.center() - r, sphere.center() + r);
+}
+
+}
+
+SceneIndex::~SceneIndex()
+{
+  for(auto &node : _nodes) {
+    if(node.object) node.object->_sceneIndex = nullptr;
+  }
+  for(auto &object : _unculled) {
+    object->_sceneIndex = nullptr;
+  }
+}
+
+int32_t SceneIndex::allocateNode()
+{
+  if(_freeList < 0) {
+    _nodes.emplace_back();
+    return (int32_t)_nodes.size() - 1;
+  }
+  int32_t node = _freeList;
+  _freeList = _nodes[node].parent;
+  _nodes[node] = Node();
+  return node;
+}
+
+void SceneIndex::freeNode(int32_t node)
+{
+  _nodes[node].object.reset();
+  _nodes[node].parent = _freeList;
+  _freeList = node;
+}
+
+void SceneIndex::insertLeaf(int32_t leaf)
+{
+  _leafCount++;
+
+  if(_root < 0) {
+    _root = leaf;
+    _nodes[leaf].parent = -1;
+    return;
+  }
+
+  //descend to the sibling which causes the least increase in surface area
+  const Box3 box = _nodes[leaf].box;
+  int32_t index = _root;
+
+  while(!_nodes[index].isLeaf()) {
+    const Node &node = _nodes[index];
+
+    float nodeArea = area(node.box);
+    float combinedArea = area(combine(node.box, box));
+
+    //cost of creating a new parent for this node and the leaf
+    float cost = 2.0f * combinedArea;
+
+    //minimum cost of pushing the leaf further down the tree
+    float inheritance = 2.0f * (combinedArea - nodeArea);
+
+    auto descendCost = [&](int32_t child) {
+      const Node &c = _nodes[child];
+      float a = area(combine(c.box, box));
+      return (c.isLeaf() ? a : a - area(c.box)) + inheritance;
+    };
+    float costLeft = descendCost(node.left);
+    float costRight = descendCost(node.right);
+
+    if(cost < costLeft && cost < costRight) break;
+
+    index = costLeft < costRight ? node.left : node.right;
+  }
+
+  int32_t sibling = index;
+  int32_t oldParent = _nodes[sibling].parent;
+  int32_t newParent = allocateNode();
+
+  _nodes[newParent].parent = oldParent;
+  _nodes[newParent].box = combine(box, _nodes[sibling].box);
+  _nodes[newParent].left = sibling;
+  _nodes[newParent].right = leaf;
+  _nodes[sibling].parent = newParent;
+  _nodes[leaf].parent = newParent;
+
+  if(oldParent >= 0) {
+    if(_nodes[oldParent].left == sibling) _nodes[oldParent].left = newParent;
+    else _nodes[oldParent].right = newParent;
+  }
+  else {
+    _root = newParent;
+  }
+
+  //refit ancestors
+  for(int32_t i = _nodes[leaf].parent; i >= 0; i = _nodes[i].parent) {
+    _nodes[i].box = combine(_nodes[_nodes[i].left].box, _nodes[_nodes[i].right].box);
+  }
+}
+
+void SceneIndex::removeLeaf(int32_t leaf)
+{
+  _leafCount--;
+
+  if(leaf == _root) {
+    _root = -1;
+    return;
+  }
+
+  int32_t parent = _nodes[leaf].parent;
+  int32_t grandParent = _nodes[parent].parent;
+  int32_t sibling = _nodes[parent].left == leaf ? _nodes[parent].right : _nodes[parent].left;
+
+  if(grandParent >= 0) {
+    if(_nodes[grandParent].left == parent) _nodes[grandParent].left = sibling;
+    else _nodes[grandParent].right = sibling;
+    _nodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    for(int32_t i = grandParent; i >= 0; i = _nodes[i].parent) {
+      _nodes[i].box = combine(_nodes[_nodes[i].left].box, _nodes[_nodes[i].right].box);
+    }
+  }
+  else {
+    _root = sibling;
+    _nodes[sibling].parent = -1;
+    freeNode(parent);
+  }
+}
+
+bool SceneIndex::culled(Object3D &object)
+{
+  return object.frustumCulled && object.geometry()
+         && (object.is<Mesh>() || object.is<Line>() || object.is<Points>());
+}
+
+void SceneIndex::place(const Object3D::Ptr &object)
+{
+  if(culled(*object)) {
+    int32_t leaf = allocateNode();
+    Node &node = _nodes[leaf];
+    node.object = object;
+    node.sphere = worldSphere(*object);
+    node.box = sphereBox(node.sphere, node.sphere.radius() * FAT_FACTOR);
+
+    object->_sceneSlot = leaf;
+    object->_sceneCulled = true;
+    insertLeaf(leaf);
+  }
+  else if(object->is<Mesh>() || object->is<Line>() || object->is<Points>() || object->is<Light>()
+          || object->is<Sprite>() || object->is<LensFlare>() || object->is<ImmediateRenderObject>()) {
+
+    object->_sceneSlot = (int32_t)_unculled.size();
+    object->_sceneCulled = false;
+    _unculled.push_back(object);
+  }
+}
+
+void SceneIndex::unplace(Object3D &object)
+{
+  if(object._sceneSlot < 0) return;
+
+  if(object._sceneCulled) {
+    removeLeaf(object._sceneSlot);
+    freeNode(object._sceneSlot);
+  }
+  else {
+    //swap-remove
+    _unculled[object._sceneSlot] = _unculled.back();
+    _unculled[object._sceneSlot]->_sceneSlot = object._sceneSlot;
+    _unculled.pop_back();
+  }
+  object._sceneSlot = -1;
+}
+
+void SceneIndex::add(const Object3D::Ptr &object)
+{
+  object->_sceneIndex = this;
+  place(object);
+
+  for(const auto &child : object->children()) add(child);
+}
+
+void SceneIndex::remove(Object3D &object)
+{
+  for(const auto &child : object.children()) remove(*child);
+
+  unplace(object);
+
+  unmoved(object);
+  object._sceneIndex = nullptr;
+}
+
+void SceneIndex::moved(Object3D &object)
+{
+  if(object._sceneMoved >= 0 || object._sceneSlot < 0 || !object._sceneCulled) return;
+
+  object._sceneMoved = (int32_t)_moved.size();
+  _moved.push_back(&object);
+}
+
+void SceneIndex::unmoved(Object3D &object)
+{
+  if(object._sceneMoved < 0) return;
+
+  //swap-remove
+  _moved[object._sceneMoved] = _moved.back();
+  _moved[object._sceneMoved]->_sceneMoved = object._sceneMoved;
+  _moved.pop_back();
+
+  object._sceneMoved = -1;
+}
+
+void SceneIndex::refit(Object3D &object)
+{
+  Node &node = _nodes[object._sceneSlot];
+  node.sphere = worldSphere(object);
+
+  Box3 box = sphereBox(node.sphere, 0);
+  if(node.box.containsBox(box)) return;
+
+  int32_t leaf = object._sceneSlot;
+  removeLeaf(leaf);
+  _nodes[leaf].box = sphereBox(_nodes[leaf].sphere, _nodes[leaf].sphere.radius() * FAT_FACTOR);
+  insertLeaf(leaf);
+}
+
+void SceneIndex::refresh()
+{
+  for(Object3D *object : _moved) {
+    object->_sceneMoved = -1;
+    refit(*object);
+  }
+  _moved.clear();
+}
+
+void SceneIndex::update(Object3D &object)
+{
+  if(object._sceneIndex != this) return;
+
+  unmoved(object);
+
+  //find the shared pointer, either in the index or in the parent
+  Object3D::Ptr ptr;
+  if(object._sceneSlot >= 0) {
+    ptr = object._sceneCulled ? _nodes[object._sceneSlot].object : _unculled[object._sceneSlot];
+  }
+  else if(object.parent()) {
+    for(const auto &child : object.parent()->children()) {
+      if(child.get() == &object) ptr = child;
+    }
+  }
+  if(!ptr) return;
+
+  unplace(object);
+  place(ptr);
+}
+
+}
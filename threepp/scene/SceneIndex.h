@@ -0,0 +1,152 @@
+//
+// Created by byter on 20.10.26.
+//
+
+#ifndef THREEPP_SCENEINDEX_H
+#define THREEPP_SCENEINDEX_H
+
+#include <vector>
+#include <cstdint>
+#include <threepp/util/osdecl.h>
+#include <threepp/core/Object3D.h>
+#include <threepp/math/Box3.h>
+#include <threepp/math/Sphere.h>
+#include <threepp/math/Frustum.h>
+
+namespace three {
+
+/**
+ * spatial index for frustum culling. Frustum-culled meshes, lines and points are kept in a dynamic
+ * AABB tree over their world-space bounding spheres. The leaf boxes are enlarged so that small
+ * movements don't require reinsertion. Lights, sprites, lens flares, immediate render objects and
+ * objects with frustumCulled == false are kept in a plain list.
+ *
+ * The index is maintained incrementally: objects are registered when they are added to the scene
+ * graph, unregistered when removed and re-fitted when their world matrix changes. Changes that
+ * don't move the object (e.g. replacing or modifying its geometry, or toggling frustumCulled) must
+ * be announced through update().
+ */
+class DLX SceneIndex
+{
+  friend class Object3D;
+  friend class Scene;
+  friend class TransformSystem;
+
+  struct Node
+  {
+    //leaves: enlarged bounds
+    math::Box3 box;
+
+    //leaves: exact world bounds
+    math::Sphere sphere;
+
+    //parent node, next free node for nodes on the free list
+    int32_t parent = -1;
+
+    //children, -1 for leaves
+    int32_t left = -1, right = -1;
+
+    Object3D::Ptr object;
+
+    bool isLeaf() const {return left < 0;}
+  };
+
+  std::vector<Node> _nodes;
+  int32_t _root = -1;
+  int32_t _freeList = -1;
+  size_t _leafCount = 0;
+
+  std::vector<Object3D::Ptr> _unculled;
+  std::vector<Object3D *> _moved;
+
+  //reused traversal stack
+  std::vector<int32_t> _stack;
+
+  int32_t allocateNode();
+  void freeNode(int32_t node);
+
+  void insertLeaf(int32_t leaf);
+  void removeLeaf(int32_t leaf);
+
+  void add(const Object3D::Ptr &object);
+  void remove(Object3D &object);
+  void place(const Object3D::Ptr &object);
+  void unplace(Object3D &object);
+
+  void moved(Object3D &object);
+  void unmoved(Object3D &object);
+  void refit(Object3D &object);
+
+  static bool culled(Object3D &object);
+
+public:
+  SceneIndex() = default;
+  SceneIndex(const SceneIndex &) = delete;
+
+  ~SceneIndex();
+
+  using Ptr = std::shared_ptr<SceneIndex>;
+
+  /**
+   * re-evaluate the bounds and the culling status of an object after changes which did not move it
+   */
+  void update(Object3D &object);
+
+  /**
+   * re-fit all objects that moved since the last call. Called by cull()
+   */
+  void refresh();
+
+  /**
+   * @return the number of objects in the tree
+   */
+  size_t size() const {return _leafCount;}
+
+  /**
+   * @return the objects which are not subject to frustum culling
+   */
+  const std::vector<Object3D::Ptr> &unculled() const {return _unculled;}
+
+  /**
+   * @return true if the object and all its ancestors are visible
+   */
+  static bool visibleInScene(const Object3D &object)
+  {
+    for(const Object3D *o = &object; o; o = o->parent()) {
+      if(!o->visible()) return false;
+    }
+    return true;
+  }
+
+  /**
+   * visit all tree objects whose world bounding sphere intersects the frustum. The leaf test is the
+   * same as Frustum::intersectsObject
+   */
+  template <typename Visit>
+  void cull(const math::Frustum &frustum, Visit visit)
+  {
+    refresh();
+
+    if(_root < 0) return;
+
+    _stack.clear();
+    _stack.push_back(_root);
+
+    while(!_stack.empty()) {
+      const Node &node = _nodes[_stack.back()];
+      _stack.pop_back();
+
+      if(node.isLeaf()) {
+        if(frustum.intersectsSphere(node.sphere)) visit(node.object);
+      }
+      else if(frustum.intersectsBox(node.box)) {
+        _stack.push_back(node.right);
+        _stack.push_back(node.left);
+      }
+    }
+  }
+};
+
+}
+
+#endif //THREEPP_SCENEINDEX_H
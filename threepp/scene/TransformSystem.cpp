@@ -0,0 +1,160 @@
+//
+// Created by byter on 21.10.26.
+//
+
+#include "TransformSystem.h"
+#include "SceneIndex.h"
+#include <atomic>
+
+namespace three {
+
+using namespace math;
+
+TransformSystem::TransformSystem(Object3D &root, ThreadPool &pool) : _root(root), _pool(pool)
+{
+}
+
+TransformSystem::~TransformSystem()
+{
+  //the node list may be stale, so go through the graph
+  _root.traverse([this](Object3D &node) {
+    if(node._transforms == this) detach(node);
+  });
+}
+
+void TransformSystem::detach(Object3D &object)
+{
+  //changes queued here must be found by the recursive update
+  object._matrixWorldNeedsUpdate = true;
+
+  object.traverse([](Object3D &node) {
+    node._transforms = nullptr;
+    node._transformSlot = -1;
+    node._descendantsNeedUpdate = true;
+  });
+}
+
+void TransformSystem::rebuild()
+{
+  _nodes.clear();
+  _parents.clear();
+  _levels.clear();
+
+  _nodes.push_back(&_root);
+  _parents.push_back(-1);
+
+  for(size_t begin = 0; begin < _nodes.size(); ) {
+    size_t end = _nodes.size();
+    _levels.push_back(begin);
+
+    for(size_t i = begin; i < end; i++) {
+      for(const auto &child : _nodes[i]->_children) {
+        _nodes.push_back(child.get());
+        _parents.push_back((int32_t)i);
+      }
+    }
+    begin = end;
+  }
+  _levels.push_back(_nodes.size());
+
+  size_t count = _nodes.size();
+  _local.resize(count);
+  _world.resize(count);
+  _dirty.assign(count, 1);
+  _moved.assign(count, 0);
+  _queue.resize(count);
+
+  for(size_t i = 0; i < count; i++) {
+    _nodes[i]->_transforms = this;
+    _nodes[i]->_transformSlot = (int32_t)i;
+    _queue[i] = (int32_t)i;
+  }
+
+  _valid = true;
+}
+
+void TransformSystem::update(bool force)
+{
+  if(!_valid) rebuild();
+
+  if(_queue.empty() && !force) return;
+
+  //local matrices
+  _pool.parallelFor(0, _queue.size(), grain, [this](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; i++) {
+      int32_t slot = _queue[i];
+      Object3D *node = _nodes[slot];
+
+      if(node->matrixAutoUpdate && node->_matrixNeedsUpdate) node->composeMatrix();
+      _local[slot] = node->_matrix;
+    }
+  });
+  _queue.clear();
+
+  //world matrices, top down. A node is dirty if its parent is
+  if(force || _dirty[0]) {
+    _dirty[0] = 1;
+
+    if(_root._parent)
+      _world[0].multiply(_root._parent->_matrixWorld, _local[0]);
+    else
+      _world[0] = _local[0];
+  }
+
+  for(size_t level = 1; level + 1 < _levels.size(); level++) {
+
+    _pool.parallelFor(_levels[level], _levels[level + 1], grain, [this, force](size_t begin, size_t end) {
+      for(size_t i = begin; i < end; i++) {
+        int32_t parent = _parents[i];
+
+        if(force || _dirty[parent]) _dirty[i] = 1;
+        if(_dirty[i]) _world[i].multiply(_world[parent], _local[i]);
+      }
+    });
+  }
+
+  //copy back
+  std::atomic<size_t> updates {0};
+  std::atomic<bool> moved {false};
+
+  _pool.parallelFor(0, _nodes.size(), grain, [this, &updates, &moved](size_t begin, size_t end) {
+    size_t count = 0;
+    bool anyMoved = false;
+
+    for(size_t i = begin; i < end; i++) {
+      if(!_dirty[i]) continue;
+
+      Object3D *node = _nodes[i];
+
+      if(node->_sceneIndex && node->_sceneSlot >= 0 && node->_sceneCulled && !(node->_matrixWorld == _world[i])) {
+        _moved[i] = 1;
+        anyMoved = true;
+      }
+
+      node->_matrixWorld = _world[i];
+      node->_matrixWorldNeedsUpdate = false;
+      node->_descendantsNeedUpdate = false;
+      node->matrixWorldChanged();
+
+      _dirty[i] = 0;
+      count++;
+    }
+
+    updates += count;
+    if(anyMoved) moved = true;
+  });
+
+  Object3D::__matrixWorldUpdates += updates;
+
+  //the spatial index is not thread safe
+  if(moved) {
+    for(size_t i = 0; i < _nodes.size(); i++) {
+      if(_moved[i]) {
+        _moved[i] = 0;
+        _nodes[i]->_sceneIndex->moved(*_nodes[i]);
+      }
+    }
+  }
+}
+
+}
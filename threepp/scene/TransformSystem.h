@@ -0,0 +1,104 @@
+//
+// Created by byter on 21.10.26.
+//
+
+#ifndef THREEPP_TRANSFORMSYSTEM_H
+#define THREEPP_TRANSFORMSYSTEM_H
+
+#include <vector>
+#include <cstdint>
+#include <threepp/util/osdecl.h>
+#include <threepp/util/ThreadPool.h>
+#include <threepp/core/Object3D.h>
+#include <threepp/math/Matrix4.h>
+
+namespace three {
+
+/**
+ * data-oriented world matrix computation for large scene graphs. The nodes below the root are kept
+ * in breadth-first order, together with contiguous arrays of parent indices, local and world
+ * matrices. Each object knows its slot in these arrays.
+ *
+ * An update composes the local matrices of the objects that changed since the last update, then
+ * computes the world matrices level by level, in parallel within each level, and finally copies
+ * the changed world matrices back to the objects. The order is rebuilt lazily after objects were
+ * added to or removed from the graph.
+ */
+class DLX TransformSystem
+{
+  friend class Object3D;
+
+  Object3D &_root;
+  ThreadPool &_pool;
+
+  //nodes in breadth-first order. The nodes of level l are [_levels[l], _levels[l+1])
+  std::vector<Object3D *> _nodes;
+  std::vector<int32_t> _parents;
+  std::vector<size_t> _levels;
+
+  std::vector<math::Matrix4> _local;
+  std::vector<math::Matrix4> _world;
+
+  //world matrix must be recomputed
+  std::vector<uint8_t> _dirty;
+
+  //world matrix of an object in the spatial index changed
+  std::vector<uint8_t> _moved;
+
+  //slots whose local matrix changed
+  std::vector<int32_t> _queue;
+
+  bool _valid = false;
+
+  void rebuild();
+
+  void invalidate() {_valid = false;}
+
+  void queue(int32_t slot)
+  {
+    if(!_valid || _dirty[slot]) return;
+
+    _dirty[slot] = 1;
+    _queue.push_back(slot);
+  }
+
+  void detach(Object3D &object);
+
+public:
+  using Ptr = std::shared_ptr<TransformSystem>;
+
+  /**
+   * minimum number of nodes per parallel work item
+   */
+  size_t grain = 2048;
+
+  explicit TransformSystem(Object3D &root, ThreadPool &pool=ThreadPool::instance());
+
+  TransformSystem(const TransformSystem &) = delete;
+
+  ~TransformSystem();
+
+  /**
+   * same as root.updateMatrixWorld(force)
+   */
+  void update(bool force);
+
+  /**
+   * @return the number of nodes, including the root. Only valid after update()
+   */
+  size_t size() const {return _nodes.size();}
+
+  /**
+   * @return the number of levels in the hierarchy. Only valid after update()
+   */
+  size_t depth() const {return _levels.empty() ? 0 : _levels.size() - 1;}
+
+  /**
+   * @return the world matrix of an object, see Object3D::transformSlot()
+   */
+  const math::Matrix4 &matrixWorld(int32_t slot) const {return _world[slot];}
+};
+
+}
+
+#endif //THREEPP_TRANSFORMSYSTEM_H
@@ -54,6 +54,8 @@ class LineSegments;
 class Points;
 class Mesh;
 class DynamicMesh;
+class InstancedMesh;
+class BatchedMesh;
 class SkinnedMesh;
 class Sprite;
 class ImmediateRenderObject;
@@ -62,7 +64,7 @@ class LensFlare;
 namespace object {
 using Typer = three::Typer<Camera, ArrayCamera, OrthographicCamera, PerspectiveCamera,
    Light, AmbientLight, DirectionalLight, HemisphereLight, PointLight, RectAreaLight, SpotLight, TargetLight,
-   Line, LineSegments, Mesh, DynamicMesh, Sprite, ImmediateRenderObject, Points, SkinnedMesh, LensFlare>;
+   Line, LineSegments, Mesh, DynamicMesh, InstancedMesh, BatchedMesh, Sprite, ImmediateRenderObject, Points, SkinnedMesh, LensFlare>;
 }
 
 class LinearGeometry;
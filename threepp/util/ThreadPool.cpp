@@ -0,0 +1,157 @@
+//
+// Created by byter on 21.10.26.
+//
+
+#include "ThreadPool.h"
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <exception>
+#include <QDebug>
+
+namespace three {
+
+using namespace std;
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+  if(!threads) {
+    unsigned hw = thread::hardware_concurrency();
+    threads = hw > 1 ? hw - 1 : 1;
+  }
+
+  for(unsigned i=0; i<threads; i++) {
+    _workers.emplace_back(&ThreadPool::work, this);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    lock_guard<mutex> lock(_mutex);
+    _stop = true;
+  }
+  _condition.notify_all();
+
+  for(auto &worker : _workers) worker.join();
+}
+
+ThreadPool &ThreadPool::instance()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+void ThreadPool::work()
+{
+  while(true) {
+    function<void()> task;
+    {
+      unique_lock<mutex> lock(_mutex);
+      _condition.wait(lock, [this] {return _stop || !_tasks.empty();});
+
+      if(_stop && _tasks.empty()) return;
+
+      task = move(_tasks.front());
+      _tasks.pop_front();
+    }
+    //an escaping exception would terminate the process
+    try {
+      task();
+    }
+    catch(std::exception &e) {
+      qCritical() << "thread pool task failed:" << e.what();
+    }
+    catch(...) {
+      qCritical() << "thread pool task failed";
+    }
+  }
+}
+
+void ThreadPool::submit(function<void()> task)
+{
+  {
+    lock_guard<mutex> lock(_mutex);
+    _tasks.push_back(move(task));
+  }
+  _condition.notify_one();
+}
+
+namespace {
+
+struct ParallelFor
+{
+  function<void(size_t, size_t)> fn;
+  size_t begin, end, grain, chunks;
+
+  atomic<size_t> next {0};
+  atomic<size_t> done {0};
+
+  mutex doneMutex;
+  condition_variable doneCondition;
+
+  //the first exception thrown by fn. Once set, remaining chunks are skipped
+  atomic<bool> failed {false};
+  exception_ptr error;
+
+  //process chunks until none are left
+  void run()
+  {
+    size_t chunk;
+    while((chunk = next.fetch_add(1)) < chunks) {
+      if(!failed.load()) {
+        size_t first = begin + chunk * grain;
+        try {
+          fn(first, min(first + grain, end));
+        }
+        catch(...) {
+          lock_guard<mutex> lock(doneMutex);
+          if(!error) error = current_exception();
+          failed = true;
+        }
+      }
+
+      //counted in any case, so the caller's wait ends
+      if(done.fetch_add(1) + 1 == chunks) {
+        lock_guard<mutex> lock(doneMutex);
+        doneCondition.notify_all();
+      }
+    }
+  }
+};
+
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain, const function<void(size_t, size_t)> &fn)
+{
+  if(end <= begin) return;
+  if(!grain) grain = 1;
+
+  size_t chunks = (end - begin + grain - 1) / grain;
+  if(chunks == 1 || _workers.empty()) {
+    fn(begin, end);
+    return;
+  }
+
+  //shared, so helpers that start late still find valid state
+  auto state = make_shared<ParallelFor>();
+  state->fn = fn;
+  state->begin = begin;
+  state->end = end;
+  state->grain = grain;
+  state->chunks = chunks;
+
+  size_t helpers = min<size_t>(_workers.size(), chunks - 1);
+  for(size_t i=0; i<helpers; i++) {
+    submit([state]() {state->run();});
+  }
+
+  state->run();
+
+  unique_lock<mutex> lock(state->doneMutex);
+  state->doneCondition.wait(lock, [&state] {return state->done.load() == state->chunks;});
+
+  if(state->error) rethrow_exception(state->error);
+}
+
+}
@@ -0,0 +1,65 @@
+//
+// Created by byter on 21.10.26.
+//
+
+#ifndef THREEPP_THREADPOOL_H
+#define THREEPP_THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <threepp/util/osdecl.h>
+
+namespace three {
+
+/**
+ * a fixed size pool of worker threads
+ */
+class DLX ThreadPool
+{
+  std::vector<std::thread> _workers;
+  std::deque<std::function<void()>> _tasks;
+
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  bool _stop = false;
+
+  void work();
+
+public:
+  /**
+   * @param threads the number of worker threads. 0 means one less than the number of hardware threads,
+   * as the calling thread takes part in parallelFor()
+   */
+  explicit ThreadPool(unsigned threads=0);
+
+  ThreadPool(const ThreadPool &) = delete;
+
+  ~ThreadPool();
+
+  /**
+   * @return the process-wide default pool
+   */
+  static ThreadPool &instance();
+
+  unsigned size() const {return (unsigned)_workers.size();}
+
+  /**
+   * run a task on one of the worker threads. Exceptions thrown by the task are logged and dropped
+   */
+  void submit(std::function<void()> task);
+
+  /**
+   * call fn(begin, end) for consecutive ranges of at most grain elements covering [begin, end) and wait until
+   * all ranges are processed. The calling thread processes ranges, too, so nested calls don't deadlock.
+   * If fn throws, the remaining ranges are skipped and the first exception is rethrown on the calling thread
+   */
+  void parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)> &fn);
+};
+
+}
+
+#endif //THREEPP_THREADPOOL_H
@@ -129,6 +129,10 @@ public:
   bool test(const Layers &layers) const {
     return (mask & layers.mask) != 0;
   }
+
+  bool operator == (const Layers &layers) const {
+    return mask == layers.mask;
+  }
 };
 
 struct Group {